@@ -7,9 +7,21 @@
 #include <QTimer>
 #include <QTcpSocket>
 #include <QJsonObject>
+#include <QMap>
+#include <QVector>
 
 // Simple NetworkTables-like communication using TCP/JSON
 // For production, integrate actual NetworkTables C++ library
+//
+// On connect the robot is asked for binary frames (hello). Once it acks,
+// poses and status arrive as fixed layout frames, optionally as pose deltas,
+// and paths are sent as packed waypoint arrays. Older robots ignore hello
+// and the link stays in JSON. The layout is described in the robot side
+// WireProtocol.h.
+//
+// Robot state is pushed on topic subscriptions (pose, status, lidarScan,
+// odometry) at the rates set with setSubscription. getState is only
+// polled until the robot acknowledges the subscription.
 
 class RobotComm : public QObject {
     Q_OBJECT
@@ -23,6 +35,15 @@ public:
     void disconnectFromRobot();
     bool isConnected() const;
 
+    // Binary frames, asked for on the next connection. Enabled by default.
+    void setBinaryProtocol(bool enabled, bool deltaPose = true);
+    bool isBinaryActive() const { return m_binaryActive; }
+
+    // Topic rate in Hz, 0 unsubscribes. Sent right away when connected.
+    // Defaults: pose 20 Hz, status 5 Hz.
+    void setSubscription(const QString& topic, double rateHz);
+    bool isSubscribed() const { return m_subscribed; }
+
     // Send path to robot
     bool sendPath(const PathData& path);
 
@@ -46,6 +67,8 @@ signals:
     void robotStatusUpdated(const QString& status);
     void pathExecutionStarted();
     void pathExecutionFinished(bool success);
+    void lidarScanUpdated(const QVector<float>& ranges);     // m, one per degree, 0 without a return
+    void odometryUpdated(const QJsonObject& diagnostics);
 
 private slots:
     void onConnected();
@@ -56,13 +79,23 @@ private slots:
 
 private:
     void parseIncomingData(const QByteArray& data);
+    void parseFrame(quint8 type, const QByteArray& payload);
     void sendJson(const QJsonObject& json);
+    void sendFrame(quint8 type, const QByteArray& payload);
+    void sendSubscription();
 
     QTcpSocket* m_socket;
     QTimer* m_updateTimer;
     Geometry::RobotPose m_currentPose;
     bool m_isMoving;
     QByteArray m_receiveBuffer;
+
+    bool m_binaryRequested;
+    bool m_deltaPoseRequested;
+    bool m_binaryActive;
+
+    QMap<QString, double> m_subscriptions;
+    bool m_subscribed;
 };
 
 #endif // ROBOTCOMM_H
@@ -2,12 +2,37 @@
 #include "MapData.h"
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QDataStream>
+#include <QtEndian>
+
+namespace {
+    // Binary frames, see WireProtocol.h on the robot
+    const quint8 FRAME_MAGIC = 0xB1;
+    const quint8 FRAME_VERSION = 1;
+    const int FRAME_HEADER_SIZE = 8;
+    const double POSE_DELTA_SCALE = 1e-4;  // m and rad per delta unit
+
+    enum FrameType : quint8 {
+        FramePose = 1,
+        FramePoseDelta = 2,
+        FrameStatus = 3,
+        FrameExecution = 4,
+        FramePath = 5,
+        FrameGetState = 6,
+        FrameJson = 7,
+        FrameLidarScan = 8
+    };
+}
 
 RobotComm::RobotComm(QObject* parent)
     : QObject(parent)
     , m_socket(new QTcpSocket(this))
     , m_updateTimer(new QTimer(this))
     , m_isMoving(false)
+    , m_binaryRequested(true)
+    , m_deltaPoseRequested(true)
+    , m_binaryActive(false)
+    , m_subscribed(false)
 {
     connect(m_socket, &QTcpSocket::connected, this, &RobotComm::onConnected);
     connect(m_socket, &QTcpSocket::disconnected, this, &RobotComm::onDisconnected);
@@ -15,9 +40,12 @@ RobotComm::RobotComm(QObject* parent)
     connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
             this, &RobotComm::onError);
 
-    // Request robot state periodically (20Hz)
+    // Request robot state periodically (20Hz), until the robot pushes it on subscription
     m_updateTimer->setInterval(50);
     connect(m_updateTimer, &QTimer::timeout, this, &RobotComm::requestRobotState);
+
+    m_subscriptions["pose"] = 20;
+    m_subscriptions["status"] = 5;
 }
 
 RobotComm::~RobotComm() {
@@ -48,11 +76,54 @@ bool RobotComm::isConnected() const {
     return m_socket->state() == QAbstractSocket::ConnectedState;
 }
 
+void RobotComm::setBinaryProtocol(bool enabled, bool deltaPose) {
+    m_binaryRequested = enabled;
+    m_deltaPoseRequested = deltaPose;
+}
+
+void RobotComm::setSubscription(const QString& topic, double rateHz) {
+    m_subscriptions[topic] = rateHz;
+    if (isConnected()) {
+        sendSubscription();
+    }
+}
+
+void RobotComm::sendSubscription() {
+    QJsonObject topics;
+    for (auto it = m_subscriptions.constBegin(); it != m_subscriptions.constEnd(); ++it) {
+        topics[it.key()] = it.value();
+    }
+
+    QJsonObject message;
+    message["type"] = "subscribe";
+    message["topics"] = topics;
+    sendJson(message);
+}
+
 bool RobotComm::sendPath(const PathData& path) {
     if (!isConnected()) {
         return false;
     }
 
+    if (m_binaryActive) {
+        // u16 name size, name, u32 count, count x f32 (x, y, heading, velocity)
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+        QByteArray name = path.name.toUtf8().left(0xFFFF);
+        stream << quint16(name.size());
+        stream.writeRawData(name.constData(), name.size());
+        stream << quint32(path.waypoints.size());
+        for (const auto& wp : path.waypoints) {
+            stream << float(wp.position.x) << float(wp.position.y) << float(wp.heading) << float(wp.velocity);
+        }
+
+        sendFrame(FramePath, payload);
+        return true;
+    }
+
     QJsonObject message;
     message["type"] = "sendPath";
     message["path"] = path.toJson();
@@ -137,12 +208,29 @@ bool RobotComm::sendCommand(const QString& command, const QJsonObject& data) {
 }
 
 void RobotComm::onConnected() {
+    m_binaryActive = false;
+    m_receiveBuffer.clear();
+
+    if (m_binaryRequested) {
+        QJsonObject hello;
+        hello["type"] = "hello";
+        hello["binary"] = FRAME_VERSION;
+        hello["deltaPose"] = m_deltaPoseRequested;
+        sendJson(hello);
+    }
+
+    // Robots without subscriptions ignore it and keep being polled
+    m_subscribed = false;
+    sendSubscription();
+
     m_updateTimer->start();
     emit connected();
 }
 
 void RobotComm::onDisconnected() {
     m_updateTimer->stop();
+    m_binaryActive = false;
+    m_subscribed = false;
     emit disconnected();
 }
 
@@ -158,16 +246,34 @@ void RobotComm::onReadyRead() {
         return;
     }
 
-    // Process complete messages (assuming newline-delimited JSON)
-    while (m_receiveBuffer.contains('\n')) {
-        int newlineIndex = m_receiveBuffer.indexOf('\n');
-        QByteArray messageData = m_receiveBuffer.left(newlineIndex);
-        m_receiveBuffer.remove(0, newlineIndex + 1);
+    // Process complete messages: binary frames or newline-delimited JSON
+    int offset = 0;
+    while (offset < m_receiveBuffer.size()) {
+        if (quint8(m_receiveBuffer.at(offset)) == FRAME_MAGIC) {
+            if (m_receiveBuffer.size() - offset < FRAME_HEADER_SIZE) break;
+
+            const uchar* header = reinterpret_cast<const uchar*>(m_receiveBuffer.constData() + offset);
+            quint32 size = qFromLittleEndian<quint32>(header + 4);
+            if (quint32(m_receiveBuffer.size() - offset - FRAME_HEADER_SIZE) < size) break;
+
+            if (header[1] == FRAME_VERSION) {
+                parseFrame(header[2], m_receiveBuffer.mid(offset + FRAME_HEADER_SIZE, size));
+            }
+            offset += FRAME_HEADER_SIZE + size;
+            continue;
+        }
+
+        int newlineIndex = m_receiveBuffer.indexOf('\n', offset);
+        if (newlineIndex < 0) break;
+
+        QByteArray messageData = m_receiveBuffer.mid(offset, newlineIndex - offset);
+        offset = newlineIndex + 1;
 
         if (!messageData.isEmpty()) {
             parseIncomingData(messageData);
         }
     }
+    m_receiveBuffer.remove(0, offset);
 }
 
 void RobotComm::onError(QAbstractSocket::SocketError error) {
@@ -180,6 +286,11 @@ void RobotComm::requestRobotState() {
         return;
     }
 
+    if (m_binaryActive) {
+        sendFrame(FrameGetState, QByteArray());
+        return;
+    }
+
     QJsonObject message;
     message["type"] = "getState";
     sendJson(message);
@@ -215,6 +326,97 @@ void RobotComm::parseIncomingData(const QByteArray& data) {
         bool success = json["success"].toBool();
         emit pathExecutionFinished(success);
     }
+    else if (type == "helloAck") {
+        m_binaryActive = json["binary"].toInt() >= FRAME_VERSION;
+    }
+    else if (type == "subscribeAck") {
+        // State is pushed from now on
+        m_subscribed = true;
+        m_updateTimer->stop();
+    }
+    else if (type == "lidarScan") {
+        QJsonArray array = json["ranges"].toArray();
+        QVector<float> ranges;
+        ranges.reserve(array.size());
+        for (const auto& value : array) {
+            ranges.append(float(value.toDouble()));
+        }
+        emit lidarScanUpdated(ranges);
+    }
+    else if (type == "odometry") {
+        emit odometryUpdated(json);
+    }
+}
+
+void RobotComm::parseFrame(quint8 type, const QByteArray& payload) {
+    QDataStream stream(payload);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    switch (type) {
+        case FramePose: {
+            float x, y, heading;
+            stream >> x >> y >> heading;
+            if (stream.status() != QDataStream::Ok) return;
+
+            m_currentPose.position.x = x;
+            m_currentPose.position.y = y;
+            m_currentPose.heading = heading;
+            emit robotPoseUpdated(m_currentPose);
+            break;
+        }
+        case FramePoseDelta: {
+            // Same double arithmetic as the robot encoder, so rounding never accumulates
+            qint16 dx, dy, dheading;
+            stream >> dx >> dy >> dheading;
+            if (stream.status() != QDataStream::Ok) return;
+
+            m_currentPose.position.x += dx * POSE_DELTA_SCALE;
+            m_currentPose.position.y += dy * POSE_DELTA_SCALE;
+            m_currentPose.heading += dheading * POSE_DELTA_SCALE;
+            emit robotPoseUpdated(m_currentPose);
+            break;
+        }
+        case FrameStatus: {
+            if (payload.size() < 4) return;
+            m_isMoving = payload.at(0) != 0;
+
+            QByteArray status = payload.mid(4);
+            int end = status.indexOf('\0');
+            if (end >= 0) status.truncate(end);
+            emit robotStatusUpdated(QString::fromUtf8(status));
+            break;
+        }
+        case FrameExecution: {
+            if (payload.size() < 2) return;
+            if (payload.at(0) == 0) {
+                emit pathExecutionStarted();
+            } else {
+                emit pathExecutionFinished(payload.at(1) != 0);
+            }
+            break;
+        }
+        case FrameJson:
+            parseIncomingData(payload);
+            break;
+        case FrameLidarScan: {
+            // u16 count, count x u16 range in mm
+            quint16 count;
+            stream >> count;
+            if (stream.status() != QDataStream::Ok || payload.size() < 2 + 2 * count) return;
+
+            QVector<float> ranges(count);
+            for (int i = 0; i < count; i++) {
+                quint16 mm;
+                stream >> mm;
+                ranges[i] = mm / 1000.0f;
+            }
+            emit lidarScanUpdated(ranges);
+            break;
+        }
+        default:
+            break;
+    }
 }
 
 void RobotComm::sendJson(const QJsonObject& json) {
@@ -224,3 +426,20 @@ void RobotComm::sendJson(const QJsonObject& json) {
     m_socket->write(data);
     m_socket->flush();
 }
+
+void RobotComm::sendFrame(quint8 type, const QByteArray& payload) {
+    QByteArray frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    frame.append(char(FRAME_MAGIC));
+    frame.append(char(FRAME_VERSION));
+    frame.append(char(type));
+    frame.append(char(0));
+
+    uchar size[4];
+    qToLittleEndian<quint32>(quint32(payload.size()), size);
+    frame.append(reinterpret_cast<const char*>(size), 4);
+    frame.append(payload);
+
+    m_socket->write(frame);
+    m_socket->flush();
+}
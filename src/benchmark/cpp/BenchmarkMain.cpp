@@ -0,0 +1,22 @@
+/************************************
+ * Benchmark suite
+ * Loop cost of the hot paths of the control code, on a desktop Linux box.
+ *
+ *   ./gradlew runBenchmarks -Pbenchmarks
+ *       writes build/benchmark-results/results.json (Google Benchmark JSON)
+ *   ./gradlew checkBenchmarks -PbenchmarkBaseline=old.json [-PbenchmarkTolerance=0.15]
+ *       also fails when a benchmark got slower than the baseline by more
+ *       than the tolerance, and deploy runs it first
+ *
+ * The suite is not part of the default build, it needs Google Benchmark
+ * under /usr/local or -PbenchmarkRoot=<prefix>.
+ *
+ * Any Google Benchmark flag can be passed to the executable itself, e.g.
+ * --benchmark_filter=Camera --benchmark_repetitions=5. The camera benchmarks
+ * run on the frames stored in $BENCHMARK_FRAMES (png / jpg, half the camera
+ * resolution like FruitDetector), on a synthetic scene when it is not set.
+ *************************************/
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
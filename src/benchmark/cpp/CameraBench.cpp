@@ -0,0 +1,188 @@
+/************************************
+ * Camera benchmarks
+ * FruitDetector's segmentation chain on stored frames: the fused HSV
+ * labelling, then per object the mask, the open / close morphology,
+ * the external contours and the largest blob within the area limits.
+ *
+ * Frames come from $BENCHMARK_FRAMES (every png / jpg in it, resized to
+ * the detection resolution), or a synthetic scene with a few grapes.
+ *************************************/
+
+#include "HsvThreshold.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Camera.h's grapes, the usual detection set
+    struct BenchObject {
+        HsvRange range[2];
+        bool second;
+        int open_iteration;
+        int close_iteration;
+        int min_area;
+        int max_area;
+    };
+
+    const BenchObject bench_objects[] = {
+        { { { {  16, 25, 25 }, {  27, 255, 255 } } },                                      false, 2, 2, 1000, 25000 },   // grape_yellow
+        { { { {  30, 25, 25 }, {  69, 255, 255 } } },                                      false, 2, 1, 1000, 25000 },   // grape_green
+        { { { {   0, 50,  0 }, {  10, 255, 100 } }, { { 165, 25, 0 }, { 180, 255, 100 } } }, true,  2, 3,  500, 15000 },   // grape_purple
+    };
+    constexpr int object_count = sizeof( bench_objects ) / sizeof( bench_objects[0] );
+
+    const cv::Size detection_size( 320, 240 );     // 640 x 480 camera, FruitDetector::scale
+
+    std::vector<cv::Mat> LoadFrames(){
+        std::vector<cv::Mat> frames;
+
+        const char * dir = std::getenv( "BENCHMARK_FRAMES" );
+        if( dir ){
+            std::vector<cv::String> files;
+            for( const char * pattern : { "/*.png", "/*.jpg" } ){
+                std::vector<cv::String> found;
+                cv::glob( std::string( dir ) + pattern, found, false );
+                files.insert( files.end(), found.begin(), found.end() );
+            }
+            for( const cv::String & f : files ){
+                cv::Mat image = cv::imread( f, cv::IMREAD_COLOR );
+                if( image.empty() ){ continue; }
+                if( image.size() != detection_size ){ cv::resize( image, image, detection_size ); }
+                frames.push_back( image );
+            }
+        }
+
+        if( frames.empty() ){
+            // Noisy dark background with a yellow, a green and a purple grape (BGR)
+            cv::Mat image( detection_size, CV_8UC3 );
+            cv::randu( image, cv::Scalar( 20, 20, 20 ), cv::Scalar( 90, 90, 90 ) );
+            cv::circle( image, cv::Point(  80, 120 ), 40, cv::Scalar(  40, 200, 220 ), cv::FILLED );
+            cv::circle( image, cv::Point( 170, 100 ), 35, cv::Scalar(  60, 200,  90 ), cv::FILLED );
+            cv::circle( image, cv::Point( 260, 150 ), 30, cv::Scalar(  80,  20,  90 ), cv::FILLED );
+            frames.push_back( image );
+        }
+        return frames;
+    }
+
+    const std::vector<cv::Mat> & Frames(){
+        static const std::vector<cv::Mat> frames = LoadFrames();
+        return frames;
+    }
+
+    struct Segmenter {
+        HsvThresholdKernel threshold;
+        cv::Mat kernel = cv::getStructuringElement( cv::MORPH_RECT, cv::Size( 3, 3 ) );
+        cv::Mat labels;
+        cv::Mat mask;
+        std::vector<std::vector<cv::Point>> contours;
+
+        Segmenter(){
+            for( int k = 0; k < object_count; k++ ){
+                threshold.AddRange( k, bench_objects[k].range[0] );
+                if( bench_objects[k].second ){ threshold.AddRange( k, bench_objects[k].range[1] ); }
+            }
+            labels.create( detection_size.height, detection_size.width, CV_8UC1 );
+            mask.create( detection_size.height, detection_size.width, CV_8UC1 );
+        }
+
+        void Label( const cv::Mat & image ){
+            threshold.Label( image.ptr<uint8_t>(), static_cast<int>( image.step ),
+                             labels.ptr<uint8_t>(), static_cast<int>( labels.step ), image.cols, image.rows );
+        }
+
+        // Area of the largest blob of object k, 0 when none
+        double Segment( int k ){
+            const BenchObject & obj = bench_objects[k];
+
+            cv::bitwise_and( labels, cv::Scalar( 1 << k ), mask );
+            const int border = cv::BORDER_CONSTANT | cv::BORDER_ISOLATED;
+            cv::morphologyEx( mask, mask, cv::MORPH_OPEN,  kernel, cv::Point( -1, -1 ), obj.open_iteration,  border );
+            cv::morphologyEx( mask, mask, cv::MORPH_CLOSE, kernel, cv::Point( -1, -1 ), obj.close_iteration, border );
+            cv::findContours( mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE );
+
+            double best = 0;
+            for( const auto & c : contours ){
+                double area = cv::contourArea( c );
+                if( area > best && area > obj.min_area && area < obj.max_area ){ best = area; }
+            }
+            return best;
+        }
+    };
+
+}
+
+static void BM_CameraLabel( benchmark::State & state ){
+    const std::vector<cv::Mat> & frames = Frames();
+    Segmenter s;
+
+    size_t i = 0;
+    for( auto _ : state ){
+        s.Label( frames[i] );
+        benchmark::DoNotOptimize( s.labels.data );
+        i = ( i + 1 ) % frames.size();
+    }
+    state.SetItemsProcessed( state.iterations() * detection_size.area() );
+}
+BENCHMARK( BM_CameraLabel );
+
+// What BM_CameraLabel replaces: cvtColor, an inRange per range and a bitwise_or per object
+static void BM_CameraOpenCvThreshold( benchmark::State & state ){
+    const std::vector<cv::Mat> & frames = Frames();
+    cv::Mat hsv, second;
+    cv::Mat masks[object_count];
+
+    auto bound = []( const uint8_t * v ){ return cv::Scalar( v[0], v[1], v[2] ); };
+
+    size_t i = 0;
+    for( auto _ : state ){
+        cv::cvtColor( frames[i], hsv, cv::COLOR_BGR2HSV );
+        for( int k = 0; k < object_count; k++ ){
+            const BenchObject & obj = bench_objects[k];
+            cv::inRange( hsv, bound( obj.range[0].lower ), bound( obj.range[0].upper ), masks[k] );
+            if( obj.second ){
+                cv::inRange( hsv, bound( obj.range[1].lower ), bound( obj.range[1].upper ), second );
+                cv::bitwise_or( masks[k], second, masks[k] );
+            }
+        }
+        benchmark::DoNotOptimize( masks[0].data );
+        i = ( i + 1 ) % frames.size();
+    }
+    state.SetItemsProcessed( state.iterations() * detection_size.area() );
+}
+BENCHMARK( BM_CameraOpenCvThreshold );
+
+// Morphology and contours of one object on labels already computed
+static void BM_CameraSegment( benchmark::State & state ){
+    const std::vector<cv::Mat> & frames = Frames();
+    Segmenter s;
+    s.Label( frames[0] );
+
+    const int k = static_cast<int>( state.range( 0 ) );
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( s.Segment( k ) );
+    }
+}
+BENCHMARK( BM_CameraSegment )->DenseRange( 0, object_count - 1 );
+
+// One detection: label and segment every object, on a single thread
+static void BM_CameraDetect( benchmark::State & state ){
+    const std::vector<cv::Mat> & frames = Frames();
+    Segmenter s;
+
+    size_t i = 0;
+    for( auto _ : state ){
+        s.Label( frames[i] );
+        for( int k = 0; k < object_count; k++ ){
+            benchmark::DoNotOptimize( s.Segment( k ) );
+        }
+        i = ( i + 1 ) % frames.size();
+    }
+    state.counters["frames"] = static_cast<double>( frames.size() );
+}
+BENCHMARK( BM_CameraDetect )->Unit( benchmark::kMicrosecond );
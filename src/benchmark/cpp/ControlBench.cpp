@@ -0,0 +1,125 @@
+/************************************
+ * Control benchmarks
+ * PID and drive kinematics, run every control period by Movement and Oms.
+ *************************************/
+
+#include "Movement.h"     // And PID.h, which has no include guard
+#include "PoseFilter.h"
+#include "Sensors.h"
+#include "SimHardware.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+// Wheel PID on a measurement that moves every call, so both the integrator and the derivative work
+static void BM_PIDCalculate( benchmark::State & state ){
+    PID pid;
+    pid.setPID( 0.5, 0.1, 0.01 );
+    pid.Reset();
+
+    double measurement = 0;
+    for( auto _ : state ){
+        double output = pid.Calculate( measurement, 0.6 );
+        benchmark::DoNotOptimize( output );
+        measurement += ( output - measurement ) * 0.1;
+    }
+}
+BENCHMARK( BM_PIDCalculate );
+
+// The three wheel controllers of one Movement period
+static void BM_PIDWheels( benchmark::State & state ){
+    PID pid[3];
+    for( PID & p : pid ){
+        p.setPID( 0.5, 0.1, 0.01 );
+        p.Reset();
+    }
+
+    double measurement[3] = { 0, 0, 0 };
+    const double setpoint[3] = { 0.6, -0.4, 0.1 };
+    for( auto _ : state ){
+        for( int i = 0; i < 3; i++ ){
+            double output = pid[i].Calculate( measurement[i], setpoint[i] );
+            benchmark::DoNotOptimize( output );
+            measurement[i] += ( output - measurement[i] ) * 0.1;
+        }
+    }
+}
+BENCHMARK( BM_PIDWheels );
+
+static void BM_InverseKinematics( benchmark::State & state ){
+    SimHardware hard;
+    Sensor sensor( &hard );
+    Movement movement( &hard, &sensor );
+
+    double x = 20, z = 0.3;
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( x );
+        benchmark::DoNotOptimize( z );
+        movement.InverseKinematics( x, 0, z );
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK( BM_InverseKinematics );
+
+static void BM_ForwardKinematics( benchmark::State & state ){
+    SimHardware hard;
+    Sensor sensor( &hard );
+    Movement movement( &hard, &sensor );
+
+    double vl = 20, vr = 25, vb = 0;
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( vl );
+        benchmark::DoNotOptimize( vr );
+        movement.ForwardKinematics( vl, vr, vb );
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK( BM_ForwardKinematics );
+
+// Inline odometry step: batched encoder and navX read, filter predict, correction and pose publish
+static void BM_RobotPosition( benchmark::State & state ){
+    SimHardware hard;
+    Sensor sensor( &hard );
+    Movement movement( &hard, &sensor );
+    movement.SetPosition( 200, 200, 90 );
+
+    for( auto _ : state ){
+        movement.RobotPosition();
+        benchmark::DoNotOptimize( movement.get_x() );
+    }
+}
+BENCHMARK( BM_RobotPosition );
+
+// One 200 Hz step of the pose filter with the sensors it fuses: predict, turn rate, two sharps, one
+// ultrasonic and the lidar wall fit on three axes
+static void BM_PoseFilterStep( benchmark::State & state ){
+    PoseFilter filter;
+    filter.Reset( 200, 200, M_PI / 2 );
+
+    RangeObservation ray[3];
+    ray[0].mount = constant::SHARP_RIGHT_MOUNT;
+    ray[1].mount = constant::SHARP_LEFT_MOUNT;
+    ray[2].mount = constant::US_RIGHT_MOUNT;
+    RangeObservation wall[3], heading[3];
+    const double axis[3] = { 0, 90, -90 };
+    for( int i = 0; i < 3; i++ ){
+        wall[i].kind = RangeObservation::WALL;
+        wall[i].mount = SensorMount{ constant::LIDAR_OFFSET_X, constant::LIDAR_OFFSET_Y, axis[i] };
+        heading[i].kind = RangeObservation::HEADING;
+        heading[i].mount = wall[i].mount;
+    }
+
+    for( auto _ : state ){
+        filter.Predict( 0.25, 1e-4, 0.005 );
+        filter.UpdateTurnRate( 1e-4, 1.1e-4, 0.005 );
+        for( RangeObservation & o : ray ){ o.value = 200; filter.Update( o, 0.25, 1e-4 ); }
+        for( int i = 0; i < 3; i++ ){
+            wall[i].value = 200;
+            filter.Update( wall[i] );
+            filter.Update( heading[i] );
+        }
+        benchmark::DoNotOptimize( filter.Get( PoseFilter::X ) );
+    }
+}
+BENCHMARK( BM_PoseFilterStep );
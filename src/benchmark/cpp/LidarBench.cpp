@@ -0,0 +1,85 @@
+/************************************
+ * Lidar benchmarks
+ * Sector statistics of one 360 beam scan, as Lidar::ComputeRanges.
+ *************************************/
+
+#include "LidarSectors.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static void MakeRoomScan( float * distance_mm, unsigned seed ){
+    // 4 x 3 m room, lidar 1.2 m from the left wall and 0.8 m from the back wall
+    const double walls[4][2] = { { 0, 2.8 }, { 90, 2.2 }, { 180, 1.2 }, { 270, 0.8 } };   // normal [deg], distance [m]
+
+    std::mt19937 rng( seed );
+    std::normal_distribution<double> noise( 0, 0.01 );
+    std::uniform_real_distribution<double> drop( 0, 1 );
+
+    for( int i = 0; i < LidarSectorKernel::beams; i++ ){
+        double a = i * M_PI / 180.0;
+        double best = 1e9;
+        for( const auto & w : walls ){
+            double c = std::cos( a - w[0] * M_PI / 180.0 );
+            if( c > 1e-3 ){ best = std::min( best, w[1] / c ); }
+        }
+        distance_mm[i] = drop( rng ) < 0.05 ? 0.0f : static_cast<float>( ( best + noise( rng ) ) * 1000.0 );
+    }
+}
+
+// The six sectors of Lidar::ComputeRanges: ranges and wall fits to the front, left and right
+static void BM_LidarRangeSectors( benchmark::State & state ){
+    const int range_window = 3, wall_window = 15;
+    const int front = 270, left = 180, right = 360;
+    const LidarSector sectors[6] = {
+        { front - range_window, 2 * range_window + 1 },
+        { left  - range_window, 2 * range_window + 1 },
+        { right - range_window, 2 * range_window + 1 },
+        { front - wall_window,  2 * wall_window  + 1 },
+        { left  - wall_window,  2 * wall_window  + 1 },
+        { right - wall_window,  2 * wall_window  + 1 },
+    };
+
+    float scan[LidarSectorKernel::beams];
+    MakeRoomScan( scan, 1 );
+
+    LidarSectorKernel kernel;
+    SectorStats stats[6];
+    for( auto _ : state ){
+        kernel.Compute( scan, sectors, 6, stats );
+        benchmark::DoNotOptimize( stats );
+    }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    state.SetLabel( "NEON" );
+#elif defined(__SSE2__)
+    state.SetLabel( "SSE2" );
+#else
+    state.SetLabel( "scalar" );
+#endif
+}
+BENCHMARK( BM_LidarRangeSectors );
+
+// Full coverage, state.range( 0 ) degrees per sector
+static void BM_LidarRing( benchmark::State & state ){
+    const int width = static_cast<int>( state.range( 0 ) );
+    const int count = LidarSectorKernel::beams / width;
+
+    LidarSector sectors[LidarSectorKernel::beams];
+    for( int i = 0; i < count; i++ ){ sectors[i] = { i * width, width }; }
+
+    float scan[LidarSectorKernel::beams];
+    MakeRoomScan( scan, 2 );
+
+    LidarSectorKernel kernel;
+    SectorStats stats[LidarSectorKernel::beams];
+    for( auto _ : state ){
+        kernel.Compute( scan, sectors, count, stats );
+        benchmark::DoNotOptimize( stats );
+    }
+    state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_LidarRing )->Arg( 10 )->Arg( 30 );
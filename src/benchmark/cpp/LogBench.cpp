@@ -0,0 +1,83 @@
+/************************************
+ * Log benchmarks
+ * Caller side of the LOG_* calls made from the control loops: a logged
+ * record, a call suppressed by its rate limit and a call below the level.
+ * The records go to /dev/null while these run.
+ *************************************/
+
+#include "Log.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    // Sends stdout to /dev/null for the scope, the writer thread would flood the results otherwise
+    class QuietStdout
+    {
+        public:
+            QuietStdout(){
+                std::fflush( stdout );
+                saved = dup( STDOUT_FILENO );
+                int null = open( "/dev/null", O_WRONLY );
+                dup2( null, STDOUT_FILENO );
+                close( null );
+            }
+            ~QuietStdout(){
+                logging::Flush();
+                std::fflush( stdout );
+                dup2( saved, STDOUT_FILENO );
+                close( saved );
+            }
+
+        private:
+            int saved;
+    };
+
+    constexpr int batch = 500;      // Records between flushes, small enough for the ring
+
+}
+
+static void BM_LogRecord( benchmark::State & state ){
+    QuietStdout quiet;
+    const uint64_t dropped = logging::GetDropped();
+
+    int i = 0;
+    for( auto _ : state ){
+        LOG_INFO( "Move Goal x: %f y: %f th: %d", i * 0.5, i * 0.25, i );
+        if( ++i % batch == 0 ){
+            // The writer drains between batches, as between the iterations of a loop
+            state.PauseTiming();
+            logging::Flush();
+            state.ResumeTiming();
+        }
+    }
+    state.counters["dropped"] = static_cast<double>( logging::GetDropped() - dropped );
+}
+BENCHMARK( BM_LogRecord );
+
+static void BM_LogRateLimited( benchmark::State & state ){
+    QuietStdout quiet;
+
+    int i = 0;
+    for( auto _ : state ){
+        LOG_INFO_EVERY( 500, "x: %.1f y: %.1f", i * 0.5, i * 0.25 );
+        i++;
+    }
+}
+BENCHMARK( BM_LogRateLimited );
+
+static void BM_LogBelowLevel( benchmark::State & state ){
+    QuietStdout quiet;
+
+    int i = 0;
+    for( auto _ : state ){
+        LOG_DEBUG( "scan %d", i );
+        i++;
+    }
+}
+BENCHMARK( BM_LogBelowLevel );
@@ -0,0 +1,69 @@
+/************************************
+ * Navigation benchmarks
+ * Waypoint routing: the runtime FieldGraph against the constexpr
+ * FieldLayout that replaced it in MainTask. Every benchmark cycles through
+ * all the ordered pairs of waypoints.
+ *************************************/
+
+#include "FieldGraph.h"
+#include "FieldLayout.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// The competition layout as a runtime graph, nodes and edges added one by one
+static FieldGraph MakeLayoutGraph(){
+    FieldGraph graph;
+    for( const field::Node & n : field::layout_nodes ){ graph.AddNode( n.x, n.y ); }
+    for( const field::Edge & e : field::layout_edges ){ graph.AddEdge( e.from, e.to ); }
+    return graph;
+}
+
+static void BM_FieldGraphBuild( benchmark::State & state ){
+    FieldGraph graph = MakeLayoutGraph();
+    for( auto _ : state ){
+        graph.Build();
+        benchmark::DoNotOptimize( graph.IsBuilt() );
+    }
+}
+BENCHMARK( BM_FieldGraphBuild );
+
+// Cost lookup and the walk through the next hop table
+static void BM_FieldGraphRoute( benchmark::State & state ){
+    FieldGraph graph = MakeLayoutGraph();
+    graph.Build();
+
+    std::vector<int> route;
+    const int n = graph.NodeCount();
+    int from = 0, to = 1;
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( graph.Cost( from, to ) );
+        benchmark::DoNotOptimize( graph.Route( from, to, route ) );
+        if( ++to == n ){ to = 0; from = ( from + 1 ) % n; }
+    }
+}
+BENCHMARK( BM_FieldGraphRoute );
+
+static void BM_FieldGraphAStar( benchmark::State & state ){
+    FieldGraph graph = MakeLayoutGraph();
+    graph.Build();
+
+    std::vector<int> route;
+    const int n = graph.NodeCount();
+    int from = 0, to = 1;
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( graph.AStar( from, to, route ) );
+        if( ++to == n ){ to = 0; from = ( from + 1 ) % n; }
+    }
+}
+BENCHMARK( BM_FieldGraphAStar );
+
+static void BM_FieldLayoutRoute( benchmark::State & state ){
+    int from = 0, to = 1;
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( field::layout.GetRoute( from, to ) );
+        if( ++to == field::WAYPOINT_COUNT ){ to = 0; from = ( from + 1 ) % field::WAYPOINT_COUNT; }
+    }
+}
+BENCHMARK( BM_FieldLayoutRoute );
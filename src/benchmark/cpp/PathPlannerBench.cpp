@@ -0,0 +1,153 @@
+/************************************
+ * PathPlanner benchmarks
+ * Decoding of GUI messages (the path upload that used to go through
+ * ParsePathFromJson) and encoding of the published topics.
+ *************************************/
+
+#include "PathPlannerComm.h"
+#include "JsonStream.h"
+#include "WireProtocol.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Same layout as RobotComm::sendPath, keys sorted like QJsonDocument writes them
+static std::string MakePathMessage( int waypoints ){
+    std::string json = "{\"path\":{\"color\":\"#ff0000\",\"name\":\"bench\",\"visible\":true,\"waypoints\":[";
+    char item[192];
+    for( int i = 0; i < waypoints; i++ ){
+        double x = 0.5 + 3.0 * std::cos( i * 0.001 );
+        double y = 0.5 + 2.0 * std::sin( i * 0.002 );
+        double th = std::fmod( i * 0.01, 2 * M_PI );
+        std::snprintf( item, sizeof( item ), "%s{\"theta\":%.6f,\"theta_rad\":%.6f,\"velocity\":%.2f,\"x\":%.6f,\"y\":%.6f}",
+                       i ? "," : "", th * 180.0 / M_PI, th, 1.0 + ( i % 5 ) * 0.1, x, y );
+        json += item;
+    }
+    json += "]},\"type\":\"sendPath\"}";
+    return json;
+}
+
+static void BM_DecodePath( benchmark::State & state ){
+    const std::string message = MakePathMessage( static_cast<int>( state.range( 0 ) ) );
+    PathPlanner::IncomingMessage decoded;
+
+    for( auto _ : state ){
+        if( !PathPlanner::DecodeMessage( message.data(), message.data() + message.size(), decoded ) ){
+            state.SkipWithError( "sendPath not decoded" );
+            break;
+        }
+        benchmark::DoNotOptimize( decoded.path.waypoints.data() );
+    }
+    state.SetBytesProcessed( state.iterations() * static_cast<int64_t>( message.size() ) );
+    state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_DecodePath )->Arg( 100 )->Arg( 1000 )->Arg( 10000 );
+
+// The same upload as it comes off the socket: recv() sized chunks framed by MessageBuffer, then decoded
+static void BM_StreamPath( benchmark::State & state ){
+    const std::string message = MakePathMessage( static_cast<int>( state.range( 0 ) ) ) + "\n";
+    const size_t chunk = 4096;      // Bytes per recv()
+
+    PathPlanner::MessageBuffer buffer;
+    PathPlanner::IncomingMessage decoded;
+
+    for( auto _ : state ){
+        for( size_t offset = 0; offset < message.size(); offset += chunk ){
+            size_t space;
+            char * dst = buffer.WritePtr( space );
+            if( !dst ){
+                state.SkipWithError( "message buffer full" );
+                return;
+            }
+
+            const size_t n = std::min( { chunk, space, message.size() - offset } );
+            std::memcpy( dst, message.data() + offset, n );
+            buffer.Commit( n );
+
+            const char * begin;
+            const char * end;
+            while( buffer.Next( begin, end ) ){
+                if( !PathPlanner::DecodeMessage( begin, end, decoded ) ){
+                    state.SkipWithError( "sendPath not decoded" );
+                    return;
+                }
+                benchmark::DoNotOptimize( decoded.path.waypoints.data() );
+            }
+        }
+    }
+    state.SetBytesProcessed( state.iterations() * static_cast<int64_t>( message.size() ) );
+    state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_StreamPath )->Arg( 10000 );
+
+// Binary upload of the same path
+static void BM_DecodePathFrame( benchmark::State & state ){
+    PathPlanner::Path path( "bench" );
+    for( int i = 0; i < state.range( 0 ); i++ ){
+        path.waypoints.emplace_back( 0.5 + 3.0 * std::cos( i * 0.001 ), 0.5 + 2.0 * std::sin( i * 0.002 ), i * 0.01, 1.0 );
+    }
+    std::string frame;
+    PathPlanner::wire::AppendPath( frame, path );
+    PathPlanner::IncomingMessage decoded;
+
+    for( auto _ : state ){
+        if( !PathPlanner::wire::DecodeFrame( frame.data(), frame.data() + frame.size(), decoded ) ){
+            state.SkipWithError( "path frame not decoded" );
+            break;
+        }
+        benchmark::DoNotOptimize( decoded.path.waypoints.data() );
+    }
+    state.SetBytesProcessed( state.iterations() * static_cast<int64_t>( frame.size() ) );
+    state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_DecodePathFrame )->Arg( 100 )->Arg( 1000 )->Arg( 10000 );
+
+static void BM_DecodeGetState( benchmark::State & state ){
+    const std::string message = "{\"type\":\"getState\"}";
+    PathPlanner::IncomingMessage decoded;
+
+    for( auto _ : state ){
+        benchmark::DoNotOptimize( PathPlanner::DecodeMessage( message.data(), message.data() + message.size(), decoded ) );
+    }
+}
+BENCHMARK( BM_DecodeGetState );
+
+static void BM_CreatePoseJson( benchmark::State & state ){
+    PathPlanner::RobotPose pose( 1.234567, 2.345678, 0.785398 );
+    for( auto _ : state ){
+        std::string json = PathPlanner::PathPlannerComm::CreatePoseJson( pose );
+        benchmark::DoNotOptimize( json.data() );
+        pose.x += 1e-6;
+    }
+}
+BENCHMARK( BM_CreatePoseJson );
+
+// What binary clients get instead of CreatePoseJson
+static void BM_AppendPoseFrame( benchmark::State & state ){
+    PathPlanner::RobotPose pose( 1.234567, 2.345678, 0.785398 );
+    std::string frame;
+    for( auto _ : state ){
+        frame.clear();
+        PathPlanner::wire::AppendPose( frame, pose );
+        benchmark::DoNotOptimize( frame.data() );
+        pose.x += 1e-6;
+    }
+}
+BENCHMARK( BM_AppendPoseFrame );
+
+static void BM_CreateLidarScanJson( benchmark::State & state ){
+    std::vector<float> ranges( 360 );
+    for( size_t i = 0; i < ranges.size(); i++ ){ ranges[i] = 1.0f + 0.5f * std::sin( i * 0.05f ); }
+
+    for( auto _ : state ){
+        std::string json = PathPlanner::PathPlannerComm::CreateLidarScanJson( ranges.data(), ranges.size() );
+        benchmark::DoNotOptimize( json.data() );
+    }
+}
+BENCHMARK( BM_CreateLidarScanJson );
@@ -13,28 +13,35 @@
 #include <frc/smartdashboard/SmartDashboard.h>
 #include <frc/controller/PIDController.h>
 
-#include "frc/Timer.h"
-
 #include "Constants.h"
 #include "Functions.h"
 #include "Hardware.h"
 #include "Sensors.h"
+#include "Odometry.h"
 #include "PID.h"
+#include "Scheduler.h"
+#include "SeqLock.h"
+#include "Telemetry.h"
+#include "Trajectory.h"
 
 #include <cmath>
+#include <functional>
 #include <string>
 
 class Movement
 {
     public:
-        Movement( Hardware * h, Sensor * s ) : hardware{h}, sensor{s}{ time.Start(); }
-        ~Movement(){ time.Stop(); }
+        Movement( Hardware * h, Sensor * s ) : hardware{h}, sensor{s}, odometry{h}{ time.Start(); }
+        ~Movement();
 
         void RobotPosition();
         void InverseKinematics(double x, double y, double z);
         void ForwardKinematics( double vl, double vr, double vb );
         void SetPosition( double x, double y, double th );
         void PositionDriver( double desired_x, double desired_y, double desired_th );
+        // Follows the trajectory without stopping (Ramsete), returns at its end or false on the stop button.
+        // The robot should already face the start tangent, PositionDriver() settles the end pose.
+        bool TrajectoryDriver( const Trajectory & trajectory );
         void linear_increment( float dist, std::string direction );
         void cmd_drive( float vx, float vy, float vth );
         double WheelSpeed( int encoder, double time );     // Returns the wheel speed based on the Encoder Ticks
@@ -43,6 +50,24 @@ class Movement
         double get_y();
         double get_th();
 
+        // 200 Hz odometry thread, see Odometry.h. Without it RobotPosition() integrates the pose itself.
+        void StartOdometry( int priority = 0, int cpu = -1 ){ odometry.Start( priority, cpu ); }
+        void StopOdometry(){ odometry.Stop(); }
+
+        // Thread safe view of the pose, published on every odometry step
+        PoseSample GetPose() const { return odometry.GetPose(); }
+        // Thread safe, applied by the next odometry step. Only the latest delta is kept,
+        // so every delta must be computed against the latest GetPose().
+        uint32_t CorrectPose( double dx, double dy, double dth ){ return odometry.Correct( dx, dy, dth ); }
+
+        // Fuses the wall ranges of the sensors into the odometry, see PoseFilter.h. Off by default.
+        void SetFusion( bool enabled );
+        // Thread safe, for the sensors Movement does not own (lidar)
+        void ObserveRange( const RangeObservation & o ){ odometry.Observe( o ); }
+
+        // Called about every 200 ms while a driver runs, Robot.h publishes the odometry to the GUI with it
+        void SetOdometryCallback( std::function<void()> callback ){ odometry_callback = std::move( callback ); }
+
         void angular_align();
         
         void line_align(std::string direction);
@@ -88,6 +113,11 @@ class Movement
         static constexpr double max_ang_speed = 1.5;        // rad/s
         static constexpr double min_ang_speed = 0.2;        // rad/s
 
+        static constexpr double ramsete_b    = 2.0;         // [rad^2/m^2] convergence gain
+        static constexpr double ramsete_zeta = 0.7;         // damping
+        static constexpr double max_follower_speed     = 30.0;  // cm/s, reference plus correction
+        static constexpr double max_follower_ang_speed = 2.0;   // rad/s
+
         double leftVelocity;
         double rightVelocity;
         double backVelocity; 
@@ -100,7 +130,10 @@ class Movement
         double vy; 
         double vth;
 
-        double offset_th;
+        // Copies the latest odometry pose into x_global, y_global, th_global, vx and vth
+        void LoadPose();
+
+        Odometry odometry;
 
         static constexpr double kP = 0.8;
         static constexpr double kI = 0.05;
@@ -114,7 +147,34 @@ class Movement
         // frc2::PIDController p_r{kP, kI, kD};
         // frc2::PIDController p_b{kP, kI, kD};
 
-        frc::Timer time;
+        timing::Timer time;
+
+        std::function<void()> odometry_callback;
+
+        // Dashboard entries, registered once and published by the telemetry thread
+        struct Dashboard {
+            telemetry::String  process             = telemetry::AddString ( "Process" );
+            telemetry::Number  desired_left_speed  = telemetry::AddNumber ( "desired_left_speed" );
+            telemetry::Number  desired_right_speed = telemetry::AddNumber ( "desired_right_speed" );
+            telemetry::Number  robot_x             = telemetry::AddNumber ( "robot_x" );
+            telemetry::Number  robot_y             = telemetry::AddNumber ( "robot_y" );
+            telemetry::Number  robot_th            = telemetry::AddNumber ( "robot_th" );
+            telemetry::Number  vx                  = telemetry::AddNumber ( "vx" );
+            telemetry::Number  vy                  = telemetry::AddNumber ( "vy" );
+            telemetry::Number  vth                 = telemetry::AddNumber ( "vth" );
+            telemetry::Boolean stop_button         = telemetry::AddBoolean( "Stop Button" );
+            telemetry::Number  desired_vx          = telemetry::AddNumber ( "desired_vx" );
+            telemetry::Number  desired_vy          = telemetry::AddNumber ( "desired_vy" );
+            telemetry::Number  desired_vth         = telemetry::AddNumber ( "desired_vth" );
+            telemetry::Number  left_velocity       = telemetry::AddNumber ( "leftVelocity" );
+            telemetry::Number  right_velocity      = telemetry::AddNumber ( "rightVelocity" );
+            telemetry::Number  delta_enc_l         = telemetry::AddNumber ( "delta_enc_l" );
+            telemetry::Number  delta_enc_r         = telemetry::AddNumber ( "delta_enc_r" );
+            telemetry::Number  vl                  = telemetry::AddNumber ( "vl" );
+            telemetry::Number  vr                  = telemetry::AddNumber ( "vr" );
+            telemetry::Number  des_ang             = telemetry::AddNumber ( "des_ang" );
+            telemetry::Number  get_th              = telemetry::AddNumber ( "get_th()" );
+        } dash;
 
 };
 
@@ -0,0 +1,101 @@
+/************************************
+ * Odometry
+ * Dead reckoning of the robot pose from the wheel encoders and the navX,
+ * optionally fused with the range sensors.
+ *
+ * Step() reads every input in one Hardware::ReadOdometry() batch and
+ * predicts the PoseFilter with it: the displacement along a constant
+ * curvature arc (chord along the midpoint heading, the plain midpoint
+ * rule on straight lines), the turn from the gyro. The back wheel is not
+ * used, as in Movement::ForwardKinematics().
+ *
+ * With SetFusion( true ) the same step also fuses the wheel turn rate
+ * against the gyro bias and every RangeObservation queued by Observe()
+ * since the previous step. Without it the pose is the plain odometry.
+ *
+ * Start() runs Step() at 200 Hz on its own thread, so the pose keeps
+ * following the robot while the control loops block on delays, the lidar
+ * or the camera. Without it Movement::RobotPosition() steps it inline.
+ * Every step publishes a PoseSample through a SeqLock, any thread reads it.
+ *************************************/
+
+#pragma once
+
+#include "Hardware.h"
+#include "PoseFilter.h"
+#include "Scheduler.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+struct PoseSample {
+    double x  = 0;              // [cm]
+    double y  = 0;              // [cm]
+    double th = 0;              // [degrees]
+    double v  = 0;              // Forward speed over the last step [cm/s]
+    double w  = 0;              // Turn rate over the last step [rad/s]
+    double sigma_xy = 0;        // Standard deviation of the worse axis [cm]
+    double sigma_th = 0;        // [degrees]
+    int64_t stamp_ns = 0;       // Time of the encoder and navX reads
+    uint32_t correction = 0;    // Last external correction already applied
+    uint32_t fused = 0;         // Range observations accepted by the filter
+};
+
+class Odometry
+{
+    public:
+        Odometry( Hardware * h ) : hardware{h}{}
+        ~Odometry(){ Stop(); }
+
+        // priority > 0 requests SCHED_FIFO, cpu >= 0 pins the thread, as Scheduler::Start()
+        void Start( int priority = 0, int cpu = -1 );
+        void Stop();
+        bool IsRunning() const { return thread.IsRunning(); }
+
+        // One integration step, called by the thread or by the owner when it is not running
+        void Step();
+
+        // Thread safe
+        void SetPose( double x, double y, double th );
+        PoseSample GetPose() const { return snapshot.Load(); }
+
+        // Thread safe, applied by the next Step(). Only the latest delta is kept,
+        // so every delta must be computed against the latest GetPose().
+        uint32_t Correct( double dx, double dy, double dth );
+
+        // Thread safe. Observations are dropped while the fusion is off, and the oldest one when the queue is full.
+        void SetFusion( bool enabled );
+        bool IsFusing() const { return fusion.load( std::memory_order_relaxed ); }
+        void Observe( const RangeObservation & o );
+
+        static constexpr double period = 5;             // [ms] 200 Hz
+        static constexpr int max_observations = 16;     // Queued between two steps
+        static constexpr double max_age = 0.1;          // [s] older observations are dropped
+
+    private:
+        void Publish( int64_t stamp_ns );
+
+        Hardware * hardware;
+
+        std::mutex mutex;               // Step() against SetPose(), also the single writer of snapshot
+        bool primed = false;            // last holds a valid sample
+        OdometrySample last;
+
+        PoseFilter filter;              // [cm], [rad]
+        double v  = 0;                  // [cm/s]
+        double w  = 0;                  // [rad/s]
+
+        SeqLock<PoseSample> snapshot;
+        SeqLock<PoseSample> correction;     // Deltas [cm], [cm], [degrees]
+        uint32_t applied_correction = 0;
+
+        std::atomic<bool> fusion{false};
+        std::mutex observe_mutex;           // Producers only wait for the copy out in Step()
+        RangeObservation observations[max_observations];
+        int observation_count = 0;
+
+        Scheduler thread{"odometry"};
+        bool configured = false;
+};
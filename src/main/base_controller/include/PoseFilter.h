@@ -0,0 +1,97 @@
+/************************************
+ * PoseFilter
+ * Extended Kalman filter of the robot pose on the field.
+ *
+ * State: x, y [cm], th [rad] and the gyro bias [rad/s], with its 4 x 4
+ * covariance. Everything is fixed size, no allocation on any call.
+ *
+ * Predict()  -> wheel travel along the gyro turn minus the bias, on the
+ *               constant curvature arc of Odometry. Wheel slip grows the
+ *               covariance with the distance, gyro noise with the time.
+ * Updates    -> scalar, each one gated on its Mahalanobis distance, so a
+ *               reading off an obstacle or a slipping wheel is dropped
+ *               instead of pulling the pose:
+ *   UpdateTurnRate()   gyro minus wheel turn rate, observes the bias
+ *   RAY                range along a sensor axis (sharp, ultrasonic)
+ *   WALL               perpendicular distance to the wall the axis faces (lidar fit)
+ *   HEADING            wall normal seen by a sensor (lidar fit)
+ *
+ * The map is the empty FIELD_SIZE box, anything inside it is left to the
+ * gate and to the Localizer.
+ *************************************/
+
+#pragma once
+
+#include "Constants.h"
+
+#include <cstdint>
+
+struct RangeObservation {
+    enum Kind { RAY, WALL, HEADING };
+
+    Kind kind = RAY;
+    SensorMount mount{ 0, 0, 0 };
+    double value = 0;           // RAY, WALL [cm]. HEADING: wall normal minus the mount direction [degrees], as LidarRanges
+    double sigma = 1;           // Standard deviation, same unit
+    int64_t stamp_ns = 0;
+};
+
+class PoseFilter
+{
+    public:
+        static constexpr int N = 4;
+        enum Index { X, Y, TH, BIAS };
+
+        PoseFilter(){ cov[BIAS][BIAS] = initial_bias * initial_bias; Reset( 0, 0, 0 ); }
+
+        // [cm], [rad]. The pose covariance restarts from the initial one, the bias estimate is kept.
+        void Reset( double x, double y, double th );
+
+        // ds [cm] travelled by the center, dth_gyro [rad] turned as the navX saw it, over dt [s]
+        void Predict( double ds, double dth_gyro, double dt );
+
+        // Turn of the same step from the wheels [rad], true when fused
+        bool UpdateTurnRate( double dth_gyro, double dth_wheels, double dt );
+
+        // True when fused, false when gated out or not facing a wall.
+        // ds [cm], dth [rad]: motion since the reading was taken, it is compared against the pose back then
+        bool Update( const RangeObservation & o, double ds = 0, double dth = 0 );
+
+        // External correction (Localizer), the covariance is left as is
+        void Shift( double dx, double dy, double dth );
+
+        double Get( Index i ) const { return state[i]; }
+        double Variance( Index i ) const { return cov[i][i]; }
+
+        // Range observations given to Update()
+        uint32_t GetAccepted() const { return accepted; }
+        uint32_t GetRejected() const { return rejected; }
+
+        static constexpr double initial_xy   = 2.0;      // [cm]
+        static constexpr double initial_th   = 0.035;    // [rad] ~2 degrees
+        static constexpr double initial_bias = 0.005;    // [rad/s]
+
+        static constexpr double wheel_slip   = 0.03;     // Fraction of the travel
+        static constexpr double gyro_noise   = 0.005;    // [rad/sqrt(s)]
+        static constexpr double bias_walk    = 2e-4;     // [rad/s/sqrt(s)]
+        static constexpr double turn_slip    = 0.1;      // Fraction of the wheel turn
+        static constexpr double turn_floor   = 2e-4;     // [rad] wheel turn noise at rest
+
+        static constexpr double gate           = 3.0;    // [sigmas]
+        static constexpr double max_incidence  = 25;     // [degrees] off the wall normal, specular beyond
+
+    private:
+        // Expected reading of o from pose s against the wall index (0: x = max, 1: y = max, 2: x = 0, 3: y = 0)
+        static double Expected( const RangeObservation & o, const double * s, int wall );
+        // Wall hit by the mount axis from pose s, -1 when none or hit too obliquely
+        static int FacingWall( const RangeObservation & o, const double * s );
+
+        bool Fuse( const double * h, double innovation, double variance );
+        bool Count( bool fused );
+
+        double state[N] = {};
+        double cov[N][N] = {};
+
+        uint32_t accepted = 0;
+        uint32_t rejected = 0;
+};
@@ -9,7 +9,34 @@
 *************************************/
 
 #include "Movement.h"
-#include "Robot.h"
+#include "Log.h"
+#include "LoopMetrics.h"
+
+namespace {
+    metrics::Loop position_loop  ( "position_driver" );
+    metrics::Loop trajectory_loop( "trajectory_driver" );
+    metrics::Loop angular_loop   ( "angular_align" );
+    metrics::Loop line_loop      ( "line_align" );
+
+    // Per RangeChannel: mount, trusted span [cm] away from where the sensor saturates, noise [cm] + fraction of the range
+    const struct {
+        SensorMount mount;
+        double min, max;
+        double sigma, ratio;
+    } range_models[] = {
+        { constant::SHARP_RIGHT_MOUNT, 10,  60, 1.0, 0.03 },
+        { constant::SHARP_LEFT_MOUNT,  10,  60, 1.0, 0.03 },
+        { constant::US_RIGHT_MOUNT,     5, 300, 1.5, 0.01 },
+        { constant::US_LEFT_MOUNT,      5, 300, 1.5, 0.01 },
+    };
+}
+
+Movement::~Movement(){
+    time.Stop();
+
+    // The sensor outlives the movement
+    if( odometry.IsFusing() ){ sensor->SetRangeCallback( nullptr ); }
+}
 
 void Movement::PositionDriver( double desired_x, double desired_y, double desired_th ) {
 
@@ -18,10 +45,10 @@ void Movement::PositionDriver( double desired_x, double desired_y, double desire
 
     bool reach_linear_tol  = false;
 
-    frc::SmartDashboard::PutString("Process",  "Position Driver" );
+    telemetry::Set( dash.process, "Position Driver" );
 
 
-    std::cout << "Move Goal x: " << desired_x << " y: " << desired_y << " th: " << desired_th << std::endl;
+    LOG_INFO( "Move Goal x: %g y: %g th: %g", desired_x, desired_y, desired_th );
 
     previous_enc_l = hardware->GetLeftEncoder();
     previous_enc_r = hardware->GetRightEncoder();
@@ -32,14 +59,16 @@ void Movement::PositionDriver( double desired_x, double desired_y, double desire
     bool forward = true;
     static int update_counter = 0;  // For periodic GUI updates
 
+    Rate rate( period, &position_loop );
+
     while(true){
         
         RobotPosition();    // Calculates Robot Position based on the wheels speed and displacement
 
         // Send position to GUI every 10 iterations (~200ms)
         update_counter++;
-        if (update_counter % 10 == 0) {
-            pathplanner_update_odometry(false);
+        if (update_counter % 10 == 0 && odometry_callback) {
+            odometry_callback();
         }
 
         double desired_position[3] = { desired_x, desired_y, desired_th };   // [cm], [cm], [degrees]
@@ -107,7 +136,7 @@ void Movement::PositionDriver( double desired_x, double desired_y, double desire
         if( setPoint_linear == 0 && setPoint_angular == 0 && leftVelocity == 0 && rightVelocity == 0 && backVelocity == 0 )
             { break; }
 
-        delay( period ); 
+        rate.Sleep();
 
     }
 
@@ -119,37 +148,127 @@ void Movement::PositionDriver( double desired_x, double desired_y, double desire
 
     delay(250);
 
-    frc::SmartDashboard::PutNumber("leftVelocity",  -1  );
-    frc::SmartDashboard::PutNumber("rightVelocity", -1 );
+    telemetry::Set( dash.left_velocity, -1 );
+    telemetry::Set( dash.right_velocity, -1 );
+
+    telemetry::Set( dash.delta_enc_l, -1 );
+    telemetry::Set( dash.delta_enc_r, -1 );
+
+    telemetry::Set( dash.vl, -1 );
+    telemetry::Set( dash.vr, -1 );
+
+}
+
+bool Movement::TrajectoryDriver( const Trajectory & trajectory ) {
+
+    if( trajectory.Empty() ){ return true; }
+
+    const float period = 20;  // ms
+
+    telemetry::Set( dash.process, "Trajectory Driver" );
+
+    LOG_INFO( "Trajectory length: %g cm duration: %g s", trajectory.Length(), trajectory.Duration() );
+
+    previous_enc_l = hardware->GetLeftEncoder();
+    previous_enc_r = hardware->GetRightEncoder();
+
+    pid_l.Reset();
+    pid_r.Reset();
+
+    bool success = true;
+    int update_counter = 0;
+
+    Rate rate( period, &trajectory_loop );
+    const int64_t start_ns = timing::NowNs();
+
+    while(true){
 
-    frc::SmartDashboard::PutNumber("delta_enc_l", -1 );
-    frc::SmartDashboard::PutNumber("delta_enc_r", -1 );
+        RobotPosition();
 
-    frc::SmartDashboard::PutNumber("vl", -1 );
-    frc::SmartDashboard::PutNumber("vr", -1 );
+        // Send position to GUI every 10 iterations (~200ms)
+        update_counter++;
+        if (update_counter % 10 == 0 && odometry_callback) {
+            odometry_callback();
+        }
+
+        if( hardware->GetStopButton() ){ success = false; break; }
+
+        double t = ( timing::NowNs() - start_ns ) * 1e-9;   // [s]
+        if( t >= trajectory.Duration() ){ break; }
+
+        TrajectoryState ref = trajectory.Sample( t );
+
+        // Pose error in the robot frame [m], [m], [rad]
+        double th = th_global * ( M_PI / 180.0 );
+        double dx = ( ref.x - x_global ) / 100.0;
+        double dy = ( ref.y - y_global ) / 100.0;
+        double e_x  =  std::cos( th ) * dx + std::sin( th ) * dy;
+        double e_y  = -std::sin( th ) * dx + std::cos( th ) * dy;
+        double e_th = std::remainder( ref.th - th, 2 * M_PI );
+
+        double v_ref = ref.v / 100.0;       // [m/s]
+        double w_ref = ref.v * ref.k;       // [rad/s]
+
+        // Ramsete
+        double k    = 2 * ramsete_zeta * std::sqrt( w_ref * w_ref + ramsete_b * v_ref * v_ref );
+        double sinc = std::abs( e_th ) < 1e-6 ? 1.0 : std::sin( e_th ) / e_th;
+
+        double setPoint_linear  = ( v_ref * std::cos( e_th ) + k * e_x ) * 100.0;                 // [cm/s]
+        double setPoint_angular = w_ref + k * e_th + ramsete_b * v_ref * sinc * e_y;              // [rad/s]
+
+        setPoint_linear  = std::clamp( setPoint_linear,  -max_follower_speed,     max_follower_speed );
+        setPoint_angular = std::clamp( setPoint_angular, -max_follower_ang_speed, max_follower_ang_speed );
+
+        cmd_drive( setPoint_linear, 0, setPoint_angular );
+
+        rate.Sleep();
+    }
+
+    hardware->SetLeft ( 0 );
+    hardware->SetRight( 0 );
+
+    pid_l.Reset();
+    pid_r.Reset();
 
+    return success;
 }
 
 void Movement::RobotPosition(){
-    //Forward Kinematics
-    ForwardKinematics( leftVelocity, rightVelocity, backVelocity );
+    if( !odometry.IsRunning() ){ odometry.Step(); }    // Otherwise the odometry thread keeps it current
 
-    coord_rotation( vx, vy, th_global );   // From Local to Global
+    LoadPose();
+}
 
-    //Robot Displacement
-    double delta_x  = vx  * delta_time;
-    double delta_y  = vy  * delta_time;
-    double delta_th = vth * delta_time;
+void Movement::LoadPose(){
+    PoseSample p = odometry.GetPose();
+    x_global  = p.x;
+    y_global  = p.y;
+    th_global = p.th;
+    vx  = p.v;
+    vy  = 0;
+    vth = p.w;
+}
 
-    //Robot Position update
-    x_global  = x_global  + delta_x;
-    y_global  = y_global  + delta_y;
-    // th_global = th_global + ((delta_th / M_PI) * 180);   // Angle based on the encoder
+void Movement::SetFusion( bool enabled ){
+    odometry.SetFusion( enabled );
 
-    th_global = -hardware->GetYaw() - offset_th;            // Angle based on the Gyro
+    if( !enabled ){
+        sensor->SetRangeCallback( nullptr );
+        return;
+    }
 
-    if      ( th_global <  0  ) { th_global = th_global + 360; }
-    else if ( th_global > 360 ) { th_global = th_global - 360; }
+    sensor->SetRangeCallback( [this]( RangeChannel channel, double range, int64_t stamp_ns ){
+        const auto & model = range_models[static_cast<int>( channel )];
+        if( range < model.min || range > model.max ){ return; }
+
+        RangeObservation o;
+        o.kind     = RangeObservation::RAY;
+        o.mount    = model.mount;
+        o.value    = range;
+        o.sigma    = model.sigma + model.ratio * range;
+        o.stamp_ns = stamp_ns;
+        odometry.Observe( o );
+    } );
 }
 
 void Movement::cmd_drive( float x, float y, float th ){
@@ -171,8 +290,8 @@ void Movement::cmd_drive( float x, float y, float th ){
     double vl = (pid_l.Calculate(leftVelocity  / 100.0, (desired_left_speed  * max_motor_speed) / 100.0) * 100 )/ max_motor_speed;
     double vr = (pid_r.Calculate(rightVelocity / 100.0, (desired_right_speed * max_motor_speed) / 100.0) * 100 )/ max_motor_speed;
     
-    frc::SmartDashboard::PutNumber("vl", vl );
-    frc::SmartDashboard::PutNumber("vr", vr );
+    telemetry::Set( dash.vl, vl );
+    telemetry::Set( dash.vr, vr );
 
 
 
@@ -197,7 +316,7 @@ void Movement::linear_increment( float dist, std::string direction ){
 
     double ang = 0;
 
-    frc::SmartDashboard::PutString("Process",  "Linear Increment" );
+    telemetry::Set( dash.process, "Linear Increment" );
 
 
     if     ( direction.compare( "front" ) == 0 ){ ang =   0; }
@@ -208,7 +327,7 @@ void Movement::linear_increment( float dist, std::string direction ){
     float dx = get_x() + ( dist * std::cos( (ang + get_th()) * ( M_PI / 180.0 ) ));
     float dy = get_y() + ( dist * std::sin( (ang + get_th()) * ( M_PI / 180.0 ) ));
 
-    std::cout << "Linear Increment Goal x: " << dx << " y: " << dy << std::endl;
+    LOG_INFO( "Linear Increment Goal x: %g y: %g", dx, dy );
 
     PositionDriver( dx, dy, get_th() );
 
@@ -241,58 +360,55 @@ double Movement::WheelSpeed( int encoder, double time ){
 }
 
 void Movement::SetPosition( double x, double y, double th ){
-  x_global  = x;
-  y_global  = y;
-  offset_th = -hardware->GetYaw() - th;
-  th_global = th;
+  odometry.SetPose( x, y, th );
 
   ShuffleBoardUpdate();
 }
 
 void Movement::ShuffleBoardUpdate(){
 
-    th_global = -hardware->GetYaw() - offset_th;            // Angle based on the Gyro
-
-    if      ( th_global <  0  ) { th_global = th_global + 360; }
-    else if ( th_global > 360 ) { th_global = th_global - 360; }
+    LoadPose();
 
-    frc::SmartDashboard::PutNumber("desired_left_speed",  desired_left_speed );
-    frc::SmartDashboard::PutNumber("desired_right_speed", desired_right_speed);
+    telemetry::Set( dash.desired_left_speed, desired_left_speed );
+    telemetry::Set( dash.desired_right_speed, desired_right_speed );
 
-    frc::SmartDashboard::PutNumber("robot_x",  x_global );
-    frc::SmartDashboard::PutNumber("robot_y",  y_global );
-    frc::SmartDashboard::PutNumber("robot_th", th_global);
+    telemetry::Set( dash.robot_x, x_global );
+    telemetry::Set( dash.robot_y, y_global );
+    telemetry::Set( dash.robot_th, th_global );
 
-    frc::SmartDashboard::PutNumber("vx",  vx );
-    frc::SmartDashboard::PutNumber("vy",  vy );
-    frc::SmartDashboard::PutNumber("vth", vth);
+    telemetry::Set( dash.vx, vx );
+    telemetry::Set( dash.vy, vy );
+    telemetry::Set( dash.vth, vth );
 
-    frc::SmartDashboard::PutBoolean("Stop Button",  hardware->GetStopButton() );
+    telemetry::Set( dash.stop_button, hardware->GetStopButton() );
 
-    frc::SmartDashboard::PutNumber("desired_vx",  desired_vx );
-    frc::SmartDashboard::PutNumber("desired_vy",  desired_vy );
-    frc::SmartDashboard::PutNumber("desired_vth", desired_vth );
+    telemetry::Set( dash.desired_vx, desired_vx );
+    telemetry::Set( dash.desired_vy, desired_vy );
+    telemetry::Set( dash.desired_vth, desired_vth );
 
-    std::cout << "x: " << x_global << " y: " << y_global << " th: " << th_global << std::endl;
+    // Called from every cmd_drive, the console only needs a few per second
+    LOG_INFO_EVERY( 500, "x: %g y: %g th: %g", x_global, y_global, th_global );
 
 }
 
-double Movement::get_x() { return x_global;  }
+double Movement::get_x() { return odometry.GetPose().x;  }
 
-double Movement::get_y() { return y_global;  }
+double Movement::get_y() { return odometry.GetPose().y;  }
 
-double Movement::get_th(){ return th_global; }
+double Movement::get_th(){ return odometry.GetPose().th; }
 
 void Movement::angular_align(){
 
-    printf("Starting Angular Aligment");
+    LOG_INFO( "Starting Angular Aligment" );
 
-    frc::SmartDashboard::PutString("Process",  "Angular Align" );
+    telemetry::Set( dash.process, "Angular Align" );
 
     int count = 0;
 
     Twist cmd;
 
+    Rate rate( 20, &angular_loop );
+
     while( count < 3 ){
 
         sensor->Periodic();
@@ -318,19 +434,20 @@ void Movement::angular_align(){
 
         cmd_drive( cmd.linear.x, cmd.linear.y, cmd.angular.z );
 
-        delay(20);
+        rate.Sleep();
     }
 }
 
 void Movement::line_align( std::string direction ){
 
-    frc::SmartDashboard::PutString("Process",  "Cobra Align" );
+    telemetry::Set( dash.process, "Cobra Align" );
 
     bool cobra_l  = false;
     bool cobra_r  = false;
     bool cobra_cl = false;
     bool cobra_cr = false;
 
+    Rate rate( 50, &line_loop );
 
     while( !cobra_cl || !cobra_cr ){
         sensor->Periodic();
@@ -365,10 +482,10 @@ void Movement::line_align( std::string direction ){
             break;
         }
 
-        frc::SmartDashboard::PutNumber("des_ang", des_ang );
-        frc::SmartDashboard::PutNumber("get_th()", get_th() );
+        telemetry::Set( dash.des_ang, des_ang );
+        telemetry::Set( dash.get_th, get_th() );
 
-        delay(50);
+        rate.Sleep();
     }
     cmd_drive( 0, 0, 0 );  
     delay(500);
@@ -0,0 +1,160 @@
+/************************************
+ * Odometry
+ * Dead reckoning of the robot pose from the wheel encoders and the navX.
+ *************************************/
+
+#include "Odometry.h"
+#include "Constants.h"
+#include "Functions.h"
+#include "LoopMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    metrics::Loop odometry_loop( "odometry" );
+
+    constexpr double deg = M_PI / 180.0;
+
+    double WrapHeading( double th ){
+        th = std::fmod( th, 360.0 );
+        return th < 0 ? th + 360 : th;
+    }
+}
+
+void Odometry::Start( int priority, int cpu ){
+    if( thread.IsRunning() ){ return; }
+
+    if( !configured ){
+        thread.AddTask( "step", period, [this]{ Step(); } );
+        configured = true;
+    }
+
+    thread.Start( priority, cpu );
+}
+
+void Odometry::Stop(){
+    thread.Stop();
+}
+
+void Odometry::Step(){
+    metrics::ScopedTimer timer( odometry_loop );
+
+    OdometrySample s;
+    hardware->ReadOdometry( s );
+
+    std::lock_guard<std::mutex> lock( mutex );
+
+    if( !primed ){
+        last = s;
+        primed = true;
+        Publish( s.stamp_ns );
+        return;
+    }
+
+    const double dl = ( s.left  - last.left  ) * constant::DIST_PER_TICK;    // [cm]
+    const double dr = ( s.right - last.right ) * constant::DIST_PER_TICK;
+    const double ds = ( dl + dr ) / 2;
+    const double dth_gyro   = -close_angle( s.yaw - last.yaw ) * deg;        // [rad] counter clockwise
+    const double dth_wheels = ( dr - dl ) / ( 2 * constant::FRAME_RADIUS );
+    const double dt = ( s.stamp_ns - last.stamp_ns ) * 1e-9;                  // [s]
+
+    const double th_before = filter.Get( PoseFilter::TH );
+    filter.Predict( ds, dth_gyro, std::max( dt, 0.0 ) );
+
+    if( dt > 0 ){
+        v = ds / dt;
+        w = std::remainder( filter.Get( PoseFilter::TH ) - th_before, 2 * M_PI ) / dt;
+    }
+    last = s;
+
+    if( fusion.load( std::memory_order_relaxed ) ){
+        filter.UpdateTurnRate( dth_gyro, dth_wheels, dt );
+
+        RangeObservation batch[max_observations];
+        int count;
+        {
+            std::lock_guard<std::mutex> observe_lock( observe_mutex );
+            count = observation_count;
+            std::copy( observations, observations + count, batch );
+            observation_count = 0;
+        }
+        for( int i = 0; i < count; i++ ){
+            const double age = ( s.stamp_ns - batch[i].stamp_ns ) * 1e-9;
+            if( age > max_age ){ continue; }
+            filter.Update( batch[i], v * age, w * age );
+        }
+    }
+
+    uint32_t version;
+    PoseSample delta = correction.Load( version );
+    if( version != applied_correction ){
+        filter.Shift( delta.x, delta.y, delta.th * deg );
+        applied_correction = version;
+    }
+
+    Publish( s.stamp_ns );
+}
+
+void Odometry::SetPose( double x, double y, double th ){
+    OdometrySample s;
+    hardware->ReadOdometry( s );
+
+    std::lock_guard<std::mutex> lock( mutex );
+
+    filter.Reset( x, y, th * deg );
+    v = w = 0;
+
+    // Later steps integrate from here
+    last = s;
+    primed = true;
+
+    applied_correction = correction.Version();   // Pending corrections refer to the old pose
+    Publish( s.stamp_ns );
+}
+
+uint32_t Odometry::Correct( double dx, double dy, double dth ){
+    PoseSample delta;
+    delta.x  = dx;
+    delta.y  = dy;
+    delta.th = dth;
+    delta.stamp_ns = timing::NowNs();
+    correction.Store( delta );
+    return correction.Version();
+}
+
+void Odometry::SetFusion( bool enabled ){
+    fusion.store( enabled, std::memory_order_relaxed );
+    if( enabled ){ return; }
+
+    std::lock_guard<std::mutex> lock( observe_mutex );
+    observation_count = 0;
+}
+
+void Odometry::Observe( const RangeObservation & o ){
+    if( !fusion.load( std::memory_order_relaxed ) ){ return; }
+
+    std::lock_guard<std::mutex> lock( observe_mutex );
+
+    // The newest readings matter most, drop the oldest one
+    if( observation_count == max_observations ){
+        std::copy( observations + 1, observations + max_observations, observations );
+        observation_count--;
+    }
+    observations[observation_count++] = o;
+}
+
+void Odometry::Publish( int64_t stamp_ns ){
+    PoseSample p;
+    p.x  = filter.Get( PoseFilter::X );
+    p.y  = filter.Get( PoseFilter::Y );
+    p.th = WrapHeading( filter.Get( PoseFilter::TH ) / deg );
+    p.v  = v;
+    p.w  = w;
+    p.sigma_xy = std::sqrt( std::max( filter.Variance( PoseFilter::X ), filter.Variance( PoseFilter::Y ) ) );
+    p.sigma_th = std::sqrt( filter.Variance( PoseFilter::TH ) ) / deg;
+    p.stamp_ns   = stamp_ns;
+    p.correction = applied_correction;
+    p.fused      = filter.GetAccepted();
+    snapshot.Store( p );
+}
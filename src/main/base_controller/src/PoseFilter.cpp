@@ -0,0 +1,208 @@
+/************************************
+ * PoseFilter
+ * Extended Kalman filter of the robot pose on the field.
+ *************************************/
+
+#include "PoseFilter.h"
+#include "Functions.h"
+
+#include <cmath>
+
+namespace {
+    constexpr double deg = M_PI / 180.0;
+
+    // Mount position and axis on the field from pose s
+    void MountPose( const SensorMount & m, const double * s, double & px, double & py, double & dx, double & dy ){
+        const double c = std::cos( s[PoseFilter::TH] );
+        const double n = std::sin( s[PoseFilter::TH] );
+        px = s[PoseFilter::X] + m.x * c - m.y * n;
+        py = s[PoseFilter::Y] + m.x * n + m.y * c;
+        dx = std::cos( s[PoseFilter::TH] + m.th * deg );
+        dy = std::sin( s[PoseFilter::TH] + m.th * deg );
+    }
+}
+
+void PoseFilter::Reset( double x, double y, double th ){
+    const double bias_var = cov[BIAS][BIAS];
+
+    state[X]  = x;
+    state[Y]  = y;
+    state[TH] = std::remainder( th, 2 * M_PI );
+
+    for( auto & row : cov ){ for( double & c : row ){ c = 0; } }
+    cov[X][X]   = initial_xy * initial_xy;
+    cov[Y][Y]   = initial_xy * initial_xy;
+    cov[TH][TH] = initial_th * initial_th;
+    cov[BIAS][BIAS] = bias_var;
+}
+
+void PoseFilter::Predict( double ds, double dth_gyro, double dt ){
+    const double dth  = dth_gyro - state[BIAS] * dt;
+
+    // Chord of the arc, sin(a)/a -> 1 on straight lines
+    const double half  = dth / 2;
+    const double k     = std::fabs( half ) < 1e-6 ? 1.0 : std::sin( half ) / half;
+    const double chord = ds * k;
+    const double mid   = state[TH] + half;
+    const double c = std::cos( mid );
+    const double s = std::sin( mid );
+
+    state[X]  += chord * c;
+    state[Y]  += chord * s;
+    state[TH]  = std::remainder( state[TH] + dth, 2 * M_PI );
+
+    // Jacobians to first order, the chord length is taken as independent of the turn
+    const double F[N][N] = { { 1, 0, -chord * s, chord * s * dt / 2 },
+                             { 0, 1,  chord * c, -chord * c * dt / 2 },
+                             { 0, 0,  1,         -dt },
+                             { 0, 0,  0,          1 } };
+    const double G[N][2] = { { k * c, -chord * s / 2 },
+                             { k * s,  chord * c / 2 },
+                             { 0,      1 },
+                             { 0,      0 } };
+    const double q_ds   = ( wheel_slip * ds ) * ( wheel_slip * ds );
+    const double q_gyro = gyro_noise * gyro_noise * dt;
+
+    double FP[N][N];
+    for( int i = 0; i < N; i++ ){
+        for( int j = 0; j < N; j++ ){
+            double sum = 0;
+            for( int m = 0; m < N; m++ ){ sum += F[i][m] * cov[m][j]; }
+            FP[i][j] = sum;
+        }
+    }
+    for( int i = 0; i < N; i++ ){
+        for( int j = 0; j < N; j++ ){
+            double sum = G[i][0] * q_ds * G[j][0] + G[i][1] * q_gyro * G[j][1];
+            for( int m = 0; m < N; m++ ){ sum += FP[i][m] * F[j][m]; }
+            cov[i][j] = sum;
+        }
+    }
+    cov[BIAS][BIAS] += bias_walk * bias_walk * dt;
+}
+
+bool PoseFilter::UpdateTurnRate( double dth_gyro, double dth_wheels, double dt ){
+    if( dt <= 0 ){ return false; }
+
+    const double h[N] = { 0, 0, 0, 1 };
+    const double sigma = ( turn_slip * std::fabs( dth_wheels ) + turn_floor ) / dt;
+    return Fuse( h, ( dth_gyro - dth_wheels ) / dt - state[BIAS], sigma * sigma );
+}
+
+bool PoseFilter::Update( const RangeObservation & o, double ds, double dth ){
+    double h[N] = {};
+
+    // Pose when the reading was taken, the motion since is known well enough to be undone
+    double then[N];
+    for( int j = 0; j < N; j++ ){ then[j] = state[j]; }
+    then[TH] -= dth;
+    then[X]  -= ds * std::cos( state[TH] - dth / 2 );
+    then[Y]  -= ds * std::sin( state[TH] - dth / 2 );
+
+    if( o.kind == RangeObservation::HEADING ){
+        // Same estimate as Lidar::setAngle(), the walls are square to the field
+        const double measured = ( straight_ang( then[TH] / deg ) - o.value ) * deg;
+        h[TH] = 1;
+        return Count( Fuse( h, std::remainder( measured - then[TH], 2 * M_PI ), ( o.sigma * deg ) * ( o.sigma * deg ) ) );
+    }
+
+    const int wall = FacingWall( o, then );
+    if( wall < 0 ){ return Count( false ); }
+
+    // Central differences with the wall held, the model is piecewise
+    const double step[3] = { 0.01, 0.01, 1e-4 };
+    for( int i = 0; i < 3; i++ ){
+        double hi[N], lo[N];
+        for( int j = 0; j < N; j++ ){ hi[j] = lo[j] = then[j]; }
+        hi[i] += step[i];
+        lo[i] -= step[i];
+        h[i] = ( Expected( o, hi, wall ) - Expected( o, lo, wall ) ) / ( 2 * step[i] );
+    }
+
+    return Count( Fuse( h, o.value - Expected( o, then, wall ), o.sigma * o.sigma ) );
+}
+
+void PoseFilter::Shift( double dx, double dy, double dth ){
+    state[X]  += dx;
+    state[Y]  += dy;
+    state[TH]  = std::remainder( state[TH] + dth, 2 * M_PI );
+}
+
+double PoseFilter::Expected( const RangeObservation & o, const double * s, int wall ){
+    double px, py, dx, dy;
+    MountPose( o.mount, s, px, py, dx, dy );
+
+    const double size = constant::FIELD_SIZE;
+    const double gap  = wall == 0 ? size - px : wall == 1 ? size - py : wall == 2 ? -px : -py;
+
+    if( o.kind == RangeObservation::WALL ){ return std::fabs( gap ); }
+    return gap / ( wall == 0 || wall == 2 ? dx : dy );
+}
+
+int PoseFilter::FacingWall( const RangeObservation & o, const double * s ){
+    double px, py, dx, dy;
+    MountPose( o.mount, s, px, py, dx, dy );
+
+    const double size = constant::FIELD_SIZE;
+    const double t[4] = { dx >  1e-9 ? ( size - px ) / dx : -1,
+                          dy >  1e-9 ? ( size - py ) / dy : -1,
+                          dx < -1e-9 ? -px / dx : -1,
+                          dy < -1e-9 ? -py / dy : -1 };
+
+    int wall = -1;
+    for( int i = 0; i < 4; i++ ){
+        if( t[i] >= 0 && ( wall < 0 || t[i] < t[wall] ) ){ wall = i; }
+    }
+    if( wall < 0 ){ return -1; }
+
+    // Cosine between the axis and the wall normal
+    const double facing = std::fabs( wall == 0 || wall == 2 ? dx : dy );
+    return facing >= std::cos( max_incidence * deg ) ? wall : -1;
+}
+
+bool PoseFilter::Fuse( const double * h, double innovation, double variance ){
+    double ph[N];
+    double s = variance;
+    for( int i = 0; i < N; i++ ){
+        ph[i] = 0;
+        for( int j = 0; j < N; j++ ){ ph[i] += cov[i][j] * h[j]; }
+        s += h[i] * ph[i];
+    }
+
+    if( innovation * innovation > gate * gate * s ){ return false; }
+
+    double k[N];
+    for( int i = 0; i < N; i++ ){
+        k[i] = ph[i] / s;
+        state[i] += k[i] * innovation;
+    }
+    state[TH] = std::remainder( state[TH], 2 * M_PI );
+
+    // Joseph form, keeps the covariance symmetric and positive
+    double a[N][N];
+    for( int i = 0; i < N; i++ ){
+        for( int j = 0; j < N; j++ ){ a[i][j] = ( i == j ) - k[i] * h[j]; }
+    }
+    double ap[N][N];
+    for( int i = 0; i < N; i++ ){
+        for( int j = 0; j < N; j++ ){
+            double sum = 0;
+            for( int m = 0; m < N; m++ ){ sum += a[i][m] * cov[m][j]; }
+            ap[i][j] = sum;
+        }
+    }
+    for( int i = 0; i < N; i++ ){
+        for( int j = 0; j < N; j++ ){
+            double sum = k[i] * variance * k[j];
+            for( int m = 0; m < N; m++ ){ sum += ap[i][m] * a[j][m]; }
+            cov[i][j] = sum;
+        }
+    }
+
+    return true;
+}
+
+bool PoseFilter::Count( bool fused ){
+    fused ? accepted++ : rejected++;
+    return fused;
+}
@@ -13,24 +13,13 @@
 
 #include "Movement.h"
 #include "Oms.h"
+#include "FruitDetector.h"
+#include "RoiPredictor.h"
+#include "Telemetry.h"
 
 using namespace cv;
 using namespace std;
 
-struct ObjectCam {
-    string name;
-    Scalar lower_limit;
-    Scalar upper_limit;
-    Scalar lower_limit_2;
-    Scalar upper_limit_2;
-    int open_iteration;
-    int close_iteration;
-    int min_area;
-    int max_area;
-    int area;
-    bool use_second_mask;
-};
-
 class Camera{
     public:
         Camera( Movement * m, Oms * o, Hardware * h ) : move{m}, oms{o}, hard{h}{}
@@ -55,5 +44,19 @@ class Camera{
             {"basket_stand", {20,100,100},{40,255,255}, {}, {}, 2, 2, 1000, 25000, 8000, false}
         };
 
+        FruitDetector detector{ objects };      // After objects, it keeps its own copy
+        RoiPredictor tracker;
+
+        struct Dashboard {
+            telemetry::String process = telemetry::AddString( "Process" );
+            telemetry::Number vel_x   = telemetry::AddNumber( "vel_x" );
+            telemetry::Number vel_y   = telemetry::AddNumber( "vel_y" );
+            telemetry::Number vel_z   = telemetry::AddNumber( "vel_z" );
+            telemetry::Boolean tracking   = telemetry::AddBoolean( "cam_tracking" );
+            telemetry::Number label_ms    = telemetry::AddNumber( "cam_label_ms" );
+            telemetry::Number segment_ms  = telemetry::AddNumber( "cam_segment_ms" );
+            telemetry::Number latency_ms  = telemetry::AddNumber( "cam_latency_ms" );
+        } dash;
+
     
 };
\ No newline at end of file
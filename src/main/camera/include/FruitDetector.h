@@ -0,0 +1,140 @@
+/************************************
+ * FruitDetector
+ * Pipelined color segmentation for the visual servo.
+ *
+ * Capture thread -> grabs a frame, halves it and publishes it.
+ * Detect thread  -> labels the newest frame with every selected object's
+ *                   color ranges in one fused pass (HsvThresholdKernel),
+ *                   then cleans and traces each object in parallel with
+ *                   its own preallocated masks and publishes the largest blob.
+ * Control        -> the caller waits for the next detection and only
+ *                   runs the servo on it.
+ *
+ * Tracking mode: once the caller is locked on a target it passes the
+ * predicted box with Track(). The detect thread then labels and segments
+ * only that region for that object, and falls back to a full frame search
+ * of the same frame when the target is not found inside it.
+ *
+ * Frames and detections are exchanged through triple buffers, so a slow
+ * stage drops old frames instead of delaying the next one. All image
+ * buffers are allocated by the first frame and reused afterwards.
+ *************************************/
+
+#pragma once
+
+#include <cameraserver/CameraServer.h>
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HsvThreshold.h"
+#include "TripleBuffer.h"
+
+struct ObjectCam {
+    std::string name;
+    cv::Scalar lower_limit;
+    cv::Scalar upper_limit;
+    cv::Scalar lower_limit_2;
+    cv::Scalar upper_limit_2;
+    int open_iteration;
+    int close_iteration;
+    int min_area;
+    int max_area;
+    int area;
+    bool use_second_mask;
+};
+
+struct CameraFrame {
+    uint64_t generation = 0;
+    int64_t stamp_ns = 0;       // CLOCK_MONOTONIC time of the grab
+    cv::Mat image;              // BGR, half the camera resolution
+};
+
+struct FruitDetection {
+    uint64_t generation = 0;    // Of the frame it was computed on
+    int64_t stamp_ns = 0;
+    bool found = false;
+    int object = -1;            // Index in the detector's object list
+    double area = 0;            // [px^2] at the detection resolution
+    cv::Rect box;
+    std::vector<cv::Point> contour;
+    cv::Mat image;              // The frame the detection belongs to
+
+    bool tracking = false;      // Found inside the tracked region, no full frame search
+    cv::Rect roi;               // Region the detection comes from, the whole frame unless tracking
+    double label_ms = 0;        // Stage timings of this frame
+    double segment_ms = 0;
+    double latency_ms = 0;      // Frame grab to publish
+};
+
+class FruitDetector
+{
+    public:
+        FruitDetector( const std::vector<ObjectCam> & objects );
+        ~FruitDetector(){ Stop(); }
+
+        // Segments only the objects whose names are listed, at most HsvThresholdKernel::max_objects
+        void Start( cs::CvSink sink, const std::vector<std::string> & names );
+        void Stop();
+        bool IsRunning() const { return running; }
+
+        // Blocks until a detection newer than the last one returned, false on timeout or Stop().
+        // The reference stays valid until the next call.
+        bool WaitDetection( const FruitDetection * & detection, double timeout_ms );
+
+        // Searches only roi (detection resolution) for object in the next frames, until
+        // Untrack() or a miss. object is an index in the detector's object list.
+        void Track( int object, const cv::Rect & roi );
+        void Untrack();
+
+        const ObjectCam & GetObject( int index ) const { return objects[index]; }
+        uint64_t GetCaptureErrors() const { return capture_errors; }
+
+        static constexpr double scale = 0.5;    // Detection resolution relative to the camera
+
+    private:
+        // Per object state, only touched by the worker segmenting that object
+        struct Worker {
+            int object;
+            uint8_t bit;                // Of the object in the label image
+            cv::Mat mask;
+            std::vector<std::vector<cv::Point>> contours;
+            int best = -1;              // Contour index of the largest valid blob
+            double best_area = 0;
+        };
+
+        void CaptureLoop();
+        void DetectLoop();
+        void Label( const cv::Mat & image, const cv::Rect & roi );
+        void Segment( Worker & w, const cv::Rect & roi );
+        bool Search( const cv::Mat & image, const cv::Rect & roi, Worker * only, FruitDetection & d );
+
+        const std::vector<ObjectCam> objects;
+        const cv::Mat kernel;
+        std::vector<Worker> workers;
+
+        cs::CvSink sink;
+        cv::Mat raw;                    // Capture thread only
+        HsvThresholdKernel threshold;
+        cv::Mat labels;                 // Detect thread only
+        int track_object = -1;          // Guarded by mutex, -1 searches the whole frame
+        cv::Rect track_roi;
+        std::atomic<uint64_t> capture_errors{0};
+
+        TripleBuffer<CameraFrame> frames;
+        TripleBuffer<FruitDetection> detections;
+        uint64_t frame_generation = 0;
+        uint64_t start_generation = 0;  // Frames up to this one belong to an earlier Start()
+
+        std::mutex mutex;
+        std::condition_variable frame_ready;
+        std::condition_variable detection_ready;
+        std::atomic<bool> running{false};
+        std::thread capture_thread;
+        std::thread detect_thread;
+};
@@ -0,0 +1,58 @@
+/************************************
+ * HsvThreshold
+ * Fused BGR -> HSV conversion and multi-object color thresholding.
+ *
+ * One pass over the BGR image converts every pixel to HSV with OpenCV's
+ * integer formulas (H in [0, 180), bit exact with cv::cvtColor) and tests
+ * it against the ranges of up to 8 objects. The output is a label image
+ * where bit k is set when the pixel is inside any range of object k,
+ * replacing one cvtColor plus an inRange per range and a bitwise_or.
+ *
+ * Rows are processed in short segments held in stack buffers (SSE2 /
+ * NEON, scalar fallback), so Label() is thread safe and can be split
+ * across rows.
+ *************************************/
+
+#pragma once
+
+#include <cstdint>
+
+struct HsvRange {
+    uint8_t lower[3];       // H, S, V inclusive, as cv::inRange
+    uint8_t upper[3];
+};
+
+class HsvThresholdKernel
+{
+    public:
+        static constexpr int max_objects = 8;
+        static constexpr int max_ranges  = 16;
+
+        HsvThresholdKernel();
+
+        void Clear(){ range_count = 0; }
+
+        // Adds a range to object 0..7, false when the ranges are full
+        bool AddRange( int object, const HsvRange & range );
+
+        // bgr: 8 bit, 3 channels. labels: 8 bit, 1 channel. Steps are in bytes.
+        void Label( const uint8_t * bgr, int bgr_step, uint8_t * labels, int label_step,
+                    int width, int height ) const;
+
+        // Reference conversion, the same integer math as OpenCV's COLOR_BGR2HSV
+        static void BgrToHsv( uint8_t b, uint8_t g, uint8_t r, uint8_t & h, uint8_t & s, uint8_t & v );
+
+        static constexpr int segment = 256;     // Pixels converted per stack buffer
+
+    private:
+        void LabelSegment( const uint8_t * bgr, uint8_t * labels, int count ) const;
+
+        struct Range {
+            uint8_t bit;
+            uint8_t lower[3];
+            uint8_t upper[3];
+        };
+
+        Range ranges[max_ranges];
+        int range_count = 0;
+};
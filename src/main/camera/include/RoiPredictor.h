@@ -0,0 +1,48 @@
+/************************************
+ * RoiPredictor
+ * Predicts where a tracked target will be in the next frames, so the
+ * FruitDetector only has to search a small region around it.
+ *
+ * The image motion of the target is measured from consecutive detections.
+ * It is only extrapolated along the axes the servo is commanding: when the
+ * base, lift or arm stop, the target stops in the image too. The region is
+ * the predicted box plus a margin that grows with the predicted motion.
+ *************************************/
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <cstdint>
+
+#include "FruitDetector.h"
+
+class RoiPredictor
+{
+    public:
+        void Reset(){ valid = false; }
+        bool IsValid() const { return valid; }
+
+        // Feeds a detection, a miss or a different object restarts the prediction
+        void Update( const FruitDetection & d );
+
+        // Search region for the next frames. cmd_x, cmd_y and cmd_depth are the commanded
+        // motions moving the target horizontally, vertically and towards the camera,
+        // only compared with zero. Empty when there is nothing to track.
+        cv::Rect Predict( double cmd_x, double cmd_y, double cmd_depth, const cv::Size & frame ) const;
+
+        static constexpr double margin       = 0.5;     // Of the box size, on each side
+        static constexpr int    min_margin   = 8;       // [px]
+        static constexpr double frame_period = 1 / 30.0;   // [s] Added to the prediction horizon
+        static constexpr double max_gap      = 0.25;    // [s] Between detections to measure the motion
+        static constexpr double filter       = 0.5;     // Weight of the newest motion measurement
+
+    private:
+        bool valid = false;
+        int object = -1;
+        int64_t stamp_ns = 0;
+        cv::Point2d center;         // [px]
+        cv::Size2d size;            // [px]
+        cv::Point2d velocity;       // [px/s]
+        double growth = 0;          // Relative size change [1/s]
+};
@@ -1,4 +1,9 @@
 #include "Camera.h"
+#include "LoopMetrics.h"
+
+namespace {
+    metrics::Loop detect_loop( "detect_fruit" );
+}
 
 void Camera::StartCamera(){
     cs::UsbCamera mainCamera = frc::CameraServer::GetInstance() -> StartAutomaticCapture();
@@ -9,7 +14,7 @@ void Camera::StartCamera(){
 
 void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bool use_area ){
     
-    frc::SmartDashboard::PutString("Process",  "Fruit Detection" );
+    telemetry::Set( dash.process, "Fruit Detection" );
 
     cs::CvSink cvSink = frc::CameraServer::GetInstance()->GetVideo();
 
@@ -17,7 +22,11 @@ void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bo
     frc::Shuffleboard::GetTab("MainData").Add("CameraProcess", frameStream).WithPosition(0, 0).WithSize(10, 5);
 
 
-    Mat frame;
+    // Capture and segmentation run on their own threads, this loop only servos on the newest result
+    detector.Start( cvSink, obj_names );
+    tracker.Reset();
+
+    Mat frame;      // Overlay, reuses its buffer every frame
 
     double position[3];
     int count = 0;
@@ -33,64 +42,32 @@ void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bo
     int base_ang = straight_ang( oms->base );
 
     while (true) {
-        if (cvSink.GrabFrame(frame) == 0) {
-            frameStream.NotifyError(cvSink.GetError());
+        const FruitDetection * detection;
+        if (!detector.WaitDetection(detection, 500)) {
             continue;
         }
 
+        // Late is the age of the frame when the servo gets it
+        metrics::ScopedTimer iteration(detect_loop);
+        detect_loop.RecordLate(timing::NowNs() - detection->stamp_ns);
+
         limit_switch_high = hard->GetLimitHigh();
         limit_switch_low  = hard->GetLimitLow();
 
         //Camera Code Implementation -> From here:
 
-        resize(frame, frame, Size(), 0.5, 0.5);
-        // rectangle(frame, Rect(0, 0, frame.cols, 60), Scalar(0, 0, 0), FILLED);   // Black Rectangle on top
-
-        Mat hsv;
-        cvtColor(frame, hsv, COLOR_BGR2HSV);
-
-        vector<pair<ObjectCam, vector<vector<Point>>>> contour_list;
-
-
-        for (const auto& obj : objects) {
-            if (find(obj_names.begin(), obj_names.end(), obj.name) != obj_names.end()) {
-                Mat mask, mask2;
-                inRange(hsv, obj.lower_limit, obj.upper_limit, mask);
-                if (obj.use_second_mask) {
-                    inRange(hsv, obj.lower_limit_2, obj.upper_limit_2, mask2);
-                    bitwise_or(mask, mask2, mask);
-                }
-
-                Mat kernel = getStructuringElement(MORPH_RECT, Size(3, 3));
-                morphologyEx(mask, mask, MORPH_OPEN, kernel, Point(-1, -1), obj.open_iteration);
-                morphologyEx(mask, mask, MORPH_CLOSE, kernel, Point(-1, -1), obj.close_iteration);
-
-                vector<vector<Point>> contours;
-                findContours(mask, contours, RETR_TREE, CHAIN_APPROX_SIMPLE);
-                contour_list.emplace_back(obj, contours);
-            }
-        }
+        detection->image.copyTo(frame);
 
         int max_area = 0, x = 0, y = 0, w = 0, h = 0;
-        string color = "";
         int des_area = 0;
-        vector<vector<Point>> contour;
-
-
-        for (auto& item : contour_list) {
-            const ObjectCam& obj = item.first;
-            for (const auto& cnt : item.second) {
-                double area = contourArea(cnt);
-                Rect rect = boundingRect(cnt);
-                if (area > max_area && area > obj.min_area && area < obj.max_area) {
-                    x = rect.x; y = rect.y;
-                    w = rect.width; h = rect.height;
-                    max_area = area;
-                    color = obj.name;
-                    des_area = obj.area;
-                    contour = item.second;
-                }
-            }
+
+        tracker.Update(*detection);
+
+        if (detection->found) {
+            x = detection->box.x; y = detection->box.y;
+            w = detection->box.width; h = detection->box.height;
+            max_area = detection->area;
+            des_area = detector.GetObject(detection->object).area;
         }
 
         int obj_x = x + w / 2;
@@ -191,7 +168,19 @@ void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bo
 
         }
 
-        drawContours(frame, contour, -1, cv::Scalar(0, 255, 0), 2);
+        // Locked on: the next frames only search around where the commanded motion takes the target
+        if (find_obj && detection->found) {
+            detector.Track(detection->object, tracker.Predict(fabs(vel_x) + fabs(vth), vel_z, vel_y, frame.size()));
+        }else{
+            detector.Untrack();
+        }
+
+        if (detection->tracking) {
+            cv::rectangle(frame, detection->roi, cv::Scalar(255, 0, 0), 1);
+        }
+        if (detection->found) {
+            polylines(frame, detection->contour, true, cv::Scalar(0, 255, 0), 2);
+        }
 
         std::string text = std::to_string( obj_x ) + ", " + std::to_string( obj_y ) + ", " + std::to_string( y_unit );
         cv::putText(frame, text, Point(obj_x, obj_y), cv::FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0,0,255), 2);
@@ -201,9 +190,13 @@ void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bo
         // cout << "Color: " << color << " Area: "  << max_area << " obj_x: " << obj_x << " obj_y: " << obj_y << endl;
         // cout << "vel_x: " << vel_x << " vel_y: " << vel_y    << " vel_z: " << vel_z << " vth: "   << vth   << endl;
 
-        frc::SmartDashboard::PutNumber("vel_x",  vel_x );
-        frc::SmartDashboard::PutNumber("vel_y",  vel_y );
-        frc::SmartDashboard::PutNumber("vel_z",  vel_z );
+        telemetry::Set( dash.vel_x, vel_x );
+        telemetry::Set( dash.vel_y, vel_y );
+        telemetry::Set( dash.vel_z, vel_z );
+        telemetry::Set( dash.tracking, detection->tracking );
+        telemetry::Set( dash.label_ms, detection->label_ms );
+        telemetry::Set( dash.segment_ms, detection->segment_ms );
+        telemetry::Set( dash.latency_ms, detection->latency_ms );
 
         current_time = time.Get();
         double delta_time = current_time - previous_time; // [s]
@@ -220,6 +213,8 @@ void Camera::DetectFruit( vector<string> obj_names, double angle, bool debug, bo
 
     }
 
+    detector.Stop();
+
     // destroyAllWindows();
 }
 
@@ -0,0 +1,251 @@
+/************************************
+ * FruitDetector
+ * Pipelined color segmentation for the visual servo.
+ *************************************/
+
+#include "FruitDetector.h"
+#include "Log.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+    // cv::inRange rounds and saturates Scalar bounds the same way
+    HsvRange ToRange( const cv::Scalar & lower, const cv::Scalar & upper ){
+        HsvRange r;
+        for( int c = 0; c < 3; c++ ){
+            r.lower[c] = cv::saturate_cast<uint8_t>( lower[c] );
+            r.upper[c] = cv::saturate_cast<uint8_t>( upper[c] );
+        }
+        return r;
+    }
+
+}
+
+FruitDetector::FruitDetector( const std::vector<ObjectCam> & objects )
+    : objects{objects}, kernel{ cv::getStructuringElement( cv::MORPH_RECT, cv::Size( 3, 3 ) ) }{}
+
+void FruitDetector::Start( cs::CvSink video, const std::vector<std::string> & names ){
+    if( running ){ Stop(); }
+
+    workers.clear();
+    threshold.Clear();
+    for( size_t i = 0; i < objects.size(); i++ ){
+        const ObjectCam & obj = objects[i];
+        if( std::find( names.begin(), names.end(), obj.name ) == names.end() ){ continue; }
+
+        const int k = static_cast<int>( workers.size() );
+        if( k == HsvThresholdKernel::max_objects ){
+            LOG_WARN( "[Camera] Only %d objects can be detected at once, ignoring %s", k, obj.name );
+            continue;
+        }
+
+        threshold.AddRange( k, ToRange( obj.lower_limit, obj.upper_limit ) );
+        if( obj.use_second_mask ){ threshold.AddRange( k, ToRange( obj.lower_limit_2, obj.upper_limit_2 ) ); }
+
+        Worker w;
+        w.object = static_cast<int>( i );
+        w.bit    = static_cast<uint8_t>( 1 << k );
+        workers.push_back( std::move( w ) );
+    }
+
+    sink = video;
+    start_generation = frame_generation;
+    track_object = -1;
+
+    running = true;
+    capture_thread = std::thread( &FruitDetector::CaptureLoop, this );
+    detect_thread  = std::thread( &FruitDetector::DetectLoop,  this );
+}
+
+void FruitDetector::Stop(){
+    if( !running ){ return; }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        running = false;
+    }
+    frame_ready.notify_all();
+    detection_ready.notify_all();
+
+    if( capture_thread.joinable() ){ capture_thread.join(); }
+    if( detect_thread.joinable() ){ detect_thread.join(); }
+}
+
+bool FruitDetector::WaitDetection( const FruitDetection * & detection, double timeout_ms ){
+    std::unique_lock<std::mutex> lock( mutex );
+    bool ready = detection_ready.wait_for( lock, std::chrono::duration<double, std::milli>( timeout_ms ),
+                                           [this]{ return detections.HasNew() || !running; } );
+    lock.unlock();
+    if( !ready || !detections.HasNew() ){ return false; }
+
+    detection = &detections.Acquire();
+    return detection->generation > start_generation;
+}
+
+void FruitDetector::Track( int object, const cv::Rect & roi ){
+    std::lock_guard<std::mutex> lock( mutex );
+    track_object = object;
+    track_roi = roi;
+}
+
+void FruitDetector::Untrack(){
+    std::lock_guard<std::mutex> lock( mutex );
+    track_object = -1;
+}
+
+void FruitDetector::CaptureLoop(){
+
+    while( running ){
+        // Times out after a fraction of a second, so Stop() is never stuck here
+        if( sink.GrabFrame( raw ) == 0 ){
+            capture_errors++;
+            LOG_WARN_EVERY( 1000, "[Camera] Frame grab failed: %s", sink.GetError() );
+            continue;
+        }
+
+        CameraFrame & frame = frames.WriteBuffer();
+        cv::resize( raw, frame.image, cv::Size(), scale, scale );
+        frame.generation = ++frame_generation;
+        frame.stamp_ns   = timing::NowNs();
+        frames.Publish();
+
+        { std::lock_guard<std::mutex> lock( mutex ); }
+        frame_ready.notify_one();
+    }
+}
+
+void FruitDetector::DetectLoop(){
+
+    while( true ){
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            frame_ready.wait( lock, [this]{ return frames.HasNew() || !running; } );
+            if( !running ){ return; }
+        }
+
+        const CameraFrame & frame = frames.Acquire();
+        const cv::Mat & image = frame.image;
+        const cv::Rect full( 0, 0, image.cols, image.rows );
+
+        int object;
+        cv::Rect requested;
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            object = track_object;
+            requested = track_roi;
+        }
+
+        labels.create( image.rows, image.cols, CV_8UC1 );
+        Worker * tracked = nullptr;
+        for( Worker & w : workers ){
+            w.mask.create( image.rows, image.cols, CV_8UC1 );
+            if( w.object == object ){ tracked = &w; }
+        }
+
+        FruitDetection & d = detections.WriteBuffer();
+        d.label_ms = 0;
+        d.segment_ms = 0;
+
+        d.roi = requested & full;
+        d.tracking = tracked && !d.roi.empty() && Search( image, d.roi, tracked, d );
+        if( !d.tracking ){
+            // Lost inside the region, look for every object in the same frame
+            if( tracked ){
+                std::lock_guard<std::mutex> lock( mutex );
+                if( track_object == object && track_roi == requested ){ track_object = -1; }
+            }
+            d.roi = full;
+            Search( image, full, nullptr, d );
+        }
+
+        d.generation = frame.generation;
+        d.stamp_ns   = frame.stamp_ns;
+        frame.image.copyTo( d.image );
+        d.latency_ms = ( timing::NowNs() - frame.stamp_ns ) * 1e-6;
+        detections.Publish();
+
+        { std::lock_guard<std::mutex> lock( mutex ); }
+        detection_ready.notify_one();
+    }
+}
+
+bool FruitDetector::Search( const cv::Mat & image, const cv::Rect & roi, Worker * only, FruitDetection & d ){
+    const int64_t label_start = timing::NowNs();
+    Label( image, roi );
+
+    const int64_t segment_start = timing::NowNs();
+    if( only ){
+        Segment( *only, roi );
+    }else{
+        // Objects are independent, each one runs on a core of the OpenCV pool
+        cv::parallel_for_( cv::Range( 0, static_cast<int>( workers.size() ) ), [this, &roi]( const cv::Range & range ){
+            for( int i = range.start; i < range.end; i++ ){ Segment( workers[i], roi ); }
+        } );
+    }
+    const int64_t segment_end = timing::NowNs();
+
+    d.label_ms   += ( segment_start - label_start ) * 1e-6;
+    d.segment_ms += ( segment_end - segment_start ) * 1e-6;
+
+    const Worker * best = nullptr;
+    for( const Worker & w : workers ){
+        if( only && &w != only ){ continue; }
+        if( w.best >= 0 && ( !best || w.best_area > best->best_area ) ){ best = &w; }
+    }
+
+    d.found = best != nullptr;
+    if( best ){
+        const std::vector<cv::Point> & contour = best->contours[best->best];
+        d.object = best->object;
+        d.area   = best->best_area;
+        d.box    = cv::boundingRect( contour );
+        d.contour.assign( contour.begin(), contour.end() );
+    }else{
+        d.object = -1;
+        d.area   = 0;
+        d.box    = cv::Rect();
+        d.contour.clear();
+    }
+    return d.found;
+}
+
+void FruitDetector::Label( const cv::Mat & image, const cv::Rect & roi ){
+    const cv::Mat src = image( roi );
+    cv::Mat dst = labels( roi );
+
+    // One pass labels every object, split in row stripes over the OpenCV pool
+    cv::parallel_for_( cv::Range( 0, roi.height ), [&]( const cv::Range & rows ){
+        threshold.Label( src.ptr<uint8_t>( rows.start ), static_cast<int>( src.step ),
+                         dst.ptr<uint8_t>( rows.start ), static_cast<int>( dst.step ),
+                         src.cols, rows.end - rows.start );
+    } );
+}
+
+void FruitDetector::Segment( Worker & w, const cv::Rect & roi ){
+    const ObjectCam & obj = objects[w.object];
+    cv::Mat mask = w.mask( roi );
+
+    // Non zero where the object matched, the morphology and contours only look at that
+    cv::bitwise_and( labels( roi ), cv::Scalar( w.bit ), mask );
+
+    // Isolated, so a region never reads the stale mask around it
+    const int border = cv::BORDER_CONSTANT | cv::BORDER_ISOLATED;
+    cv::morphologyEx( mask, mask, cv::MORPH_OPEN,  kernel, cv::Point( -1, -1 ), obj.open_iteration,  border );
+    cv::morphologyEx( mask, mask, cv::MORPH_CLOSE, kernel, cv::Point( -1, -1 ), obj.close_iteration, border );
+
+    // Only outer boundaries matter for the blob area, holes are not traced. Points are in frame coordinates.
+    cv::findContours( mask, w.contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, roi.tl() );
+
+    w.best = -1;
+    w.best_area = 0;
+    for( size_t i = 0; i < w.contours.size(); i++ ){
+        double area = cv::contourArea( w.contours[i] );
+        if( area > w.best_area && area > obj.min_area && area < obj.max_area ){
+            w.best = static_cast<int>( i );
+            w.best_area = area;
+        }
+    }
+}
@@ -0,0 +1,302 @@
+/************************************
+ * HsvThreshold
+ * Fused BGR -> HSV conversion and multi-object color thresholding.
+ *************************************/
+
+#include "HsvThreshold.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define HSV_THRESHOLD_NEON 1
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define HSV_THRESHOLD_SSE 1
+#endif
+
+namespace {
+
+    constexpr int hsv_shift = 12;
+    constexpr int hsv_round = 1 << ( hsv_shift - 1 );
+
+    // OpenCV's division tables for 8 bit BGR -> HSV with H in [0, 180)
+    struct Tables {
+        int32_t sdiv[256];
+        int32_t hdiv[256];
+
+        Tables(){
+            sdiv[0] = hdiv[0] = 0;
+            for( int i = 1; i < 256; i++ ){
+                sdiv[i] = static_cast<int32_t>( std::lrint( ( 255 << hsv_shift ) / ( 1.0 * i ) ) );
+                hdiv[i] = static_cast<int32_t>( std::lrint( ( 180 << hsv_shift ) / ( 6.0 * i ) ) );
+            }
+        }
+    };
+
+    const Tables & GetTables(){
+        static const Tables tables;
+        return tables;
+    }
+
+    inline void Convert( const Tables & t, int b, int g, int r, uint8_t & h_out, uint8_t & s_out, uint8_t & v_out ){
+        int v = std::max( b, std::max( g, r ) );
+        int diff = v - std::min( b, std::min( g, r ) );
+        int vr = v == r ? -1 : 0;
+        int vg = v == g ? -1 : 0;
+
+        int s = ( diff * t.sdiv[v] + hsv_round ) >> hsv_shift;
+        int h = ( vr & ( g - b ) ) + ( ~vr & ( ( vg & ( b - r + 2 * diff ) ) + ( ~vg & ( r - g + 4 * diff ) ) ) );
+        h = ( h * t.hdiv[diff] + hsv_round ) >> hsv_shift;
+        h += h < 0 ? 180 : 0;
+
+        h_out = static_cast<uint8_t>( h );
+        s_out = static_cast<uint8_t>( s );
+        v_out = static_cast<uint8_t>( v );
+    }
+
+#if defined(HSV_THRESHOLD_SSE)
+    // _mm_mullo_epi32 is SSE4.1, the low half of the product is the same for signed values
+    inline __m128i Mul32( __m128i a, __m128i b ){
+        __m128i even = _mm_mul_epu32( a, b );
+        __m128i odd  = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+        return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+                                   _mm_shuffle_epi32( odd,  _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+    }
+
+    // ( x * table + round ) >> shift on 4 lanes, H wraps to [0, 180)
+    inline __m128i Scale( __m128i x, const int32_t * table_values ){
+        __m128i p = Mul32( x, _mm_load_si128( reinterpret_cast<const __m128i *>( table_values ) ) );
+        return _mm_srai_epi32( _mm_add_epi32( p, _mm_set1_epi32( hsv_round ) ), hsv_shift );
+    }
+
+    inline __m128i InRange( __m128i x, __m128i lower, __m128i upper ){
+        return _mm_and_si128( _mm_cmpeq_epi8( _mm_max_epu8( x, lower ), x ),
+                              _mm_cmpeq_epi8( _mm_min_epu8( x, upper ), x ) );
+    }
+#endif
+
+}
+
+HsvThresholdKernel::HsvThresholdKernel(){
+    GetTables();
+}
+
+bool HsvThresholdKernel::AddRange( int object, const HsvRange & range ){
+    if( object < 0 || object >= max_objects || range_count == max_ranges ){ return false; }
+
+    Range & r = ranges[range_count++];
+    r.bit = static_cast<uint8_t>( 1 << object );
+    for( int c = 0; c < 3; c++ ){
+        r.lower[c] = range.lower[c];
+        r.upper[c] = range.upper[c];
+    }
+    return true;
+}
+
+void HsvThresholdKernel::BgrToHsv( uint8_t b, uint8_t g, uint8_t r, uint8_t & h, uint8_t & s, uint8_t & v ){
+    Convert( GetTables(), b, g, r, h, s, v );
+}
+
+void HsvThresholdKernel::Label( const uint8_t * bgr, int bgr_step, uint8_t * labels, int label_step,
+                                int width, int height ) const {
+    for( int y = 0; y < height; y++ ){
+        const uint8_t * src = bgr + static_cast<size_t>( y ) * bgr_step;
+        uint8_t * dst = labels + static_cast<size_t>( y ) * label_step;
+        for( int x = 0; x < width; x += segment ){
+            LabelSegment( src + 3 * x, dst + x, std::min( segment, width - x ) );
+        }
+    }
+}
+
+void HsvThresholdKernel::LabelSegment( const uint8_t * bgr, uint8_t * labels, int count ) const {
+    const Tables & t = GetTables();
+
+    alignas(16) uint8_t h[segment];
+    alignas(16) uint8_t s[segment];
+    alignas(16) uint8_t v[segment];
+    int i = 0;
+
+#if defined(HSV_THRESHOLD_SSE) || defined(HSV_THRESHOLD_NEON)
+    alignas(16) uint8_t b[segment];
+    alignas(16) uint8_t g[segment];
+    alignas(16) uint8_t r[segment];
+    alignas(16) uint8_t d[segment];
+    alignas(16) int32_t sdiv[segment];
+    alignas(16) int32_t hdiv[segment];
+
+    const int simd_count = count & ~15;
+
+    // Planar channels, V and max - min
+#if defined(HSV_THRESHOLD_NEON)
+    for( i = 0; i < simd_count; i += 16 ){
+        uint8x16x3_t px = vld3q_u8( bgr + 3 * i );
+        uint8x16_t mx = vmaxq_u8( px.val[0], vmaxq_u8( px.val[1], px.val[2] ) );
+        uint8x16_t mn = vminq_u8( px.val[0], vminq_u8( px.val[1], px.val[2] ) );
+        vst1q_u8( b + i, px.val[0] );
+        vst1q_u8( g + i, px.val[1] );
+        vst1q_u8( r + i, px.val[2] );
+        vst1q_u8( v + i, mx );
+        vst1q_u8( d + i, vsubq_u8( mx, mn ) );
+    }
+#else
+    for( i = 0; i < simd_count; i++ ){
+        b[i] = bgr[3 * i];
+        g[i] = bgr[3 * i + 1];
+        r[i] = bgr[3 * i + 2];
+    }
+    for( i = 0; i < simd_count; i += 16 ){
+        __m128i B = _mm_load_si128( reinterpret_cast<const __m128i *>( b + i ) );
+        __m128i G = _mm_load_si128( reinterpret_cast<const __m128i *>( g + i ) );
+        __m128i R = _mm_load_si128( reinterpret_cast<const __m128i *>( r + i ) );
+        __m128i mx = _mm_max_epu8( B, _mm_max_epu8( G, R ) );
+        __m128i mn = _mm_min_epu8( B, _mm_min_epu8( G, R ) );
+        _mm_store_si128( reinterpret_cast<__m128i *>( v + i ), mx );
+        _mm_store_si128( reinterpret_cast<__m128i *>( d + i ), _mm_sub_epi8( mx, mn ) );
+    }
+#endif
+
+    // Table lookups have no vector form on either ISA, they stay in L1
+    for( i = 0; i < simd_count; i++ ){
+        sdiv[i] = t.sdiv[v[i]];
+        hdiv[i] = t.hdiv[d[i]];
+    }
+
+    // H and S, 16 pixels per step widened to 16 then 32 bits
+    for( i = 0; i < simd_count; i += 16 ){
+#if defined(HSV_THRESHOLD_NEON)
+        uint8x16_t B = vld1q_u8( b + i ), G = vld1q_u8( g + i ), R = vld1q_u8( r + i );
+        uint8x16_t V = vld1q_u8( v + i ), D = vld1q_u8( d + i );
+        int8x16_t vr = vreinterpretq_s8_u8( vceqq_u8( V, R ) );
+        int8x16_t vg = vreinterpretq_s8_u8( vceqq_u8( V, G ) );
+
+        uint8x8_t h_half[2], s_half[2];
+        for( int half = 0; half < 2; half++ ){
+            uint8x8_t b8 = half ? vget_high_u8( B ) : vget_low_u8( B );
+            uint8x8_t g8 = half ? vget_high_u8( G ) : vget_low_u8( G );
+            uint8x8_t r8 = half ? vget_high_u8( R ) : vget_low_u8( R );
+            uint8x8_t d8 = half ? vget_high_u8( D ) : vget_low_u8( D );
+            int16x8_t b16 = vreinterpretq_s16_u16( vmovl_u8( b8 ) );
+            int16x8_t g16 = vreinterpretq_s16_u16( vmovl_u8( g8 ) );
+            int16x8_t r16 = vreinterpretq_s16_u16( vmovl_u8( r8 ) );
+            uint16x8_t d16 = vmovl_u8( d8 );
+            uint16x8_t vr16 = vreinterpretq_u16_s16( vmovl_s8( half ? vget_high_s8( vr ) : vget_low_s8( vr ) ) );
+            uint16x8_t vg16 = vreinterpretq_u16_s16( vmovl_s8( half ? vget_high_s8( vg ) : vget_low_s8( vg ) ) );
+
+            int16x8_t ds = vreinterpretq_s16_u16( d16 );
+            int16x8_t t1 = vsubq_s16( g16, b16 );
+            int16x8_t t2 = vaddq_s16( vsubq_s16( b16, r16 ), vshlq_n_s16( ds, 1 ) );
+            int16x8_t t3 = vaddq_s16( vsubq_s16( r16, g16 ), vshlq_n_s16( ds, 2 ) );
+            int16x8_t hn = vbslq_s16( vr16, t1, vbslq_s16( vg16, t2, t3 ) );
+
+            int32x4_t h32[2], s32[2];
+            for( int q = 0; q < 2; q++ ){
+                const int k = i + half * 8 + q * 4;
+                int32x4_t hn32 = vmovl_s16( q ? vget_high_s16( hn ) : vget_low_s16( hn ) );
+                int32x4_t d32  = vreinterpretq_s32_u32( vmovl_u16( q ? vget_high_u16( d16 ) : vget_low_u16( d16 ) ) );
+
+                int32x4_t hq = vshrq_n_s32( vaddq_s32( vmulq_s32( hn32, vld1q_s32( hdiv + k ) ), vdupq_n_s32( hsv_round ) ), hsv_shift );
+                hq = vaddq_s32( hq, vandq_s32( vreinterpretq_s32_u32( vcltq_s32( hq, vdupq_n_s32( 0 ) ) ), vdupq_n_s32( 180 ) ) );
+                h32[q] = hq;
+                s32[q] = vshrq_n_s32( vaddq_s32( vmulq_s32( d32, vld1q_s32( sdiv + k ) ), vdupq_n_s32( hsv_round ) ), hsv_shift );
+            }
+            h_half[half] = vqmovun_s16( vcombine_s16( vqmovn_s32( h32[0] ), vqmovn_s32( h32[1] ) ) );
+            s_half[half] = vqmovun_s16( vcombine_s16( vqmovn_s32( s32[0] ), vqmovn_s32( s32[1] ) ) );
+        }
+        vst1q_u8( h + i, vcombine_u8( h_half[0], h_half[1] ) );
+        vst1q_u8( s + i, vcombine_u8( s_half[0], s_half[1] ) );
+#else
+        const __m128i zero = _mm_setzero_si128();
+        __m128i B = _mm_load_si128( reinterpret_cast<const __m128i *>( b + i ) );
+        __m128i G = _mm_load_si128( reinterpret_cast<const __m128i *>( g + i ) );
+        __m128i R = _mm_load_si128( reinterpret_cast<const __m128i *>( r + i ) );
+        __m128i V = _mm_load_si128( reinterpret_cast<const __m128i *>( v + i ) );
+        __m128i D = _mm_load_si128( reinterpret_cast<const __m128i *>( d + i ) );
+        __m128i vr = _mm_cmpeq_epi8( V, R );
+        __m128i vg = _mm_cmpeq_epi8( V, G );
+
+        __m128i h16[2], s16[2];
+        for( int half = 0; half < 2; half++ ){
+            __m128i b16  = half ? _mm_unpackhi_epi8( B, zero )   : _mm_unpacklo_epi8( B, zero );
+            __m128i g16  = half ? _mm_unpackhi_epi8( G, zero )   : _mm_unpacklo_epi8( G, zero );
+            __m128i r16  = half ? _mm_unpackhi_epi8( R, zero )   : _mm_unpacklo_epi8( R, zero );
+            __m128i d16  = half ? _mm_unpackhi_epi8( D, zero )   : _mm_unpacklo_epi8( D, zero );
+            __m128i vr16 = half ? _mm_unpackhi_epi8( vr, vr )    : _mm_unpacklo_epi8( vr, vr );
+            __m128i vg16 = half ? _mm_unpackhi_epi8( vg, vg )    : _mm_unpacklo_epi8( vg, vg );
+
+            __m128i t1 = _mm_sub_epi16( g16, b16 );
+            __m128i t2 = _mm_add_epi16( _mm_sub_epi16( b16, r16 ), _mm_slli_epi16( d16, 1 ) );
+            __m128i t3 = _mm_add_epi16( _mm_sub_epi16( r16, g16 ), _mm_slli_epi16( d16, 2 ) );
+            __m128i t23 = _mm_or_si128( _mm_and_si128( vg16, t2 ), _mm_andnot_si128( vg16, t3 ) );
+            __m128i hn = _mm_or_si128( _mm_and_si128( vr16, t1 ), _mm_andnot_si128( vr16, t23 ) );
+
+            __m128i h32[2], s32[2];
+            for( int q = 0; q < 2; q++ ){
+                const int k = i + half * 8 + q * 4;
+                __m128i hn32 = _mm_srai_epi32( q ? _mm_unpackhi_epi16( hn, hn ) : _mm_unpacklo_epi16( hn, hn ), 16 );
+                __m128i d32  = q ? _mm_unpackhi_epi16( d16, zero ) : _mm_unpacklo_epi16( d16, zero );
+
+                __m128i hq = Scale( hn32, hdiv + k );
+                hq = _mm_add_epi32( hq, _mm_and_si128( _mm_cmplt_epi32( hq, zero ), _mm_set1_epi32( 180 ) ) );
+                h32[q] = hq;
+                s32[q] = Scale( d32, sdiv + k );
+            }
+            h16[half] = _mm_packs_epi32( h32[0], h32[1] );
+            s16[half] = _mm_packs_epi32( s32[0], s32[1] );
+        }
+        _mm_store_si128( reinterpret_cast<__m128i *>( h + i ), _mm_packus_epi16( h16[0], h16[1] ) );
+        _mm_store_si128( reinterpret_cast<__m128i *>( s + i ), _mm_packus_epi16( s16[0], s16[1] ) );
+#endif
+    }
+#endif
+
+    for( ; i < count; i++ ){
+        Convert( t, bgr[3 * i], bgr[3 * i + 1], bgr[3 * i + 2], h[i], s[i], v[i] );
+    }
+
+    // Every range of every object on the same HSV values
+    i = 0;
+#if defined(HSV_THRESHOLD_NEON)
+    for( ; i + 16 <= count; i += 16 ){
+        uint8x16_t H = vld1q_u8( h + i ), S = vld1q_u8( s + i ), V = vld1q_u8( v + i );
+        uint8x16_t label = vdupq_n_u8( 0 );
+        for( int k = 0; k < range_count; k++ ){
+            const Range & rg = ranges[k];
+            uint8x16_t in = vandq_u8( vcgeq_u8( H, vdupq_n_u8( rg.lower[0] ) ), vcleq_u8( H, vdupq_n_u8( rg.upper[0] ) ) );
+            in = vandq_u8( in, vandq_u8( vcgeq_u8( S, vdupq_n_u8( rg.lower[1] ) ), vcleq_u8( S, vdupq_n_u8( rg.upper[1] ) ) ) );
+            in = vandq_u8( in, vandq_u8( vcgeq_u8( V, vdupq_n_u8( rg.lower[2] ) ), vcleq_u8( V, vdupq_n_u8( rg.upper[2] ) ) ) );
+            label = vorrq_u8( label, vandq_u8( in, vdupq_n_u8( rg.bit ) ) );
+        }
+        vst1q_u8( labels + i, label );
+    }
+#elif defined(HSV_THRESHOLD_SSE)
+    for( ; i + 16 <= count; i += 16 ){
+        __m128i H = _mm_load_si128( reinterpret_cast<const __m128i *>( h + i ) );
+        __m128i S = _mm_load_si128( reinterpret_cast<const __m128i *>( s + i ) );
+        __m128i V = _mm_load_si128( reinterpret_cast<const __m128i *>( v + i ) );
+        __m128i label = _mm_setzero_si128();
+        for( int k = 0; k < range_count; k++ ){
+            const Range & rg = ranges[k];
+            __m128i in = InRange( H, _mm_set1_epi8( static_cast<char>( rg.lower[0] ) ), _mm_set1_epi8( static_cast<char>( rg.upper[0] ) ) );
+            in = _mm_and_si128( in, InRange( S, _mm_set1_epi8( static_cast<char>( rg.lower[1] ) ), _mm_set1_epi8( static_cast<char>( rg.upper[1] ) ) ) );
+            in = _mm_and_si128( in, InRange( V, _mm_set1_epi8( static_cast<char>( rg.lower[2] ) ), _mm_set1_epi8( static_cast<char>( rg.upper[2] ) ) ) );
+            label = _mm_or_si128( label, _mm_and_si128( in, _mm_set1_epi8( static_cast<char>( rg.bit ) ) ) );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( labels + i ), label );
+    }
+#endif
+
+    for( ; i < count; i++ ){
+        uint8_t label = 0;
+        for( int k = 0; k < range_count; k++ ){
+            const Range & rg = ranges[k];
+            if( h[i] >= rg.lower[0] && h[i] <= rg.upper[0] &&
+                s[i] >= rg.lower[1] && s[i] <= rg.upper[1] &&
+                v[i] >= rg.lower[2] && v[i] <= rg.upper[2] ){
+                label |= rg.bit;
+            }
+        }
+        labels[i] = label;
+    }
+}
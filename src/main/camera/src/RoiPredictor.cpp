@@ -0,0 +1,53 @@
+/************************************
+ * RoiPredictor
+ *************************************/
+
+#include "RoiPredictor.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RoiPredictor::Update( const FruitDetection & d ){
+    if( !d.found ){ valid = false; return; }
+
+    const cv::Point2d c( d.box.x + d.box.width / 2.0, d.box.y + d.box.height / 2.0 );
+    const cv::Size2d s( d.box.width, d.box.height );
+    const double dt = ( d.stamp_ns - stamp_ns ) * 1e-9;
+
+    if( valid && d.object == object && dt > 0 && dt < max_gap ){
+        const cv::Point2d v = ( c - center ) * ( 1 / dt );
+        const double g = ( std::sqrt( s.area() / std::max( size.area(), 1.0 ) ) - 1 ) / dt;
+        velocity = filter * v + ( 1 - filter ) * velocity;
+        growth   = filter * g + ( 1 - filter ) * growth;
+    }else{
+        velocity = cv::Point2d();
+        growth = 0;
+    }
+
+    valid    = true;
+    object   = d.object;
+    stamp_ns = d.stamp_ns;
+    center   = c;
+    size     = s;
+}
+
+cv::Rect RoiPredictor::Predict( double cmd_x, double cmd_y, double cmd_depth, const cv::Size & frame ) const {
+    if( !valid ){ return cv::Rect(); }
+
+    // From the frame the last box was measured on to the frame after the next one
+    const double horizon = ( timing::NowNs() - stamp_ns ) * 1e-9 + frame_period;
+
+    const cv::Point2d shift( cmd_x != 0 ? velocity.x * horizon : 0,
+                             cmd_y != 0 ? velocity.y * horizon : 0 );
+    const double scale = 1 + ( cmd_depth != 0 ? std::fabs( growth ) * horizon : 0 );
+
+    // The prediction is as uncertain as the motion it adds
+    const double half_w = size.width  * scale * ( 0.5 + margin ) + min_margin + std::fabs( shift.x );
+    const double half_h = size.height * scale * ( 0.5 + margin ) + min_margin + std::fabs( shift.y );
+    const cv::Point2d c = center + shift;
+
+    const cv::Rect roi( cv::Point( static_cast<int>( std::floor( c.x - half_w ) ), static_cast<int>( std::floor( c.y - half_h ) ) ),
+                        cv::Point( static_cast<int>( std::ceil ( c.x + half_w ) ), static_cast<int>( std::ceil ( c.y + half_h ) ) ) );
+    return roi & cv::Rect( cv::Point(), frame );
+}
@@ -13,6 +13,13 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+// Range sensor placement on the robot frame, x to the front and y to the left [cm], [degrees]
+struct SensorMount {
+    double x;
+    double y;
+    double th;
+};
+
 namespace constant
 {
     //Motors
@@ -45,6 +52,21 @@ namespace constant
     static constexpr int US_RIGHT_TRIG =  0;
     static constexpr int US_RIGHT_ECHO =  1;
 
+    //Lidar
+    static constexpr int LIDAR_FRONT_BEAM   = 270;  // Beam pointing to the robot front, indices grow clockwise
+    static constexpr double LIDAR_OFFSET_X  = 0;    // Lidar position on the robot frame [cm]
+    static constexpr double LIDAR_OFFSET_Y  = 0;
+
+    //Range sensors, the ultrasonic ones look backwards
+    static constexpr SensorMount SHARP_RIGHT_MOUNT{ 0, -FRAME_RADIUS, -90 };
+    static constexpr SensorMount SHARP_LEFT_MOUNT { 0,  FRAME_RADIUS,  90 };
+    static constexpr SensorMount SHARP_ARM_MOUNT  { FRAME_RADIUS, 0,    0 };
+    static constexpr SensorMount US_RIGHT_MOUNT   { -FRAME_RADIUS,  10, 180 };
+    static constexpr SensorMount US_LEFT_MOUNT    { -FRAME_RADIUS, -10, 180 };
+
+    //Field
+    static constexpr double FIELD_SIZE = 400;  // Square arena side [cm]
+
 
 
 
@@ -0,0 +1,70 @@
+/************************************
+ * FieldLayout
+ * Competition waypoint graph used by MainTask, checked and routed at build time.
+ *************************************/
+
+#pragma once
+
+#include "StaticFieldGraph.h"
+
+#include <iterator>
+
+namespace field {
+
+    enum Waypoint : int {
+        A, B, C, D, E, F, G, H,
+        TAKE_BASKET, DELIVER_BASKET,
+        OBJ1, OBJ2, OBJ3, OBJ4,
+        WAYPOINT_COUNT
+    };
+
+    constexpr Node layout_nodes[WAYPOINT_COUNT] = {
+        /* A */ {  35,  35,  -1 },
+        /* B */ {  35, 305,  -1 },
+        /* C */ {  35, 365,  -1 },
+        /* D */ { 370, 365,  -1 },
+        /* E */ { 370, 235,  -1 },
+        /* F */ { 370,  30,   0 },
+        /* G */ {  35,  35, 180 },
+        /* H */ { 200,  35, 180 },
+
+        /* TAKE_BASKET    */ { 360,  65,   0 },
+        /* DELIVER_BASKET */ { 360, 325,   0 },
+
+        /* OBJ1 */ { 100, 365,   0 },    // grape_purple
+        /* OBJ2 */ { 300, 365,   0 },    // grape_yellow
+        /* OBJ3 */ { 100, 305,   0 },    // grape_green
+        /* OBJ4 */ { 300, 235, 180 },    // grape_yellow
+    };
+
+    // Directed, as the robot is allowed to drive them
+    constexpr Edge layout_edges[] = {
+        { A, B }, { A, C }, { A, G },
+        { B, A }, { B, C },
+        { C, A }, { C, B }, { C, D },
+        { D, C }, { D, E }, { D, F },
+        { E, D }, { E, F },
+        { F, D }, { F, E }, { F, A },
+        { G, A }, { G, H },
+        { H, G }, { H, F },
+
+        // Pick and drop spots are dead ends, reached from and left to their neighbors
+        { TAKE_BASKET, F },    { F, TAKE_BASKET },
+        { TAKE_BASKET, D },    { D, TAKE_BASKET },
+        { TAKE_BASKET, E },    { E, TAKE_BASKET },
+        { DELIVER_BASKET, F }, { F, DELIVER_BASKET },
+        { DELIVER_BASKET, D }, { D, DELIVER_BASKET },
+        { DELIVER_BASKET, E }, { E, DELIVER_BASKET },
+        { OBJ1, C }, { C, OBJ1 }, { OBJ1, D }, { D, OBJ1 },
+        { OBJ2, C }, { C, OBJ2 }, { OBJ2, D }, { D, OBJ2 },
+        { OBJ3, B }, { B, OBJ3 },
+        { OBJ4, E }, { E, OBJ4 },
+    };
+
+    constexpr StaticFieldGraph<WAYPOINT_COUNT, static_cast<int>( std::size( layout_edges ) )> layout{ layout_nodes, layout_edges };
+
+    static_assert( layout.CheckEdges(), "FieldLayout: edge to an unknown node, self loop or duplicated edge" );
+    static_assert( layout.CheckInside( 0, 0, 400, 400 ), "FieldLayout: waypoint outside the field" );
+    static_assert( layout.CheckConnected(), "FieldLayout: some waypoint cannot reach another one" );
+
+}
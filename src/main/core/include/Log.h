@@ -0,0 +1,150 @@
+/************************************
+ * Log
+ * Asynchronous logger for the control loops.
+ *
+ * A LOG_* call copies its arguments as a compact binary record into a
+ * ring buffer owned by the calling thread and returns: no lock, no
+ * allocation, no system call. A writer thread formats the records and
+ * writes them to stdout in batches. When a ring is full the record is
+ * dropped and counted instead of blocking the caller.
+ *
+ *   LOG_INFO( "Move Goal x: %f y: %f", x, y );
+ *   LOG_INFO_EVERY( 500, "x: %.1f y: %.1f", x, y );    // At most every 500 ms from this line
+ *
+ * The format must be a string literal with printf conversions. Arguments
+ * can be integers, floating point numbers, C strings or std::string, which
+ * are copied (at most max_text bytes).
+ *************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "Scheduler.h"
+
+namespace logging
+{
+    enum class Level : uint8_t { Debug, Info, Warn, Error, Off };
+
+    void SetLevel( Level level );
+    Level GetLevel();
+
+    // Blocks until every record logged before the call is written
+    void Flush();
+
+    uint64_t GetDropped();      // Records lost to full rings
+
+    // One per call site, holds its rate limit
+    struct Site {
+        constexpr Site( Level l, const char * f, int n, double period_ms )
+            : level{l}, file{f}, line{n}, period_ns{ static_cast<int64_t>( period_ms * 1e6 ) }{}
+
+        const Level level;
+        const char * const file;
+        const int line;
+        const int64_t period_ns;                // 0 logs every call
+        std::atomic<int64_t> next_ns{0};
+        std::atomic<uint32_t> suppressed{0};    // Calls skipped since the last record
+    };
+
+    constexpr size_t max_text = 255;
+
+    namespace detail
+    {
+        extern std::atomic<Level> min_level;
+
+        enum ArgType : uint8_t { Int, Uint, Double, Text };
+
+        // Room for a record, nullptr when the ring is full
+        char * Reserve( size_t size );
+        void Commit( char * record, size_t size, Site & site, const char * format );
+
+        inline size_t ArgSize( const char * s ){ return 2 + ( s ? std::min( std::strlen( s ), max_text ) : 0 ); }
+        inline size_t ArgSize( char * s ){ return ArgSize( static_cast<const char *>( s ) ); }
+        inline size_t ArgSize( const std::string & s ){ return 2 + std::min( s.size(), max_text ); }
+        template <typename T>
+        constexpr size_t ArgSize( const T & ){
+            static_assert( std::is_arithmetic<T>::value || std::is_enum<T>::value, "unsupported log argument" );
+            return 1 + 8;
+        }
+
+        inline char * PutText( char * p, const char * s, size_t n ){
+            n = std::min( n, max_text );
+            *p++ = Text;
+            *p++ = static_cast<char>( n );
+            std::memcpy( p, s, n );
+            return p + n;
+        }
+        inline char * PutArg( char * p, const char * s ){ return PutText( p, s ? s : "", s ? std::strlen( s ) : 0 ); }
+        inline char * PutArg( char * p, char * s ){ return PutArg( p, static_cast<const char *>( s ) ); }
+        inline char * PutArg( char * p, const std::string & s ){ return PutText( p, s.data(), s.size() ); }
+
+        template <typename T>
+        char * PutArg( char * p, const T & v ){
+            if constexpr ( std::is_floating_point<T>::value ){
+                double d = v;
+                *p++ = Double;
+                std::memcpy( p, &d, 8 );
+            } else if constexpr ( std::is_signed<T>::value || std::is_enum<T>::value ){
+                int64_t i = static_cast<int64_t>( v );
+                *p++ = Int;
+                std::memcpy( p, &i, 8 );
+            } else {
+                uint64_t u = static_cast<uint64_t>( v );
+                *p++ = Uint;
+                std::memcpy( p, &u, 8 );
+            }
+            return p + 8;
+        }
+
+        constexpr size_t header_size = 32;
+
+        template <typename... Args>
+        void Write( Site & site, const char * format, const Args &... args ){
+            size_t size = header_size;
+            ( ( size += ArgSize( args ) ), ... );
+            size = ( size + 7 ) & ~static_cast<size_t>( 7 );
+
+            char * record = Reserve( size );
+            if( !record ){ return; }
+
+            char * p = record + header_size;
+            ( ( p = PutArg( p, args ) ), ... );
+            (void)p;
+            Commit( record, size, site, format );
+        }
+
+        inline bool Enabled( Site & site ){
+            if( site.level < min_level.load( std::memory_order_relaxed ) ){ return false; }
+            if( site.period_ns == 0 ){ return true; }
+
+            int64_t now  = timing::NowNs();
+            int64_t next = site.next_ns.load( std::memory_order_relaxed );
+            if( now < next || !site.next_ns.compare_exchange_strong( next, now + site.period_ns, std::memory_order_relaxed ) ){
+                site.suppressed.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            return true;
+        }
+    }
+}
+
+#define LOG_AT( level, period_ms, ... ) \
+    do{ \
+        static logging::Site log_site_{ level, __FILE__, __LINE__, period_ms }; \
+        if( logging::detail::Enabled( log_site_ ) ){ logging::detail::Write( log_site_, __VA_ARGS__ ); } \
+    }while( 0 )
+
+#define LOG_DEBUG( ... )    LOG_AT( logging::Level::Debug, 0, __VA_ARGS__ )
+#define LOG_INFO( ... )     LOG_AT( logging::Level::Info,  0, __VA_ARGS__ )
+#define LOG_WARN( ... )     LOG_AT( logging::Level::Warn,  0, __VA_ARGS__ )
+#define LOG_ERROR( ... )    LOG_AT( logging::Level::Error, 0, __VA_ARGS__ )
+
+#define LOG_DEBUG_EVERY( period_ms, ... )   LOG_AT( logging::Level::Debug, period_ms, __VA_ARGS__ )
+#define LOG_INFO_EVERY( period_ms, ... )    LOG_AT( logging::Level::Info,  period_ms, __VA_ARGS__ )
+#define LOG_WARN_EVERY( period_ms, ... )    LOG_AT( logging::Level::Warn,  period_ms, __VA_ARGS__ )
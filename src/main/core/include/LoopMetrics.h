@@ -0,0 +1,154 @@
+/************************************
+ * LoopMetrics
+ * Iteration timing of the control loops.
+ *
+ * Every instrumented loop owns a metrics::Loop with two histograms:
+ *   exec -> how long the loop body ran, on the real monotonic clock
+ *   late -> how long after its deadline the loop woke up (the jitter)
+ * and a count of missed deadlines. A Rate given the Loop records all of
+ * them by itself; loops that wait on something else use ScopedTimer.
+ *
+ *   static metrics::Loop position_loop( "position_driver" );
+ *   Rate rate( period, &position_loop );
+ *
+ * Recording is a few relaxed atomic adds into log-linear buckets (HDR
+ * style: within 1 us below 32 us, within 3% above, up to 2 min, longer
+ * samples in an overflow slot): no lock, no allocation, any number of
+ * writers. The histograms are per loop rather than per thread: a Loop is
+ * normally recorded by the one thread running it, so the adds do not
+ * contend and the export has nothing to merge. A Loop shared by several
+ * threads stays correct, its writers just share the cache lines.
+ *
+ * Start() exports p50 / p99 of every loop to the telemetry keys
+ * <name>_exec_p50_ms, <name>_exec_p99_ms, <name>_late_p99_ms and
+ * <name>_misses. Dump(), or SIGUSR1 to the process, logs the full table.
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Telemetry.h"
+
+namespace metrics
+{
+    // Real monotonic time, not replaced by timing::SetClock() [ns]
+    inline int64_t ReadNs(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    struct Summary {
+        uint64_t count = 0;
+        double mean = 0;    // [ms]
+        double min  = 0;
+        double p50  = 0;
+        double p90  = 0;
+        double p99  = 0;
+        double p999 = 0;
+        double max  = 0;
+    };
+
+    class Histogram
+    {
+        public:
+            static constexpr int unit_shift = 10;       // Values are counted in 1024 ns units
+            static constexpr int sub_bits   = 4;        // 16 buckets per power of two
+            static constexpr int max_msb    = 26;       // Units from 2^27 (~137 s) on go to the overflow slot
+            static constexpr int buckets    = ( max_msb - sub_bits + 1 ) * ( 1 << sub_bits ) + ( 1 << sub_bits );
+            static constexpr int overflow   = buckets;  // Index past the last bucket, has no BucketNs()
+
+            Histogram(){ Reset(); }
+
+            void Record( int64_t ns ){
+                if( ns < 0 ){ ns = 0; }
+                counts[Index( ns )].fetch_add( 1, std::memory_order_relaxed );
+                total.fetch_add( 1, std::memory_order_relaxed );
+                sum_ns.fetch_add( static_cast<uint64_t>( ns ), std::memory_order_relaxed );
+
+                int64_t m = max_ns.load( std::memory_order_relaxed );
+                while( ns > m && !max_ns.compare_exchange_weak( m, ns, std::memory_order_relaxed ) ){}
+                m = min_ns.load( std::memory_order_relaxed );
+                while( ns < m && !min_ns.compare_exchange_weak( m, ns, std::memory_order_relaxed ) ){}
+            }
+
+            // Not atomic with Record(): samples racing a reset may land on either side
+            void Reset();
+
+            uint64_t Count() const { return total.load( std::memory_order_relaxed ); }
+            Summary Summarize() const;
+
+            static int Index( int64_t ns );
+            static int64_t BucketNs( int index );     // Middle of the bucket
+
+        private:
+            std::atomic<uint64_t> counts[buckets + 1];
+            std::atomic<uint64_t> total;
+            std::atomic<uint64_t> sum_ns;
+            std::atomic<int64_t> min_ns;
+            std::atomic<int64_t> max_ns;
+    };
+
+    class Loop
+    {
+        public:
+            // Registered for export until destroyed, the name must outlive it (a literal)
+            Loop( const char * name );
+            ~Loop();
+
+            Loop( const Loop & ) = delete;
+            Loop & operator=( const Loop & ) = delete;
+
+            void RecordExec( int64_t ns ){ exec.Record( ns ); }
+            void RecordLate( int64_t ns ){ late.Record( ns ); }
+            void CountMiss(){ misses.fetch_add( 1, std::memory_order_relaxed ); }
+
+            void Reset();
+
+            const char * const name;
+
+            Histogram exec;
+            Histogram late;
+            std::atomic<uint64_t> misses{0};
+
+        private:
+            friend void Export();
+
+            telemetry::Number exec_p50;
+            telemetry::Number exec_p99;
+            telemetry::Number late_p99;
+            telemetry::Number missed;
+    };
+
+    // Records the time until the end of the scope as one iteration of the loop
+    class ScopedTimer
+    {
+        public:
+            explicit ScopedTimer( Loop & loop ) : loop{loop}, start_ns{ ReadNs() }{}
+            ~ScopedTimer(){ loop.RecordExec( ReadNs() - start_ns ); }
+
+            ScopedTimer( const ScopedTimer & ) = delete;
+            ScopedTimer & operator=( const ScopedTimer & ) = delete;
+
+        private:
+            Loop & loop;
+            const int64_t start_ns;
+    };
+
+    constexpr int max_loops = 32;
+    constexpr double default_rate = 1;      // [Hz]
+
+    // Starts the export thread and the SIGUSR1 handler, calling it again only changes the rate
+    void Start( double rate_hz = default_rate );
+    void Stop();
+
+    // Pushes the summaries of every loop to telemetry now
+    void Export();
+
+    // Logs the summaries of every loop
+    void Dump();
+
+    // Clears every loop, to measure a phase of the mission on its own
+    void ResetAll();
+}
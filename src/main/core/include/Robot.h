@@ -13,6 +13,11 @@
 #include "main.h"
 
 #include "Hardware.h"
+#if SIMULATION
+#include "SimHardware.h"
+#else
+#include "VmxHardware.h"
+#endif
 #include "Movement.h"
 #include "Sensors.h"
 #include "Camera.h"
@@ -20,8 +25,13 @@
 #include "Oms.h"
 #include "ManualDrive.h"
 #include "PathPlannerComm.h"
+#include "Log.h"
+#include "LoopMetrics.h"
+#include "Localizer.h"
+#include "Trajectory.h"
 
 #include <dfs.h>
+#include "FieldLayout.h"
 #include <limits>
 #include <cmath>
 
@@ -33,7 +43,12 @@ class Robot : public frc::TimedRobot {
 
 };
 
-inline Hardware hard;
+// Built with -Psimulation the control code runs on the kinematic model and virtual time
+#if SIMULATION
+inline SimHardware hard;
+#else
+inline VmxHardware hard;
+#endif
 inline Sensor sensor( &hard );
 inline Movement movement( &hard, &sensor );
 inline Lidar lidar( &movement, &sensor );
@@ -42,6 +57,7 @@ inline Camera cam( &movement, &oms, &hard );
 inline OI oi;
 inline Drive drive( &hard, &movement, &oi );
 inline PathPlanner::PathPlannerComm pathPlanner(5800);
+inline Localizer localizer( &movement, &lidar );
 
 static double SL(){
   return lidar.GetLidarLeft() * 100 + offset_side;
@@ -63,6 +79,10 @@ static double setAngle(){
   float ang = movement.get_th();
   return sensor.setAngle(ang);
 }
+static double setAngleLidar( std::string direction ){
+  float ang = movement.get_th();
+  return lidar.setAngle( ang, direction );
+}
 
 static void set_gripper( int ang ){
   oms.set_gripper( ang );
@@ -104,6 +124,10 @@ static void position_driver(float x, float y, float th){
 static void set_position(float x, float y, float th){
   movement.SetPosition( x, y, th );
 }
+// Fuses the sharp, ultrasonic and lidar wall ranges into the odometry, see PoseFilter.h
+static void pose_fusion( bool enabled ){
+  movement.SetFusion( enabled );
+}
 static void linear_align( double dist, std::string direction ){
   lidar.linear_align( dist, direction );
 }
@@ -140,36 +164,55 @@ static void DetectFruitSharp( std::vector<std::string> fruits ){
   cam.DetectFruit( fruits, ang, debug, use_area );
 }
 
-static Coord prev_Coord;
-
-static std::vector<std::vector<double>> best_way( Coord &d, Coord &c ){
-  std::vector<Coord> path;
-  std::vector<std::vector<double>> d_path;
-  double dist = 0;
-  std::vector<std::string> checked;
- 
-  dfs( &d, &c, path, 0, d_path, dist, checked );
- 
-  prev_Coord = d;
- 
-  return d_path;
-}
-static void path_driver( std::vector<std::vector<double>> path ){
-  for( std::vector<double> p : path ){
-    // movement.PositionDriver( p[0], p[1], p[2] );
-    // std::cout << "x: " << p[0] << " y: " << p[1] << " th: " << p[2] << std::endl;
+// Route between two FieldLayout waypoints, a table read without allocation
+static field::Route<field::WAYPOINT_COUNT> field_way( field::Waypoint d, field::Waypoint c ){
+  return field::layout.GetRoute( c, d );
+}
+// Route from the odometry pose, entering the layout at the waypoint nearest to the robot
+static field::Route<field::WAYPOINT_COUNT> field_way( field::Waypoint d ){
+  double x = movement.get_x(), y = movement.get_y();
+  int nearest = 0;
+  double best = std::numeric_limits<double>::max();
+  for( int i = 0; i < field::layout.Size(); i++ ){
+    const field::Node & n = field::layout.GetNode( i );
+    double dist = std::hypot( n.x - x, n.y - y );
+    if( dist < best ){ best = dist; nearest = i; }
+  }
+  return field::layout.GetRoute( nearest, d );
+}
+static void path_driver( const field::Route<field::WAYPOINT_COUNT> & route ){
+  if( route.count == 0 ){ std::cout << "path_driver: empty route" << std::endl; }
+
+  for( int i = 0; i < route.count; i++ ){
+    const field::Node & p = field::layout.GetNode( route.node[i] );
+    // movement.PositionDriver( p.x, p.y, p.th );
+    // std::cout << "x: " << p.x << " y: " << p.y << " th: " << p.th << std::endl;
+    (void)p;
   }
 }
 
+static void pathplanner_update_odometry(bool verbose = false);
+
 // PathPlanner functions
 static void pathplanner_init(){
   std::cout << "[FRC] ===== STARTING PATHPLANNER COMMUNICATION =====" << std::endl;
+  pathPlanner.SetMapReceivedCallback( []( const PathPlanner::FieldMap & map ){ localizer.SetMap( map ); } );
+  // Movement.cpp does not see Robot.h, the drivers publish the odometry through this
+  movement.SetOdometryCallback( []{ pathplanner_update_odometry( false ); } );
   pathPlanner.Start();
   std::cout << "[FRC] PathPlanner communication started on port 5800" << std::endl;
+  std::cout << "[FRC] Paths restored from the cache: " << pathPlanner.GetPathCount() << std::endl;
   std::cout << "[FRC] =============================================" << std::endl;
 }
 
-static void pathplanner_update_odometry(bool verbose = false){
+// Continuous pose correction from the lidar, needs lidar.StartLidar() and a map from the GUI
+static void localization_start(){
+  PathPlanner::FieldMap map;
+  if( pathPlanner.GetMap( map ) ){ localizer.SetMap( map ); }
+  localizer.Start();
+}
+
+static void pathplanner_update_odometry(bool verbose){
   // Get current robot position (convert cm to meters)
   double x_meters = movement.get_x() / 100.0;
   double y_meters = movement.get_y() / 100.0;
@@ -178,14 +221,44 @@ static void pathplanner_update_odometry(bool verbose = false){
   // Update PathPlanner with current pose
   pathPlanner.UpdateRobotPose(x_meters, y_meters, heading_radians);
 
-  // Print odometry for debugging (only if verbose or every 20 calls)
-  static int update_count = 0;
-  update_count++;
+  // Diagnostics and scans only while the GUI subscribed to them
+  if( pathPlanner.HasSubscribers( PathPlanner::Topic::Odometry ) ){
+    PoseSample pose = movement.GetPose();
+    LocalizerStatus loc = localizer.GetStatus();
+
+    PathPlanner::OdometryDiagnostics odometry;
+    odometry.x           = pose.x / 100.0;
+    odometry.y           = pose.y / 100.0;
+    odometry.heading     = pose.th * M_PI / 180.0;
+    odometry.age         = ( timing::NowNs() - pose.stamp_ns ) / 1e9;
+    odometry.corrections = pose.correction;
+    odometry.matches     = loc.matches;
+    odometry.accepted    = loc.accepted;
+    odometry.residual    = loc.residual;
+    odometry.inlierRatio = loc.inlier_ratio;
+    pathPlanner.PublishOdometry( odometry );
+  }
+
+  static uint64_t scan_generation = 0;
+  if( pathPlanner.HasSubscribers( PathPlanner::Topic::LidarScan ) ){
+    uint64_t generation = lidar.GetRanges().generation;
+    if( generation != 0 && generation != scan_generation ){
+      scan_generation = generation;
 
-  if (verbose || update_count % 20 == 0) {
-    std::cout << "[FRC] ODOM: x=" << x_meters << "m, y=" << y_meters
-              << "m, θ=" << movement.get_th() << "° | Connected: "
-              << (pathPlanner.IsConnected() ? "YES" : "NO") << std::endl;
+      static float ranges[360];
+      const studica::Lidar::ScanData & scan = lidar.getScan();
+      for( int i = 0; i < 360; i++ ){ ranges[i] = scan.distance[i] / 1000.0f; }
+      pathPlanner.PublishLidarScan( ranges, 360 );
+    }
+  }
+
+  // Print odometry for debugging (every call if verbose, otherwise once a second)
+  if (verbose) {
+    LOG_INFO( "[FRC] ODOM: x=%gm, y=%gm, θ=%g° | Connected: %s", x_meters, y_meters,
+              movement.get_th(), pathPlanner.IsConnected() ? "YES" : "NO" );
+  } else {
+    LOG_INFO_EVERY( 1000, "[FRC] ODOM: x=%gm, y=%gm, θ=%g° | Connected: %s", x_meters, y_meters,
+                    movement.get_th(), pathPlanner.IsConnected() ? "YES" : "NO" );
   }
 }
 
@@ -202,25 +275,59 @@ static void pathplanner_list_paths() {
   std::cout << "[FRC] ===== AVAILABLE PATHS =====" << std::endl;
   std::cout << "[FRC] Total paths stored: " << count << std::endl;
 
-  std::vector<PathPlanner::Path> allPaths = pathPlanner.GetAllPaths();
+  std::vector<PathPlanner::PathPtr> allPaths = pathPlanner.GetAllPaths();
   for (size_t i = 0; i < allPaths.size(); i++) {
-    const auto& p = allPaths[i];
+    const auto& p = *allPaths[i];
     std::cout << "[FRC] [" << i << "] \"" << p.name << "\" - "
-              << p.waypoints.size() << " waypoints" << std::endl;
+              << p.waypoints.size() << " waypoints (v" << p.version << ")" << std::endl;
   }
   std::cout << "[FRC] ==============================" << std::endl;
 }
 
+// Drives through the waypoints without stopping: one trajectory from the current position,
+// then the final pose is settled with PositionDriver. False when stopped by the user.
+static bool pathplanner_drive_waypoints(const std::vector<PathPlanner::Waypoint>& waypoints) {
+  if (waypoints.empty()) { return true; }
+
+  std::vector<TrajectoryPoint> points;
+  points.push_back({ movement.get_x(), movement.get_y(), 0 });
+  for (const auto& wp : waypoints) {
+    points.push_back({ wp.x * 100.0, wp.y * 100.0, wp.velocity * 100.0 });
+    std::cout << "[FRC] → WP: (" << wp.x * 100.0 << "cm, " << wp.y * 100.0 << "cm, "
+              << (wp.heading * 180.0) / M_PI << "°, " << wp.velocity << "m/s)" << std::endl;
+  }
+
+  const PathPlanner::Waypoint& last = waypoints.back();
+  double x_cm = last.x * 100.0;
+  double y_cm = last.y * 100.0;
+  double heading_deg = (last.heading * 180.0) / M_PI;
+
+  Trajectory trajectory;
+  if (trajectory.Generate(points, TrajectoryConstraints())) {
+    // Face the start tangent in place, the follower cannot turn on the spot
+    double start_th = (trajectory.States().front().th * 180.0) / M_PI;
+    if (std::abs(close_angle(start_th - movement.get_th())) > 10) {
+      movement.PositionDriver(movement.get_x(), movement.get_y(), start_th);
+    }
+    if (hard.GetStopButton()) { return false; }
+
+    if (!movement.TrajectoryDriver(trajectory)) { return false; }
+  }
+
+  movement.PositionDriver(x_cm, y_cm, heading_deg);
+  return !hard.GetStopButton();
+}
+
 // Smart path execution: finds nearest waypoint and executes intelligently
 static bool pathplanner_execute_path(const std::string& pathName, bool executeFromNearest = true) {
-  PathPlanner::Path path;
-
-  // Get the path by name
-  if (!pathPlanner.GetPathByName(pathName, path)) {
+  // Get the path by name, the snapshot stays valid if the GUI replaces it meanwhile
+  PathPlanner::PathPtr snapshot = pathPlanner.GetPathByName(pathName);
+  if (!snapshot) {
     std::cout << "[FRC] ERROR: Path \"" << pathName << "\" not found!" << std::endl;
     pathplanner_list_paths();
     return false;
   }
+  const PathPlanner::Path& path = *snapshot;
 
   if (path.waypoints.empty()) {
     std::cout << "[FRC] ERROR: Path \"" << pathName << "\" has no waypoints!" << std::endl;
@@ -294,63 +401,24 @@ static bool pathplanner_execute_path(const std::string& pathName, bool executeFr
   bool success = true;
 
   try {
+    std::vector<PathPlanner::Waypoint> leg;
     if (executeForward) {
       // Execute from startIndex to end
-      for (size_t i = startIndex; i < path.waypoints.size(); i++) {
-        const auto& wp = path.waypoints[i];
-        double x_cm = wp.x * 100.0;
-        double y_cm = wp.y * 100.0;
-        double heading_deg = (wp.heading * 180.0) / M_PI;
-
-        std::cout << "[FRC] → WP[" << i << "]: (" << x_cm << "cm, "
-                  << y_cm << "cm, " << heading_deg << "°)" << std::endl;
-
-        movement.PositionDriver(x_cm, y_cm, heading_deg);
-
-        if (hard.GetStopButton()) {
-          std::cout << "[FRC] STOPPED by user!" << std::endl;
-          success = false;
-          break;
-        }
-      }
+      leg.assign(path.waypoints.begin() + startIndex, path.waypoints.end());
+      success = pathplanner_drive_waypoints(leg);
     } else {
       // Execute backward then forward for complete coverage
-      for (int i = startIndex; i >= 0; i--) {
-        const auto& wp = path.waypoints[i];
-        double x_cm = wp.x * 100.0;
-        double y_cm = wp.y * 100.0;
-        double heading_deg = (wp.heading * 180.0) / M_PI;
-
-        std::cout << "[FRC] ← WP[" << i << "]: (" << x_cm << "cm, "
-                  << y_cm << "cm, " << heading_deg << "°)" << std::endl;
-
-        movement.PositionDriver(x_cm, y_cm, heading_deg);
-
-        if (hard.GetStopButton()) {
-          success = false;
-          break;
-        }
-      }
+      leg.assign(path.waypoints.rend() - startIndex - 1, path.waypoints.rend());
+      success = pathplanner_drive_waypoints(leg);
 
       if (success && startIndex < static_cast<int>(path.waypoints.size()) - 1) {
-        for (size_t i = 1; i < path.waypoints.size(); i++) {
-          const auto& wp = path.waypoints[i];
-          double x_cm = wp.x * 100.0;
-          double y_cm = wp.y * 100.0;
-          double heading_deg = (wp.heading * 180.0) / M_PI;
-
-          std::cout << "[FRC] → WP[" << i << "]: (" << x_cm << "cm, "
-                    << y_cm << "cm, " << heading_deg << "°)" << std::endl;
-
-          movement.PositionDriver(x_cm, y_cm, heading_deg);
-
-          if (hard.GetStopButton()) {
-            success = false;
-            break;
-          }
-        }
+        leg.assign(path.waypoints.begin() + 1, path.waypoints.end());
+        success = pathplanner_drive_waypoints(leg);
       }
     }
+    if (!success) {
+      std::cout << "[FRC] STOPPED by user!" << std::endl;
+    }
   } catch (...) {
     success = false;
   }
@@ -363,23 +431,23 @@ static bool pathplanner_execute_path(const std::string& pathName, bool executeFr
 
 // Execute path by index
 static bool pathplanner_execute_path_by_index(int index, bool executeFromNearest = true) {
-  PathPlanner::Path path;
-  if (!pathPlanner.GetPathByIndex(index, path)) {
+  PathPlanner::PathPtr path = pathPlanner.GetPathByIndex(index);
+  if (!path) {
     std::cout << "[FRC] ERROR: Invalid path index " << index << std::endl;
     pathplanner_list_paths();
     return false;
   }
-  return pathplanner_execute_path(path.name, executeFromNearest);
+  return pathplanner_execute_path(path->name, executeFromNearest);
 }
 
 // Auto-execute new paths as they arrive
 static void pathplanner_check_new_path(){
-  PathPlanner::Path path;
-  if (pathPlanner.GetLatestPath(path)) {
+  PathPlanner::PathPtr path = pathPlanner.GetLatestPath();
+  if (path) {
     std::cout << "[FRC] ===== NEW PATH RECEIVED =====" << std::endl;
-    std::cout << "[FRC] Path: \"" << path.name << "\" (" << path.waypoints.size() << " waypoints)" << std::endl;
+    std::cout << "[FRC] Path: \"" << path->name << "\" (" << path->waypoints.size() << " waypoints)" << std::endl;
 
     // Execute using smart function with nearest waypoint detection
-    pathplanner_execute_path(path.name, true);
+    pathplanner_execute_path(path->name, true);
   }
 }
\ No newline at end of file
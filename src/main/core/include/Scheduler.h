@@ -0,0 +1,142 @@
+/************************************
+ * Scheduler
+ * Fixed-rate periodic scheduling for the control loops.
+ *
+ * Rate      -> paces a loop running on the caller's thread against
+ *              absolute deadlines, so work time does not add to the period.
+ *              Given a metrics::Loop it records every iteration there.
+ * Scheduler -> owns one thread that runs registered periodic tasks,
+ *              optionally as SCHED_FIFO and pinned to a CPU.
+ *
+ * All of them, delay() and timing::Timer read time through timing::NowNs()
+ * and wait through timing::SleepUntilNs(). The simulation replaces the clock
+ * behind them with SetClock() to run the control code on virtual time.
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace metrics { class Loop; }
+
+namespace timing
+{
+    int64_t NowNs();                            // CLOCK_MONOTONIC [ns]
+    void SleepUntilNs( int64_t deadline_ns );   // Absolute sleep on CLOCK_MONOTONIC
+
+    class Clock
+    {
+        public:
+            virtual ~Clock() = default;
+            virtual int64_t NowNs() = 0;
+            virtual void SleepUntilNs( int64_t deadline_ns ) = 0;
+    };
+
+    // Replaces the monotonic clock for every caller, nullptr restores it.
+    // Must be set before the threads that read the time are started.
+    void SetClock( Clock * clock );
+
+    // Drop-in for frc::Timer on top of NowNs() [s]
+    class Timer
+    {
+        public:
+            void Start(){ if( !running ){ start_ns = NowNs(); running = true; } }
+            void Stop(){ if( running ){ accumulated_ns += NowNs() - start_ns; running = false; } }
+            void Reset(){ accumulated_ns = 0; start_ns = NowNs(); }
+            double Get() const { return ( accumulated_ns + ( running ? NowNs() - start_ns : 0 ) ) * 1e-9; }
+
+        private:
+            int64_t start_ns = 0;
+            int64_t accumulated_ns = 0;
+            bool running = false;
+    };
+
+    // Applies SCHED_FIFO (priority > 0) and CPU affinity (cpu >= 0) to the calling thread
+    bool SetRealtime( int priority, int cpu );
+}
+
+class Rate
+{
+    public:
+        // loop, when given, gets the work time, wake-up latency and missed deadlines of each iteration
+        Rate( double period_ms, metrics::Loop * loop = nullptr );
+
+        void Reset();           // Re-anchors the next deadline one period from now
+        double Sleep();         // Waits for the next deadline, returns how late it woke up [ms]
+
+        double GetPeriod() const { return period_ms; }
+        int GetMissed() const { return missed; }
+
+    private:
+        double period_ms;
+        int64_t period_ns;
+        int64_t deadline_ns;
+        int missed = 0;
+
+        metrics::Loop * loop;
+        int64_t wake_ns = 0;        // Real time the current iteration started, for loop
+};
+
+class Scheduler
+{
+    public:
+        struct TaskStats {
+            std::string name;
+            double period_ms;
+            uint64_t runs;
+            uint64_t overruns;      // Deadlines skipped because the previous run was too long
+            double last_exec_ms;
+            double max_exec_ms;
+            double max_late_ms;     // Worst wake-up latency after the deadline
+        };
+
+        Scheduler( const std::string & name = "scheduler" ) : name{name}{}
+        ~Scheduler(){ Stop(); }
+
+        // Tasks can be added before or after Start(). Must not be called from inside a task.
+        // Tasks run without the task lock held, SetTaskEnabled() and GetStats() can be called from one.
+        int AddTask( const std::string & task_name, double period_ms, std::function<void()> task );
+        void SetTaskEnabled( int id, bool enabled );
+
+        // priority > 0 requests SCHED_FIFO, cpu >= 0 pins the thread to that core
+        bool Start( int priority = 0, int cpu = -1 );
+        void Stop();
+        bool IsRunning() const { return running; }
+
+        std::vector<TaskStats> GetStats();
+
+    private:
+        struct Task {
+            int id;
+            std::string name;
+            int64_t period_ns;
+            int64_t next_ns;
+            bool enabled;
+            std::function<void()> fn;
+
+            uint64_t runs = 0;
+            uint64_t overruns = 0;
+            int64_t last_exec_ns = 0;
+            int64_t max_exec_ns = 0;
+            int64_t max_late_ns = 0;
+        };
+
+        void Run( int priority, int cpu );
+
+        std::string name;
+        std::deque<Task> tasks;     // Never erased, Run() keeps pointers to them across the lock
+        std::mutex task_mutex;
+        int next_id = 0;
+
+        std::atomic<bool> running{false};
+        std::thread thread;
+
+        static constexpr int64_t idle_period_ns = 10000000;   // Wake-up period with no tasks [ns]
+};
@@ -0,0 +1,60 @@
+/************************************
+ * SeqLock
+ * Single-writer / multi-reader latest-value cell.
+ * The writer never blocks; readers retry while a write is in progress.
+ * T must be trivially copyable (plain structs of numbers).
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class SeqLock
+{
+    static_assert( std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type" );
+
+    public:
+        SeqLock() : value{} {}
+        explicit SeqLock( const T & initial ) : value{initial} {}
+
+        // Only one thread may call Store()
+        void Store( const T & v ){
+            uint32_t s = seq.load( std::memory_order_relaxed );
+            seq.store( s + 1, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_release );
+
+            std::memcpy( static_cast<void*>( &value ), &v, sizeof(T) );
+
+            seq.store( s + 2, std::memory_order_release );
+        }
+
+        T Load() const {
+            uint32_t version;
+            return Load( version );
+        }
+
+        // Also returns the version the value belongs to
+        T Load( uint32_t & version ) const {
+            T out;
+            uint32_t s0, s1;
+            do{
+                s0 = seq.load( std::memory_order_acquire );
+                std::memcpy( static_cast<void*>( &out ), &value, sizeof(T) );
+                std::atomic_thread_fence( std::memory_order_acquire );
+                s1 = seq.load( std::memory_order_relaxed );
+            }while( ( s0 & 1 ) || s0 != s1 );
+            version = s0 / 2;
+            return out;
+        }
+
+        // Number of completed writes, useful to detect a new value
+        uint32_t Version() const { return seq.load( std::memory_order_acquire ) / 2; }
+
+    private:
+        std::atomic<uint32_t> seq{0};
+        T value;
+};
@@ -0,0 +1,68 @@
+/************************************
+ * Telemetry
+ * Batched dashboard values for the control loops.
+ *
+ * Modules register their keys once and keep the returned handles. Set()
+ * only stores the value in a staging array and marks it dirty when it
+ * changed: no string lookup, no lock, no NetworkTables call. A single
+ * publisher thread pushes the dirty values to SmartDashboard at a fixed
+ * rate, so a value set many times between two publishes is sent once.
+ *
+ *   telemetry::Number robot_x = telemetry::AddNumber( "robot_x" );
+ *   telemetry::Set( robot_x, x_global );
+ *
+ * Numbers and booleans can be set from any thread. Strings take a lock
+ * and are meant for rare updates like the current process name.
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace telemetry
+{
+    constexpr int max_entries = 256;
+    constexpr double default_rate = 10;     // [Hz]
+
+    struct Number  { int index = -1; };
+    struct Boolean { int index = -1; };
+    struct String  { int index = -1; };
+
+    // Registering a key again returns the same handle. Fails (index -1) once
+    // max_entries keys exist, setting an invalid handle does nothing.
+    Number  AddNumber ( const std::string & key );
+    Boolean AddBoolean( const std::string & key );
+    String  AddString ( const std::string & key );
+
+    // Starts the publisher thread, calling it again only changes the rate
+    void Start( double rate_hz = default_rate );
+    void Stop();
+
+    // Pushes the dirty values now, from the calling thread
+    void Publish();
+
+    uint64_t GetPublished();    // Values sent to NetworkTables so far
+
+    namespace detail
+    {
+        // Staging buffer, one slot per entry
+        extern std::atomic<double> values[max_entries];
+        extern std::atomic<uint64_t> dirty[max_entries / 64];
+
+        inline void Stage( int index, double v ){
+            if( index < 0 ){ return; }
+            if( values[index].load( std::memory_order_relaxed ) == v ){ return; }
+            values[index].store( v, std::memory_order_relaxed );
+            dirty[index >> 6].fetch_or( uint64_t{1} << ( index & 63 ), std::memory_order_release );
+        }
+
+        void StageString( int index, const char * v );
+    }
+
+    inline void Set( Number h, double v ){ detail::Stage( h.index, v ); }
+    inline void Set( Boolean h, bool v ){ detail::Stage( h.index, v ? 1.0 : 0.0 ); }
+    inline void Set( String h, const char * v ){ detail::StageString( h.index, v ); }
+    inline void Set( String h, const std::string & v ){ detail::StageString( h.index, v.c_str() ); }
+}
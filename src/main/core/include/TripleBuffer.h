@@ -0,0 +1,46 @@
+/************************************
+ * TripleBuffer
+ * Single-producer / single-consumer latest-value exchange for large
+ * structs. The producer fills its private slot in place and publishes it
+ * with one atomic swap; the consumer keeps reading its slot without a
+ * copy until it asks for a newer one. Neither side ever blocks.
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer
+{
+    public:
+        // Producer side
+        T & WriteBuffer(){ return buffers[back]; }
+
+        void Publish(){
+            int prev = middle.exchange( back | fresh_bit, std::memory_order_acq_rel );
+            back = prev & index_mask;
+        }
+
+        // Consumer side: swaps in the newest published slot if there is one.
+        // The returned reference stays valid until the next call to Acquire().
+        const T & Acquire(){
+            if( middle.load( std::memory_order_relaxed ) & fresh_bit ){
+                int prev = middle.exchange( front, std::memory_order_acq_rel );
+                front = prev & index_mask;
+            }
+            return buffers[front];
+        }
+
+        bool HasNew() const { return middle.load( std::memory_order_acquire ) & fresh_bit; }
+
+    private:
+        static constexpr int index_mask = 0x3;
+        static constexpr int fresh_bit  = 0x4;
+
+        T buffers[3] = {};
+
+        int back  = 0;                  // Owned by the producer
+        int front = 1;                  // Owned by the consumer
+        std::atomic<int> middle{2};     // Shared, carries the fresh flag
+};
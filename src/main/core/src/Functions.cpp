@@ -9,9 +9,10 @@
 *************************************/
 
 #include "Functions.h"
+#include "Scheduler.h"
 
 void delay( float time ){   // Delay in milliseconds
-    frc::Wait( time / 1000.0 );
+    timing::SleepUntilNs( timing::NowNs() + static_cast<int64_t>( time * 1e6 ) );
 }
 
 void coord_rotation( double &x, double &y, double ang ){
@@ -35,6 +35,8 @@ int Inspection() {
     Robot r;
     r.ds.Enable();
 
+    telemetry::Start();
+    metrics::Start();
     lidar.StartLidar();
 
     delay(500);
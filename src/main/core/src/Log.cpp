@@ -0,0 +1,278 @@
+/************************************
+ * Log
+ * Asynchronous logger for the control loops.
+ *************************************/
+
+#include "Log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging
+{
+    namespace detail
+    {
+        std::atomic<Level> min_level{ Level::Info };
+    }
+
+    namespace
+    {
+        constexpr size_t ring_size      = 64 * 1024;    // [bytes] per thread, power of two
+        constexpr int    writer_period  = 10;           // [ms] between two drains
+
+        struct RecordHeader {
+            uint32_t size;              // Whole record, multiple of 8
+            uint32_t suppressed;
+            int64_t stamp_ns;
+            const Site * site;          // nullptr pads up to the end of the ring
+            const char * format;
+        };
+        static_assert( sizeof( RecordHeader ) <= detail::header_size, "record header does not fit" );
+
+        // Single producer, the owning thread, single consumer, the writer
+        struct Ring {
+            std::atomic<uint64_t> head{0};      // Bytes committed by the producer
+            std::atomic<uint64_t> tail{0};      // Bytes consumed by the writer
+            std::atomic<bool> orphaned{false};  // Owner exited, freed once drained
+            uint64_t reserved = 0;              // Producer only, end of the reserved record
+            alignas( 8 ) char data[ring_size];
+        };
+
+        class Writer {
+            public:
+                Writer() : start_ns{ timing::NowNs() }, thread{ &Writer::Run, this }{}
+
+                ~Writer(){
+                    {
+                        std::lock_guard<std::mutex> lock( mutex );
+                        running = false;
+                    }
+                    wake.notify_all();
+                    thread.join();
+                }
+
+                std::shared_ptr<Ring> Register(){
+                    auto ring = std::make_shared<Ring>();
+                    std::lock_guard<std::mutex> lock( mutex );
+                    rings.push_back( ring );
+                    return ring;
+                }
+
+                void Flush(){
+                    std::unique_lock<std::mutex> lock( mutex );
+                    uint64_t target = ++flush_requested;
+                    wake.notify_all();
+                    flushed.wait( lock, [&]{ return flush_done >= target || !running; } );
+                }
+
+                std::atomic<uint64_t> dropped{0};
+
+            private:
+                void Run(){
+                    std::unique_lock<std::mutex> lock( mutex );
+                    while( true ){
+                        wake.wait_for( lock, std::chrono::milliseconds( writer_period ),
+                                       [&]{ return flush_requested != flush_done || !running; } );
+                        bool stop = !running;
+                        uint64_t request = flush_requested;
+
+                        // Rings only grow while the lock is held, draining happens without it
+                        std::vector<std::shared_ptr<Ring>> snapshot = rings;
+                        lock.unlock();
+
+                        for( auto & ring : snapshot ){ Drain( *ring ); }
+                        if( !out.empty() ){
+                            fwrite( out.data(), 1, out.size(), stdout );
+                            fflush( stdout );
+                            out.clear();
+                        }
+                        ReportDropped();
+
+                        lock.lock();
+                        rings.erase( std::remove_if( rings.begin(), rings.end(), []( const std::shared_ptr<Ring> & r ){
+                                         return r->orphaned && r->tail == r->head;
+                                     } ), rings.end() );
+                        flush_done = request;
+                        flushed.notify_all();
+                        if( stop ){ return; }
+                    }
+                }
+
+                void Drain( Ring & ring ){
+                    uint64_t tail = ring.tail.load( std::memory_order_relaxed );
+                    const uint64_t head = ring.head.load( std::memory_order_acquire );
+
+                    while( tail < head ){
+                        size_t pos = tail & ( ring_size - 1 );
+                        size_t contiguous = ring_size - pos;
+                        if( contiguous < detail::header_size ){ tail += contiguous; continue; }
+
+                        RecordHeader h;
+                        std::memcpy( &h, ring.data + pos, sizeof( h ) );
+                        if( h.site ){ Format( h, ring.data + pos + detail::header_size, ring.data + pos + h.size ); }
+                        tail += h.size;
+                    }
+                    ring.tail.store( tail, std::memory_order_release );
+                }
+
+                void Format( const RecordHeader & h, const char * args, const char * end ){
+                    static const char levels[] = { 'D', 'I', 'W', 'E' };
+                    const char * file = std::strrchr( h.site->file, '/' );
+                    file = file ? file + 1 : h.site->file;
+
+                    char prefix[96];
+                    int n = snprintf( prefix, sizeof( prefix ), "[%10.3f] %c %s:%d ", ( h.stamp_ns - start_ns ) / 1e9,
+                                      levels[static_cast<int>( h.site->level ) & 3], file, h.site->line );
+                    out.append( prefix, std::min<size_t>( n, sizeof( prefix ) - 1 ) );
+
+                    // Each conversion is handed to snprintf alone, with the length modifier of the stored type
+                    const char * f = h.format;
+                    while( *f ){
+                        if( *f != '%' ){ out += *f++; continue; }
+                        if( f[1] == '%' ){ out += '%'; f += 2; continue; }
+
+                        char spec[32];
+                        size_t len = 0;
+                        spec[len++] = *f++;
+                        while( *f && std::strchr( "-+ #0123456789.*", *f ) && len < 20 ){ spec[len++] = *f++; }
+                        while( *f && std::strchr( "hlLqjzt", *f ) ){ f++; }
+                        char conversion = *f ? *f++ : 's';
+
+                        char value[max_text + 64];
+                        value[0] = '\0';
+                        if( args < end ){
+                            uint8_t type = static_cast<uint8_t>( *args++ );
+                            if( type == detail::Text ){
+                                size_t size = static_cast<uint8_t>( *args++ );
+                                std::string text( args, size );
+                                args += size;
+                                spec[len++] = 's';
+                                spec[len] = '\0';
+                                snprintf( value, sizeof( value ), spec, text.c_str() );
+                            } else {
+                                uint64_t bits;
+                                std::memcpy( &bits, args, 8 );
+                                args += 8;
+                                if( type == detail::Double ){
+                                    double d;
+                                    std::memcpy( &d, &bits, 8 );
+                                    spec[len++] = std::strchr( "eEfFgGaA", conversion ) ? conversion : 'g';
+                                    spec[len] = '\0';
+                                    snprintf( value, sizeof( value ), spec, d );
+                                } else {
+                                    bool integer = std::strchr( "diouxXc", conversion ) != nullptr;
+                                    spec[len++] = 'l';
+                                    spec[len++] = 'l';
+                                    spec[len++] = integer && conversion != 'c' ? conversion : ( type == detail::Int ? 'd' : 'u' );
+                                    spec[len] = '\0';
+                                    if( type == detail::Int ){ snprintf( value, sizeof( value ), spec, static_cast<long long>( bits ) ); }
+                                    else                     { snprintf( value, sizeof( value ), spec, static_cast<unsigned long long>( bits ) ); }
+                                }
+                            }
+                        }
+                        out += value;
+                    }
+
+                    if( h.suppressed ){ out += " (+" + std::to_string( h.suppressed ) + " suppressed)"; }
+                    out += '\n';
+                }
+
+                void ReportDropped(){
+                    uint64_t now = dropped.load( std::memory_order_relaxed );
+                    if( now != reported_dropped ){
+                        fprintf( stdout, "[log] %llu records dropped, rings full\n",
+                                 static_cast<unsigned long long>( now - reported_dropped ) );
+                        fflush( stdout );
+                        reported_dropped = now;
+                    }
+                }
+
+                const int64_t start_ns;
+                std::mutex mutex;
+                std::condition_variable wake;
+                std::condition_variable flushed;
+                std::vector<std::shared_ptr<Ring>> rings;
+                bool running = true;
+                uint64_t flush_requested = 0;
+                uint64_t flush_done = 0;
+                uint64_t reported_dropped = 0;     // Writer thread only
+                std::string out;                    // Writer thread only
+                std::thread thread;                 // Last, starts once the rest is built
+        };
+
+        Writer & Instance(){
+            static Writer writer;
+            return writer;
+        }
+
+        // Marks the ring of an exiting thread, the writer frees it once drained
+        struct ThreadRing {
+            std::shared_ptr<Ring> ring;
+            ~ThreadRing(){ if( ring ){ ring->orphaned = true; } }
+        };
+        thread_local ThreadRing thread_ring;
+    }
+
+    void SetLevel( Level level ){ detail::min_level = level; }
+    Level GetLevel(){ return detail::min_level; }
+
+    void Flush(){ Instance().Flush(); }
+
+    uint64_t GetDropped(){ return Instance().dropped; }
+
+    namespace detail
+    {
+        char * Reserve( size_t size ){
+            Ring * ring = thread_ring.ring.get();
+            if( !ring ){
+                // Once per thread, the only lock a producer ever takes
+                thread_ring.ring = Instance().Register();
+                ring = thread_ring.ring.get();
+            }
+
+            uint64_t head = ring->head.load( std::memory_order_relaxed );
+            const uint64_t tail = ring->tail.load( std::memory_order_acquire );
+
+            // Records never wrap, the rest of the ring is skipped instead
+            size_t pos = head & ( ring_size - 1 );
+            size_t contiguous = ring_size - pos;
+            size_t needed = size + ( contiguous < size ? contiguous : 0 );
+            if( size > ring_size / 2 || ring_size - ( head - tail ) < needed ){
+                Instance().dropped.fetch_add( 1, std::memory_order_relaxed );
+                return nullptr;
+            }
+
+            if( contiguous < size ){
+                if( contiguous >= header_size ){
+                    RecordHeader pad{};
+                    pad.size = static_cast<uint32_t>( contiguous );
+                    std::memcpy( ring->data + pos, &pad, sizeof( pad ) );
+                }
+                head += contiguous;
+                ring->head.store( head, std::memory_order_release );
+                pos = 0;
+            }
+
+            ring->reserved = head + size;
+            return ring->data + pos;
+        }
+
+        void Commit( char * record, size_t size, Site & site, const char * format ){
+            RecordHeader h;
+            h.size       = static_cast<uint32_t>( size );
+            h.suppressed = site.suppressed.exchange( 0, std::memory_order_relaxed );
+            h.stamp_ns   = timing::NowNs();
+            h.site       = &site;
+            h.format     = format;
+            std::memcpy( record, &h, sizeof( h ) );
+
+            Ring * ring = thread_ring.ring.get();
+            ring->head.store( ring->reserved, std::memory_order_release );
+        }
+    }
+}
@@ -0,0 +1,203 @@
+/************************************
+ * LoopMetrics
+ * Iteration timing of the control loops.
+ *************************************/
+
+#include "LoopMetrics.h"
+#include "Log.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#include <signal.h>
+
+namespace metrics
+{
+    namespace
+    {
+        struct Registry {
+            std::mutex mutex;               // Registration and export, never taken by the loops
+            Loop * loops[max_loops] = {};
+            int count = 0;
+
+            Scheduler exporter{"metrics"};
+            int task = -1;
+            double rate_hz = 0;
+        };
+
+        Registry & Instance(){
+            static Registry registry;
+            return registry;
+        }
+
+        std::atomic<bool> dump_requested{false};
+
+        void OnDumpSignal( int ){
+            dump_requested.store( true, std::memory_order_relaxed );
+        }
+
+        void ExportTask(){
+            Export();
+            if( dump_requested.exchange( false, std::memory_order_relaxed ) ){ Dump(); }
+        }
+    }
+
+    int Histogram::Index( int64_t ns ){
+        uint64_t units = static_cast<uint64_t>( ns ) >> unit_shift;
+        if( units < ( 2u << sub_bits ) ){ return static_cast<int>( units ); }
+
+        int msb = 63 - __builtin_clzll( units );
+        if( msb > max_msb ){ return overflow; }
+
+        // The sub_bits below the leading one select the bucket inside its power of two
+        int shift = msb - sub_bits;
+        return ( shift << sub_bits ) + static_cast<int>( units >> shift );
+    }
+
+    int64_t Histogram::BucketNs( int index ){
+        if( index < ( 2 << sub_bits ) ){ return ( static_cast<int64_t>( index ) << unit_shift ) + ( 1 << ( unit_shift - 1 ) ); }
+
+        int shift = ( index >> sub_bits ) - 1;
+        int64_t sub = ( index & ( ( 1 << sub_bits ) - 1 ) ) + ( 1 << sub_bits );
+        int64_t low = sub << shift;
+        return ( ( low << 1 ) + ( int64_t{1} << shift ) ) << ( unit_shift - 1 );
+    }
+
+    void Histogram::Reset(){
+        for( auto & c : counts ){ c.store( 0, std::memory_order_relaxed ); }
+        total.store( 0, std::memory_order_relaxed );
+        sum_ns.store( 0, std::memory_order_relaxed );
+        min_ns.store( INT64_MAX, std::memory_order_relaxed );
+        max_ns.store( 0, std::memory_order_relaxed );
+    }
+
+    Summary Histogram::Summarize() const {
+        Summary s;
+
+        // Copied first, the loops keep recording while it runs
+        uint64_t snapshot[buckets + 1];
+        uint64_t n = 0;
+        for( int i = 0; i <= overflow; i++ ){
+            snapshot[i] = counts[i].load( std::memory_order_relaxed );
+            n += snapshot[i];
+        }
+        if( n == 0 ){ return s; }
+
+        const double min = min_ns.load( std::memory_order_relaxed ) / 1e6;
+        const double max = max_ns.load( std::memory_order_relaxed ) / 1e6;
+
+        s.count = n;
+        s.mean  = sum_ns.load( std::memory_order_relaxed ) / 1e6 / std::max<uint64_t>( total.load( std::memory_order_relaxed ), 1 );
+        s.min   = min;
+        s.max   = max;
+
+        const double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+        double * out[4] = { &s.p50, &s.p90, &s.p99, &s.p999 };
+
+        uint64_t seen = 0;
+        int q = 0;
+        for( int i = 0; i <= overflow && q < 4; i++ ){
+            seen += snapshot[i];
+            while( q < 4 && seen >= static_cast<uint64_t>( quantiles[q] * n + 0.5 ) && seen > 0 ){
+                // Bucket middles can fall outside the samples actually seen, overflows have no
+                // bucket and report the largest one
+                *out[q++] = i == overflow ? max : std::clamp( BucketNs( i ) / 1e6, min, max );
+            }
+        }
+        return s;
+    }
+
+    Loop::Loop( const char * name ) : name{name}{
+        const std::string key = name;
+        exec_p50 = telemetry::AddNumber( key + "_exec_p50_ms" );
+        exec_p99 = telemetry::AddNumber( key + "_exec_p99_ms" );
+        late_p99 = telemetry::AddNumber( key + "_late_p99_ms" );
+        missed   = telemetry::AddNumber( key + "_misses" );
+
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+        if( r.count < max_loops ){ r.loops[r.count++] = this; }
+    }
+
+    Loop::~Loop(){
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+        Loop ** end = std::remove( r.loops, r.loops + r.count, this );
+        r.count = static_cast<int>( end - r.loops );
+    }
+
+    void Loop::Reset(){
+        exec.Reset();
+        late.Reset();
+        misses.store( 0, std::memory_order_relaxed );
+    }
+
+    void Start( double rate_hz ){
+        Registry & r = Instance();
+        if( rate_hz <= 0 ){ return; }
+
+        if( rate_hz != r.rate_hz ){
+            if( r.task >= 0 ){ r.exporter.SetTaskEnabled( r.task, false ); }
+            r.task = r.exporter.AddTask( "export", 1000.0 / rate_hz, []{ ExportTask(); } );
+            r.rate_hz = rate_hz;
+        }
+        if( !r.exporter.IsRunning() ){
+            struct sigaction action = {};
+            action.sa_handler = OnDumpSignal;
+            sigemptyset( &action.sa_mask );
+            action.sa_flags = SA_RESTART;
+            sigaction( SIGUSR1, &action, nullptr );
+
+            r.exporter.Start();
+        }
+    }
+
+    void Stop(){
+        Instance().exporter.Stop();
+        Export();
+    }
+
+    void Export(){
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+
+        for( int i = 0; i < r.count; i++ ){
+            const Loop & l = *r.loops[i];
+            if( l.exec.Count() == 0 && l.late.Count() == 0 ){ continue; }
+
+            const Summary exec = l.exec.Summarize();
+            const Summary late = l.late.Summarize();
+            telemetry::Set( l.exec_p50, exec.p50 );
+            telemetry::Set( l.exec_p99, exec.p99 );
+            telemetry::Set( l.late_p99, late.p99 );
+            telemetry::Set( l.missed, static_cast<double>( l.misses.load( std::memory_order_relaxed ) ) );
+        }
+    }
+
+    void Dump(){
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+
+        LOG_INFO( "[Metrics] %-18s %8s | exec [ms] %7s %7s %7s %7s | late [ms] %7s %7s %7s | %s",
+                  "loop", "runs", "p50", "p99", "p99.9", "max", "p50", "p99", "max", "misses" );
+        for( int i = 0; i < r.count; i++ ){
+            const Loop & l = *r.loops[i];
+            if( l.exec.Count() == 0 && l.late.Count() == 0 ){ continue; }
+
+            const Summary exec = l.exec.Summarize();
+            const Summary late = l.late.Summarize();
+            LOG_INFO( "[Metrics] %-18s %8llu |           %7.3f %7.3f %7.3f %7.3f |           %7.3f %7.3f %7.3f | %llu",
+                      l.name, static_cast<unsigned long long>( exec.count ),
+                      exec.p50, exec.p99, exec.p999, exec.max, late.p50, late.p99, late.max,
+                      static_cast<unsigned long long>( l.misses.load( std::memory_order_relaxed ) ) );
+        }
+    }
+
+    void ResetAll(){
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+        for( int i = 0; i < r.count; i++ ){ r.loops[i]->Reset(); }
+    }
+}
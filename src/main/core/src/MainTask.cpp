@@ -5,29 +5,14 @@
 
 int MainTask() { 
 
-    A = { "A", {  35,  35,  -1 }, {&B, &C, &G}};
-    B = { "B", {  35, 305,  -1 }, {&A, &C}    };
-    C = { "C", {  35, 365,  -1 }, {&A, &B, &D}};
-    D = { "D", { 370, 365,  -1 }, {&C, &E, &F}};
-    E = { "E", { 370, 235,  -1 }, {&D, &F}    };
-    F = { "F", { 370,  30,   0 }, {&D, &E, &A}};
-    G = { "G", {  35,  35, 180 }, {&A, &H}    };
-    H = { "H", { 200,  35, 180 }, {&G, &F}    };
-
-    Coord take_basket_coord = { "t_b", { 360,  65, 0 }, {&F, &D, &E} };
-    Coord deli_basket_coord = { "d_b", { 360, 325, 0 }, {&F, &D, &E} }; 
-
-    Object obj1 = { grape_purple, {"obj1", {100, 365,   0}, {&C, &D}}};
-    Object obj2 = { grape_yellow, {"obj2", {300, 365,   0}, {&C, &D}}};
-    Object obj3 = { grape_green , {"obj3", {100, 305,   0}, {&B}    }};
-    Object obj4 = { grape_yellow, {"obj4", {300, 235, 180}, {&E}    }};
-
-
-
     // // Start MockDS
     Robot r;
     r.ds.Enable();
 
+    telemetry::Start();
+    metrics::Start();
+    sensor.StartAcquisition();
+    movement.StartOdometry();
     // lidar.StartLidar();
     // cam.StartCamera();
 
@@ -47,28 +32,16 @@ int MainTask() {
     // robot_th = setAngle();
     // set_position( robot_x, robot_y, robot_th );  
 
-    Coord current_point = { "cur", {get_x(),get_y(),get_th()}, {&C} };
-    path_driver( best_way( D, current_point ) );
-
-    current_point = { "cur", {get_x(),get_y(),get_th()}, prev_Coord.neighbor };
-    path_driver( best_way( deli_basket_coord, current_point ) );
-
-    // Coord current_point = { "cur", {get_x(),get_y(),get_th()}, {&A} };
-    // path_driver( best_way( obj1.coord, current_point ) );
-
-    // current_point = { "cur", {get_x(),get_y(),get_th()}, prev_Coord.neighbor };
-    // path_driver( best_way( obj3.coord, current_point ) );
-
-    // current_point = { "cur", {get_x(),get_y(),get_th()}, prev_Coord.neighbor };
-    // path_driver( best_way( deli_basket_coord, current_point ) );
-
-    // current_point = { "cur", {get_x(),get_y(),get_th()}, prev_Coord.neighbor };
-    // path_driver( best_way( A, current_point ) );
-
+    // Both legs start from where the odometry puts the robot
+    path_driver( field_way( field::D ) );
+    path_driver( field_way( field::DELIVER_BASKET ) );
 
+    // path_driver( field_way( field::OBJ1, field::A ) );
+    // path_driver( field_way( field::OBJ3, field::OBJ1 ) );
+    // path_driver( field_way( field::DELIVER_BASKET, field::OBJ3 ) );
+    // path_driver( field_way( field::A, field::DELIVER_BASKET ) );
 
-    // current_point = { "cur", {35,35,0}, {&F} };
-    // path_driver( best_way( obj2.coord, current_point ) );
+    // path_driver( field_way( field::OBJ2, field::F ) );
 
 
    return 0; 
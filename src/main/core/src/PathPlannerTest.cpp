@@ -18,12 +18,18 @@ int PathPlannerTest() {
     Robot r;
     r.ds.Enable();
 
+    telemetry::Start();
+
     // Initialize PathPlanner communication
     pathplanner_init();
 
     // Initialize robot position
     set_position(0, 0, 0);  // Start at origin
 
+    // Correct odometry against the map once the GUI sends it
+    lidar.StartLidar();
+    localization_start();
+
     std::cout << "\n[FRC] Robot initialized at origin (0, 0, 0)" << std::endl;
     std::cout << "[FRC] Waiting for GUI connection on port 5800..." << std::endl;
     std::cout << "[FRC] Open RobotPathPlanner GUI and connect to robot IP" << std::endl;
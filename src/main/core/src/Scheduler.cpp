@@ -0,0 +1,225 @@
+/************************************
+ * Scheduler
+ * Fixed-rate periodic scheduling for the control loops.
+ *************************************/
+
+#include "Scheduler.h"
+#include "LoopMetrics.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace timing
+{
+    static std::atomic<Clock *> clock{ nullptr };
+
+    void SetClock( Clock * c ){
+        clock.store( c, std::memory_order_release );
+    }
+
+    int64_t NowNs(){
+        if( Clock * c = clock.load( std::memory_order_acquire ) ){ return c->NowNs(); }
+
+        struct timespec ts;
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        return static_cast<int64_t>( ts.tv_sec ) * 1000000000LL + ts.tv_nsec;
+    }
+
+    void SleepUntilNs( int64_t deadline_ns ){
+        if( Clock * c = clock.load( std::memory_order_acquire ) ){ c->SleepUntilNs( deadline_ns ); return; }
+
+        struct timespec ts;
+        ts.tv_sec  = deadline_ns / 1000000000LL;
+        ts.tv_nsec = deadline_ns % 1000000000LL;
+
+        while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr ) == EINTR ){}
+    }
+
+    bool SetRealtime( int priority, int cpu ){
+        bool ok = true;
+
+        if( priority > 0 ){
+            struct sched_param param;
+            param.sched_priority = std::min( priority, sched_get_priority_max( SCHED_FIFO ) );
+            if( pthread_setschedparam( pthread_self(), SCHED_FIFO, &param ) != 0 ){ ok = false; }
+        }
+
+        if( cpu >= 0 ){
+            cpu_set_t set;
+            CPU_ZERO( &set );
+            CPU_SET( cpu, &set );
+            if( pthread_setaffinity_np( pthread_self(), sizeof(set), &set ) != 0 ){ ok = false; }
+        }
+
+        return ok;
+    }
+}
+
+Rate::Rate( double period_ms, metrics::Loop * loop ) : period_ms{period_ms}, loop{loop} {
+    period_ns = static_cast<int64_t>( period_ms * 1e6 );
+    Reset();
+}
+
+void Rate::Reset(){
+    deadline_ns = timing::NowNs() + period_ns;
+    if( loop ){ wake_ns = metrics::ReadNs(); }
+}
+
+double Rate::Sleep(){
+
+    int64_t now = timing::NowNs();
+    if( loop ){ loop->RecordExec( metrics::ReadNs() - wake_ns ); }
+
+    // Any overrun of the deadline is a miss, even when the next one is still ahead
+    if( now > deadline_ns ){
+        missed++;
+        if( loop ){ loop->CountMiss(); }
+    }
+
+    // The loop body took longer than a whole period: re-anchor instead of
+    // firing a burst of back-to-back iterations to catch up
+    if( now > deadline_ns + period_ns ){
+        if( loop ){
+            loop->RecordLate( now - deadline_ns );
+            wake_ns = metrics::ReadNs();
+        }
+        deadline_ns = now + period_ns;
+        return 0;
+    }
+
+    timing::SleepUntilNs( deadline_ns );
+
+    int64_t late_ns = timing::NowNs() - deadline_ns;
+    deadline_ns += period_ns;
+
+    if( loop ){
+        loop->RecordLate( late_ns );
+        wake_ns = metrics::ReadNs();
+    }
+
+    return late_ns / 1e6;
+}
+
+int Scheduler::AddTask( const std::string & task_name, double period_ms, std::function<void()> task ){
+    std::lock_guard<std::mutex> lock( task_mutex );
+
+    Task t;
+    t.id        = next_id++;
+    t.name      = task_name;
+    t.period_ns = static_cast<int64_t>( period_ms * 1e6 );
+    t.next_ns   = timing::NowNs();
+    t.enabled   = true;
+    t.fn        = std::move( task );
+
+    tasks.push_back( std::move( t ) );
+
+    return tasks.back().id;
+}
+
+void Scheduler::SetTaskEnabled( int id, bool enabled ){
+    std::lock_guard<std::mutex> lock( task_mutex );
+
+    for( Task & t : tasks ){
+        if( t.id == id ){
+            t.enabled = enabled;
+            t.next_ns = timing::NowNs();
+        }
+    }
+}
+
+bool Scheduler::Start( int priority, int cpu ){
+    if( running ){ return false; }
+
+    running = true;
+    thread = std::thread( &Scheduler::Run, this, priority, cpu );
+
+    return true;
+}
+
+void Scheduler::Stop(){
+    if( !running ){ return; }
+
+    running = false;
+    if( thread.joinable() ){ thread.join(); }
+}
+
+std::vector<Scheduler::TaskStats> Scheduler::GetStats(){
+    std::lock_guard<std::mutex> lock( task_mutex );
+
+    std::vector<TaskStats> stats;
+    for( const Task & t : tasks ){
+        stats.push_back( { t.name, t.period_ns / 1e6, t.runs, t.overruns,
+                           t.last_exec_ns / 1e6, t.max_exec_ns / 1e6, t.max_late_ns / 1e6 } );
+    }
+    return stats;
+}
+
+void Scheduler::Run( int priority, int cpu ){
+
+    if( ( priority > 0 || cpu >= 0 ) && !timing::SetRealtime( priority, cpu ) ){
+        LOG_WARN( "[Scheduler] %s: could not apply priority %d / cpu %d, running with default scheduling", name.c_str(), priority, cpu );
+    }
+
+    // Tasks due this round with the deadline they were due at
+    struct Due {
+        Task * task;
+        int64_t deadline_ns;
+    };
+    std::vector<Due> due;
+
+    while( running ){
+
+        int64_t wake_ns = timing::NowNs() + idle_period_ns;
+        {
+            std::lock_guard<std::mutex> lock( task_mutex );
+            for( const Task & t : tasks ){
+                if( t.enabled ){ wake_ns = std::min( wake_ns, t.next_ns ); }
+            }
+        }
+
+        timing::SleepUntilNs( wake_ns );
+
+        // Picked under the lock and run outside it: SetTaskEnabled() and GetStats()
+        // never wait for a task body, and a task can call them itself
+        due.clear();
+        {
+            std::lock_guard<std::mutex> lock( task_mutex );
+            int64_t now = timing::NowNs();
+            for( Task & t : tasks ){
+                if( t.enabled && t.next_ns <= now ){ due.push_back( { &t, t.next_ns } ); }
+            }
+        }
+
+        for( const Due & d : due ){
+            Task & t = *d.task;
+
+            int64_t start = timing::NowNs();
+            t.fn();
+            int64_t end = timing::NowNs();
+
+            std::lock_guard<std::mutex> lock( task_mutex );
+
+            t.max_late_ns  = std::max( t.max_late_ns, start - d.deadline_ns );
+            t.last_exec_ns = end - start;
+            t.max_exec_ns  = std::max( t.max_exec_ns, t.last_exec_ns );
+            t.runs++;
+
+            // SetTaskEnabled() during the run re-anchored the task already
+            if( t.next_ns != d.deadline_ns ){ continue; }
+
+            // Next deadline is absolute, so execution time never accumulates as drift.
+            // Deadlines already in the past are skipped rather than run back-to-back.
+            t.next_ns += t.period_ns;
+            if( t.next_ns <= end ){
+                int64_t skipped = ( end - t.next_ns ) / t.period_ns + 1;
+                t.overruns += skipped;
+                t.next_ns  += skipped * t.period_ns;
+            }
+        }
+    }
+}
@@ -9,6 +9,10 @@ int SimpleTask() {
     Robot r;
     r.ds.Enable();
 
+    telemetry::Start();
+    metrics::Start();
+    sensor.StartAcquisition();
+    movement.StartOdometry();
     lidar.StartLidar();
     cam.StartCamera();
 
@@ -23,6 +27,7 @@ int SimpleTask() {
 
   
     set_position( 30, 30, 270 );
+    pose_fusion( true );
 
     // linear_align( 20, "back" );
     // // angular_align();
@@ -180,6 +185,7 @@ int SimpleTask() {
 
 
     lidar.StopLidar(); 
+    sensor.StopAcquisition();
     r.ds.Disable();
 
     return 0; 
@@ -0,0 +1,130 @@
+/************************************
+ * Telemetry
+ * Batched dashboard values for the control loops.
+ *************************************/
+
+#include "Telemetry.h"
+#include "Scheduler.h"
+
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <networktables/NetworkTableEntry.h>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace telemetry
+{
+    namespace detail
+    {
+        std::atomic<double> values[max_entries];
+        std::atomic<uint64_t> dirty[max_entries / 64];
+    }
+
+    namespace
+    {
+        enum class Type : uint8_t { Number, Boolean, String };
+
+        struct Registry {
+            std::mutex mutex;                               // Registration and strings
+            std::unordered_map<std::string, int> index;
+            std::string keys[max_entries];
+            Type types[max_entries];
+            std::string strings[max_entries];
+            int count = 0;
+
+            std::mutex publish_mutex;                       // One publish at a time
+            nt::NetworkTableEntry entries[max_entries];     // Created by the first publish
+            std::atomic<uint64_t> published{0};
+
+            Scheduler publisher{"telemetry"};
+            int task = -1;
+            double rate_hz = 0;
+        };
+
+        Registry & Instance(){
+            static Registry registry;
+            return registry;
+        }
+
+        int Add( const std::string & key, Type type ){
+            Registry & r = Instance();
+            std::lock_guard<std::mutex> lock( r.mutex );
+
+            auto it = r.index.find( key );
+            if( it != r.index.end() ){ return r.types[it->second] == type ? it->second : -1; }
+            if( r.count == max_entries ){ return -1; }
+
+            int i = r.count++;
+            r.keys[i]  = key;
+            r.types[i] = type;
+            r.index.emplace( key, i );
+
+            // Published once so the key shows up on the dashboard before its first change
+            detail::dirty[i >> 6].fetch_or( uint64_t{1} << ( i & 63 ), std::memory_order_release );
+            return i;
+        }
+    }
+
+    Number  AddNumber ( const std::string & key ){ return Number { Add( key, Type::Number  ) }; }
+    Boolean AddBoolean( const std::string & key ){ return Boolean{ Add( key, Type::Boolean ) }; }
+    String  AddString ( const std::string & key ){ return String { Add( key, Type::String  ) }; }
+
+    void detail::StageString( int index, const char * v ){
+        if( index < 0 ){ return; }
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> lock( r.mutex );
+        if( r.strings[index] == v ){ return; }
+        r.strings[index] = v;
+        dirty[index >> 6].fetch_or( uint64_t{1} << ( index & 63 ), std::memory_order_release );
+    }
+
+    void Publish(){
+        Registry & r = Instance();
+        std::lock_guard<std::mutex> publish_lock( r.publish_mutex );
+
+        for( int w = 0; w < max_entries / 64; w++ ){
+            uint64_t bits = detail::dirty[w].exchange( 0, std::memory_order_acquire );
+            while( bits ){
+                int i = w * 64 + __builtin_ctzll( bits );
+                bits &= bits - 1;
+
+                Type type;
+                std::string text;
+                {
+                    std::lock_guard<std::mutex> lock( r.mutex );
+                    type = r.types[i];
+                    if( !r.entries[i] ){ r.entries[i] = frc::SmartDashboard::GetEntry( r.keys[i] ); }
+                    if( type == Type::String ){ text = r.strings[i]; }
+                }
+
+                double v = detail::values[i].load( std::memory_order_relaxed );
+                switch( type ){
+                    case Type::Number:  r.entries[i].SetDouble( v );        break;
+                    case Type::Boolean: r.entries[i].SetBoolean( v != 0 );  break;
+                    case Type::String:  r.entries[i].SetString( text );     break;
+                }
+                r.published.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+    }
+
+    void Start( double rate_hz ){
+        Registry & r = Instance();
+        if( rate_hz <= 0 ){ return; }
+
+        if( rate_hz != r.rate_hz ){
+            if( r.task >= 0 ){ r.publisher.SetTaskEnabled( r.task, false ); }
+            r.task = r.publisher.AddTask( "publish", 1000.0 / rate_hz, []{ Publish(); } );
+            r.rate_hz = rate_hz;
+        }
+        if( !r.publisher.IsRunning() ){ r.publisher.Start(); }
+    }
+
+    void Stop(){
+        Registry & r = Instance();
+        r.publisher.Stop();
+        Publish();      // Last values, so the dashboard does not keep stale ones
+    }
+
+    uint64_t GetPublished(){ return Instance().published; }
+}
@@ -0,0 +1,64 @@
+/************************************
+ * FieldGraph
+ * Waypoint graph of the field with integer node ids.
+ *
+ * Nodes and directed edges are added once, then Build() packs the
+ * adjacency in CSR form with cached edge costs and runs Dijkstra from
+ * every node, so any route is a walk through the next hop table.
+ * AStar() answers single queries without the tables.
+ *
+ * Edge cost is the euclidean length plus hop_cost, a small penalty
+ * that prefers routes with fewer stops.
+ *************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class FieldGraph
+{
+    public:
+        static constexpr double hop_cost = 1.0;     // [cm] added to every edge
+
+        // Both invalidate the tables until the next Build()
+        int  AddNode( double x, double y );
+        void AddEdge( int from, int to );
+        void Clear();
+
+        void Build();
+        bool IsBuilt() const { return built; }
+
+        int    NodeCount() const { return static_cast<int>( node_x.size() ); }
+        double X( int node ) const { return node_x[node]; }
+        double Y( int node ) const { return node_y[node]; }
+        double EdgeCost( double x1, double y1, double x2, double y2 ) const;
+
+        // Shortest route cost, negative when unreachable. Needs Build().
+        double Cost( int from, int to ) const;
+        // Next node after from on the shortest route to to, -1 when unreachable. Needs Build().
+        int NextHop( int from, int to ) const;
+        // Nodes from..to inclusive, false when unreachable. Needs Build().
+        bool Route( int from, int to, std::vector<int> & route ) const;
+
+        // Single query straight on the CSR adjacency, false when unreachable. Needs Build().
+        bool AStar( int from, int to, std::vector<int> & route ) const;
+
+    private:
+        void Dijkstra( int source );
+
+        std::vector<double> node_x;
+        std::vector<double> node_y;
+        std::vector<std::pair<int, int>> edges;
+
+        // CSR adjacency: edges of node n are [offset[n], offset[n + 1])
+        std::vector<int>   offset;
+        std::vector<int>   target;
+        std::vector<float> weight;
+
+        // All pairs tables, row = source
+        std::vector<float>   cost;
+        std::vector<int32_t> next;
+
+        bool built = false;
+};
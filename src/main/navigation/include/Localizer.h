@@ -0,0 +1,102 @@
+/************************************
+ * Localizer
+ * Scan to map matching against the wall segments sent by the GUI.
+ *
+ * The map is rasterized once into a truncated distance field, so a match
+ * only samples the field: Gauss-Newton on the distance of every scan
+ * point to the nearest wall, starting from the odometry pose. Accepted
+ * matches are blended into Movement through CorrectPose().
+ *
+ * Map and field are in meters, the GUI frame. Movement works in cm and degrees.
+ *************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Constants.h"
+#include "Movement.h"
+#include "lidar.h"
+#include "PathPlannerComm.h"
+#include "SeqLock.h"
+
+// Distance to the closest wall sampled on a regular grid
+struct DistanceField {
+    double origin_x = 0;        // [m] center of cell (0, 0)
+    double origin_y = 0;
+    double resolution = 0;      // [m] cell size
+    int width  = 0;
+    int height = 0;
+    std::vector<float> cells;   // [m] row major, truncated at max_distance
+
+    // Bilinear lookup, false outside the grid
+    bool Sample( double x, double y, double & d, double & gx, double & gy ) const;
+};
+
+struct LocalizerStatus {
+    bool     has_map = false;
+    uint32_t matches = 0;
+    uint32_t accepted = 0;
+    double   residual = 0;      // [m] rms of the inliers of the last match
+    double   inlier_ratio = 0;
+    double   dx = 0;            // [cm] last correction sent
+    double   dy = 0;
+    double   dth = 0;           // [degrees]
+    double   match_us = 0;      // Time spent on the last match
+};
+
+class Localizer
+{
+    public:
+        Localizer( Movement * m, Lidar * l ) : move{m}, lidar{l}{}
+        ~Localizer(){ Stop(); }
+
+        // Builds the distance field, safe to call from the communication thread
+        void SetMap( const PathPlanner::FieldMap & map );
+
+        // Matches every new scan on the lidar ingest thread
+        void Start();
+        void Stop();
+        bool IsRunning() const { return running; }
+
+        // Refines pose (x, y [cm], th [degrees]) against the map, true when the match is trusted.
+        // Residual [m] and inlier ratio describe the final iteration.
+        bool Match( const studica::Lidar::ScanData & scan, double & x, double & y, double & th,
+                    double & residual, double & inlier_ratio ) const;
+
+        LocalizerStatus GetStatus() const { return status.Load(); }
+
+        static constexpr double resolution      = 0.02;   // [m] distance field cell
+        static constexpr double map_margin      = 0.5;    // [m] around the walls bounding box
+        static constexpr double max_distance    = 0.5;    // [m] distance field truncation
+        static constexpr double min_range       = 0.05;   // [m]
+        static constexpr double max_range       = 5.0;    // [m]
+        static constexpr int    beam_step       = 2;      // Use every n-th beam
+        static constexpr int    max_iterations  = 10;
+        static constexpr double outlier_dist    = 0.25;   // [m] points farther from any wall are ignored
+        static constexpr int    min_points      = 30;
+        static constexpr double min_inliers     = 0.5;    // Fraction of the used points
+        static constexpr double max_residual    = 0.04;   // [m]
+        static constexpr double max_jump_xy     = 30;     // [cm] larger corrections are rejected
+        static constexpr double max_jump_th     = 15;     // [degrees]
+        static constexpr double gain            = 0.3;    // Fraction of the correction applied per scan
+
+    private:
+        Movement * move;
+        Lidar * lidar;
+
+        void OnScan( const LidarFrame & frame );
+
+        // Swapped atomically, the matcher keeps its own reference during a match
+        std::shared_ptr<const DistanceField> field;
+
+        SeqLock<LocalizerStatus> status;     // Written by the matching thread only
+        LocalizerStatus current;
+        std::mutex status_mutex;             // SetMap and OnScan both update it
+
+        std::atomic<bool> running{false};
+        uint32_t pending_correction = 0;     // Version returned by CorrectPose
+};
@@ -0,0 +1,161 @@
+/************************************
+ * StaticFieldGraph
+ * Waypoint graph fixed at compile time.
+ *
+ * A constexpr object holds node positions, the directed edges and the
+ * all pairs cost and next hop tables (Floyd-Warshall in the constructor),
+ * so route lookups are table reads without allocation. The Check*()
+ * functions are meant for static_assert next to the layout definition.
+ *
+ * Edge cost matches FieldGraph: euclidean length plus hop_cost.
+ *************************************/
+
+#pragma once
+
+namespace field {
+
+    struct Node {
+        double x  = 0;      // [cm]
+        double y  = 0;      // [cm]
+        double th = -1;     // [degrees], -1 keeps the current heading
+    };
+
+    struct Edge {
+        int from = 0;
+        int to   = 0;
+    };
+
+    constexpr double Sqrt( double v ){
+        if( v <= 0 ){ return 0; }
+
+        double x = v > 1 ? v : 1;
+        for( int i = 0; i < 64; i++ ){
+            double next = 0.5 * ( x + v / x );
+            if( next == x ){ break; }
+            x = next;
+        }
+        return x;
+    }
+
+    template <int N>
+    struct Route {
+        int node[N] = {};
+        int count = 0;
+    };
+
+    template <int N, int M>
+    class StaticFieldGraph
+    {
+        public:
+            static constexpr double hop_cost    = 1.0;      // [cm] added to every edge
+            static constexpr double unreachable = 1e30;
+
+            constexpr StaticFieldGraph( const Node (&n)[N], const Edge (&e)[M] ){
+                for( int i = 0; i < N; i++ ){ nodes[i] = n[i]; }
+                for( int k = 0; k < M; k++ ){ edges[k] = e[k]; }
+
+                for( int i = 0; i < N; i++ ){
+                    for( int j = 0; j < N; j++ ){
+                        cost[i][j] = ( i == j ) ? 0 : unreachable;
+                        next[i][j] = ( i == j ) ? i : -1;
+                    }
+                }
+
+                // Invalid edges are left to CheckEdges() so the build fails with its message
+                for( int k = 0; k < M; k++ ){
+                    int a = edges[k].from, b = edges[k].to;
+                    if( a < 0 || b < 0 || a >= N || b >= N || a == b ){ continue; }
+
+                    double c = EdgeCost( a, b );
+                    if( c < cost[a][b] ){
+                        cost[a][b] = c;
+                        next[a][b] = b;
+                    }
+                }
+
+                for( int k = 0; k < N; k++ ){
+                    for( int i = 0; i < N; i++ ){
+                        if( cost[i][k] >= unreachable ){ continue; }
+                        for( int j = 0; j < N; j++ ){
+                            double c = cost[i][k] + cost[k][j];
+                            if( c < cost[i][j] ){
+                                cost[i][j] = c;
+                                next[i][j] = next[i][k];
+                            }
+                        }
+                    }
+                }
+            }
+
+            constexpr int  Size() const { return N; }
+            constexpr const Node & GetNode( int id ) const { return nodes[id]; }
+
+            constexpr double EdgeCost( int a, int b ) const {
+                double dx = nodes[b].x - nodes[a].x;
+                double dy = nodes[b].y - nodes[a].y;
+                return Sqrt( dx * dx + dy * dy ) + hop_cost;
+            }
+
+            // Negative when unreachable
+            constexpr double Cost( int from, int to ) const {
+                if( !Contains( from ) || !Contains( to ) || cost[from][to] >= unreachable ){ return -1; }
+                return cost[from][to];
+            }
+
+            // -1 when unreachable
+            constexpr int NextHop( int from, int to ) const {
+                if( !Contains( from ) || !Contains( to ) ){ return -1; }
+                return next[from][to];
+            }
+
+            // Nodes from..to inclusive, empty when unreachable
+            constexpr Route<N> GetRoute( int from, int to ) const {
+                Route<N> r;
+                if( NextHop( from, to ) < 0 ){ return r; }
+
+                r.node[r.count++] = from;
+                for( int n = from; n != to; ){
+                    n = next[n][to];
+                    r.node[r.count++] = n;
+                }
+                return r;
+            }
+
+            // Build time validation
+            constexpr bool CheckEdges() const {
+                for( int k = 0; k < M; k++ ){
+                    if( !Contains( edges[k].from ) || !Contains( edges[k].to ) || edges[k].from == edges[k].to ){ return false; }
+                    for( int j = 0; j < k; j++ ){
+                        if( edges[j].from == edges[k].from && edges[j].to == edges[k].to ){ return false; }
+                    }
+                }
+                return true;
+            }
+
+            constexpr bool CheckConnected() const {
+                for( int i = 0; i < N; i++ ){
+                    for( int j = 0; j < N; j++ ){
+                        if( cost[i][j] >= unreachable ){ return false; }
+                    }
+                }
+                return true;
+            }
+
+            constexpr bool CheckInside( double min_x, double min_y, double max_x, double max_y ) const {
+                for( int i = 0; i < N; i++ ){
+                    if( nodes[i].x < min_x || nodes[i].x > max_x || nodes[i].y < min_y || nodes[i].y > max_y ){ return false; }
+                    if( nodes[i].th != -1 && ( nodes[i].th < -360 || nodes[i].th > 360 ) ){ return false; }
+                }
+                return true;
+            }
+
+        private:
+            constexpr bool Contains( int id ) const { return id >= 0 && id < N; }
+
+            Node   nodes[N]   = {};
+            Edge   edges[M]   = {};
+            double cost[N][N] = {};
+            int    next[N][N] = {};
+    };
+
+}
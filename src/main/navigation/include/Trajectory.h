@@ -0,0 +1,65 @@
+/************************************
+ * Trajectory
+ * Time parameterized path through a list of waypoints.
+ *
+ * Generate() passes a centripetal Catmull-Rom spline through the points,
+ * samples it about every sample_step, and limits the speed of every
+ * sample by the path curvature (centripetal acceleration and turn rate)
+ * and by the waypoint speeds. A forward and a backward pass then apply
+ * the acceleration limit, giving a trapezoidal profile that only slows
+ * down where the path needs it. Sample() interpolates the state at a time.
+ *
+ * Units are the Movement ones: cm, cm/s and radians, angles counter clockwise.
+ *************************************/
+
+#pragma once
+
+#include <vector>
+
+struct TrajectoryPoint {
+    double x = 0;               // [cm]
+    double y = 0;               // [cm]
+    double velocity = 0;        // [cm/s] speed through the point, 0 = only the global limits
+};
+
+struct TrajectoryConstraints {
+    double max_velocity     = 20;   // [cm/s]
+    double max_acceleration = 20;   // [cm/s^2]
+    double max_centripetal  = 20;   // [cm/s^2]
+    double max_angular      = 1.5;  // [rad/s]
+    double start_velocity   = 0;    // [cm/s]
+    double end_velocity     = 0;    // [cm/s]
+};
+
+struct TrajectoryState {
+    double t  = 0;              // [s]
+    double s  = 0;              // [cm] distance along the path
+    double x  = 0;              // [cm]
+    double y  = 0;              // [cm]
+    double th = 0;              // [rad] path tangent
+    double k  = 0;              // [1/cm] signed curvature, positive turning left
+    double v  = 0;              // [cm/s]
+    double a  = 0;              // [cm/s^2]
+};
+
+class Trajectory
+{
+    public:
+        static constexpr double sample_step = 1.0;     // [cm]
+
+        // False when the points do not span any distance, the trajectory is left empty
+        bool Generate( const std::vector<TrajectoryPoint> & points, const TrajectoryConstraints & c );
+        void Clear(){ states.clear(); }
+
+        bool   Empty() const { return states.empty(); }
+        double Duration() const { return states.empty() ? 0 : states.back().t; }
+        double Length() const { return states.empty() ? 0 : states.back().s; }
+
+        // Clamped to [0, Duration()], needs a non empty trajectory
+        TrajectoryState Sample( double t ) const;
+
+        const std::vector<TrajectoryState> & States() const { return states; }
+
+    private:
+        std::vector<TrajectoryState> states;
+};
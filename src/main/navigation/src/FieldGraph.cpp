@@ -0,0 +1,175 @@
+/************************************
+ * FieldGraph
+ * Waypoint graph of the field with integer node ids.
+ *************************************/
+
+#include "FieldGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+    constexpr float unreachable = std::numeric_limits<float>::infinity();
+
+    using QueueItem = std::pair<float, int>;    // cost, node
+    using MinQueue  = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+}
+
+int FieldGraph::AddNode( double x, double y ){
+    node_x.push_back( x );
+    node_y.push_back( y );
+    built = false;
+    return NodeCount() - 1;
+}
+
+void FieldGraph::AddEdge( int from, int to ){
+    if( from < 0 || to < 0 || from >= NodeCount() || to >= NodeCount() || from == to ){ return; }
+
+    edges.emplace_back( from, to );
+    built = false;
+}
+
+void FieldGraph::Clear(){
+    node_x.clear();
+    node_y.clear();
+    edges.clear();
+    offset.clear();
+    target.clear();
+    weight.clear();
+    cost.clear();
+    next.clear();
+    built = false;
+}
+
+double FieldGraph::EdgeCost( double x1, double y1, double x2, double y2 ) const {
+    return std::hypot( x2 - x1, y2 - y1 ) + hop_cost;
+}
+
+void FieldGraph::Build(){
+    const int n = NodeCount();
+
+    // Duplicated edges would only cost memory
+    std::sort( edges.begin(), edges.end() );
+    edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+
+    offset.assign( n + 1, 0 );
+    for( const auto & e : edges ){ offset[e.first + 1]++; }
+    for( int i = 0; i < n; i++ ){ offset[i + 1] += offset[i]; }
+
+    // Edges are sorted by source, so they land in CSR order
+    target.resize( edges.size() );
+    weight.resize( edges.size() );
+    for( size_t k = 0; k < edges.size(); k++ ){
+        int a = edges[k].first, b = edges[k].second;
+        target[k] = b;
+        weight[k] = static_cast<float>( EdgeCost( node_x[a], node_y[a], node_x[b], node_y[b] ) );
+    }
+
+    cost.assign( static_cast<size_t>( n ) * n, unreachable );
+    next.assign( static_cast<size_t>( n ) * n, -1 );
+
+    for( int s = 0; s < n; s++ ){ Dijkstra( s ); }
+
+    built = true;
+}
+
+void FieldGraph::Dijkstra( int source ){
+    const int n = NodeCount();
+    float   * dist  = &cost[ static_cast<size_t>( source ) * n ];
+    int32_t * first = &next[ static_cast<size_t>( source ) * n ];
+
+    MinQueue queue;
+    dist[source]  = 0;
+    first[source] = source;
+    queue.push( { 0.0f, source } );
+
+    while( !queue.empty() ){
+        QueueItem top = queue.top();
+        queue.pop();
+
+        int u = top.second;
+        if( top.first > dist[u] ){ continue; }
+
+        for( int k = offset[u]; k < offset[u + 1]; k++ ){
+            int v = target[k];
+            float d = dist[u] + weight[k];
+            if( d < dist[v] ){
+                dist[v]  = d;
+                first[v] = ( u == source ) ? v : first[u];
+                queue.push( { d, v } );
+            }
+        }
+    }
+}
+
+double FieldGraph::Cost( int from, int to ) const {
+    if( !built || from < 0 || to < 0 || from >= NodeCount() || to >= NodeCount() ){ return -1; }
+
+    float c = cost[ static_cast<size_t>( from ) * NodeCount() + to ];
+    return std::isinf( c ) ? -1 : c;
+}
+
+int FieldGraph::NextHop( int from, int to ) const {
+    if( !built || from < 0 || to < 0 || from >= NodeCount() || to >= NodeCount() ){ return -1; }
+
+    return next[ static_cast<size_t>( from ) * NodeCount() + to ];
+}
+
+bool FieldGraph::Route( int from, int to, std::vector<int> & route ) const {
+    route.clear();
+    if( NextHop( from, to ) < 0 ){ return false; }
+
+    route.push_back( from );
+    for( int node = from; node != to; ){
+        node = NextHop( node, to );
+        route.push_back( node );
+    }
+    return true;
+}
+
+bool FieldGraph::AStar( int from, int to, std::vector<int> & route ) const {
+    route.clear();
+
+    const int n = NodeCount();
+    if( !built || from < 0 || to < 0 || from >= n || to >= n ){ return false; }
+
+    // Straight line distance never overestimates, every edge costs at least its length
+    auto heuristic = [&]( int node ){
+        return static_cast<float>( std::hypot( node_x[to] - node_x[node], node_y[to] - node_y[node] ) );
+    };
+
+    std::vector<float> g( n, unreachable );
+    std::vector<int>   parent( n, -1 );
+
+    MinQueue open;
+    g[from] = 0;
+    open.push( { heuristic( from ), from } );
+
+    while( !open.empty() ){
+        QueueItem top = open.top();
+        open.pop();
+
+        int u = top.second;
+        if( u == to ){ break; }
+        if( top.first > g[u] + heuristic( u ) ){ continue; }
+
+        for( int k = offset[u]; k < offset[u + 1]; k++ ){
+            int v = target[k];
+            float d = g[u] + weight[k];
+            if( d < g[v] ){
+                g[v] = d;
+                parent[v] = u;
+                open.push( { d + heuristic( v ), v } );
+            }
+        }
+    }
+
+    if( std::isinf( g[to] ) ){ return false; }
+
+    for( int node = to; node != -1; node = parent[node] ){ route.push_back( node ); }
+    std::reverse( route.begin(), route.end() );
+    return true;
+}
@@ -0,0 +1,247 @@
+/************************************
+ * Localizer
+ * Scan to map matching against the wall segments sent by the GUI.
+ *************************************/
+
+#include "Localizer.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    double SegmentDistance( double px, double py, const PathPlanner::WallSegment & w ){
+        double dx = w.x2 - w.x1;
+        double dy = w.y2 - w.y1;
+        double len2 = dx * dx + dy * dy;
+
+        double t = len2 > 0 ? ( ( px - w.x1 ) * dx + ( py - w.y1 ) * dy ) / len2 : 0;
+        t = std::min( std::max( t, 0.0 ), 1.0 );
+
+        double ex = w.x1 + t * dx - px;
+        double ey = w.y1 + t * dy - py;
+        return std::sqrt( ex * ex + ey * ey );
+    }
+
+    double WrapDegrees( double ang ){
+        while( ang >  180 ){ ang -= 360; }
+        while( ang < -180 ){ ang += 360; }
+        return ang;
+    }
+
+    // Solves the 3x3 symmetric system A * x = b, false when singular
+    bool Solve3( const double A[3][3], const double b[3], double x[3] ){
+        double det = A[0][0] * ( A[1][1] * A[2][2] - A[1][2] * A[2][1] )
+                   - A[0][1] * ( A[1][0] * A[2][2] - A[1][2] * A[2][0] )
+                   + A[0][2] * ( A[1][0] * A[2][1] - A[1][1] * A[2][0] );
+        if( std::fabs( det ) < 1e-12 ){ return false; }
+
+        for( int c = 0; c < 3; c++ ){
+            double M[3][3];
+            for( int i = 0; i < 3; i++ ){
+                for( int j = 0; j < 3; j++ ){ M[i][j] = ( j == c ) ? b[i] : A[i][j]; }
+            }
+            x[c] = ( M[0][0] * ( M[1][1] * M[2][2] - M[1][2] * M[2][1] )
+                   - M[0][1] * ( M[1][0] * M[2][2] - M[1][2] * M[2][0] )
+                   + M[0][2] * ( M[1][0] * M[2][1] - M[1][1] * M[2][0] ) ) / det;
+        }
+        return true;
+    }
+}
+
+bool DistanceField::Sample( double x, double y, double & d, double & gx, double & gy ) const {
+    double fx = ( x - origin_x ) / resolution;
+    double fy = ( y - origin_y ) / resolution;
+
+    int ix = static_cast<int>( std::floor( fx ) );
+    int iy = static_cast<int>( std::floor( fy ) );
+    if( ix < 0 || iy < 0 || ix + 1 >= width || iy + 1 >= height ){ return false; }
+
+    double tx = fx - ix;
+    double ty = fy - iy;
+
+    const float * row0 = &cells[ iy * width + ix ];
+    const float * row1 = row0 + width;
+
+    double d00 = row0[0], d10 = row0[1];
+    double d01 = row1[0], d11 = row1[1];
+
+    d  = ( d00 * ( 1 - tx ) + d10 * tx ) * ( 1 - ty ) + ( d01 * ( 1 - tx ) + d11 * tx ) * ty;
+    gx = ( ( d10 - d00 ) * ( 1 - ty ) + ( d11 - d01 ) * ty ) / resolution;
+    gy = ( ( d01 - d00 ) * ( 1 - tx ) + ( d11 - d10 ) * tx ) / resolution;
+    return true;
+}
+
+void Localizer::SetMap( const PathPlanner::FieldMap & map ){
+
+    if( map.walls.empty() ){
+        LOG_WARN( "[Localizer] Map without walls, ignored" );
+        return;
+    }
+
+    double min_x =  std::numeric_limits<double>::infinity(), min_y = min_x;
+    double max_x = -std::numeric_limits<double>::infinity(), max_y = max_x;
+    for( const auto & w : map.walls ){
+        min_x = std::min( { min_x, w.x1, w.x2 } );
+        min_y = std::min( { min_y, w.y1, w.y2 } );
+        max_x = std::max( { max_x, w.x1, w.x2 } );
+        max_y = std::max( { max_y, w.y1, w.y2 } );
+    }
+
+    auto f = std::make_shared<DistanceField>();
+    f->resolution = resolution;
+    f->origin_x   = min_x - map_margin;
+    f->origin_y   = min_y - map_margin;
+    f->width      = static_cast<int>( std::ceil( ( max_x - min_x + 2 * map_margin ) / resolution ) ) + 1;
+    f->height     = static_cast<int>( std::ceil( ( max_y - min_y + 2 * map_margin ) / resolution ) ) + 1;
+    f->cells.assign( f->width * f->height, static_cast<float>( max_distance ) );
+
+    // Only cells within max_distance of a wall can hold a smaller value
+    int reach = static_cast<int>( std::ceil( max_distance / resolution ) );
+    for( const auto & w : map.walls ){
+        int x0 = std::max( static_cast<int>( ( std::min( w.x1, w.x2 ) - f->origin_x ) / resolution ) - reach, 0 );
+        int x1 = std::min( static_cast<int>( ( std::max( w.x1, w.x2 ) - f->origin_x ) / resolution ) + reach, f->width - 1 );
+        int y0 = std::max( static_cast<int>( ( std::min( w.y1, w.y2 ) - f->origin_y ) / resolution ) - reach, 0 );
+        int y1 = std::min( static_cast<int>( ( std::max( w.y1, w.y2 ) - f->origin_y ) / resolution ) + reach, f->height - 1 );
+
+        for( int iy = y0; iy <= y1; iy++ ){
+            for( int ix = x0; ix <= x1; ix++ ){
+                float & cell = f->cells[ iy * f->width + ix ];
+                double d = SegmentDistance( f->origin_x + ix * resolution, f->origin_y + iy * resolution, w );
+                cell = std::min( cell, static_cast<float>( d ) );
+            }
+        }
+    }
+
+    std::atomic_store( &field, std::shared_ptr<const DistanceField>( f ) );
+
+    std::lock_guard<std::mutex> lock( status_mutex );
+    current.has_map = true;
+    status.Store( current );
+
+    LOG_INFO( "[Localizer] Map \"%s\": %zu walls, %dx%d cells", map.name.c_str(), map.walls.size(), f->width, f->height );
+}
+
+void Localizer::Start(){
+    if( running ){ return; }
+
+    running = true;
+    pending_correction = move->GetPose().correction;
+    lidar->SetScanCallback( [this]( const LidarFrame & frame ){ OnScan( frame ); } );
+}
+
+void Localizer::Stop(){
+    if( !running ){ return; }
+
+    running = false;
+    lidar->SetScanCallback( nullptr );
+}
+
+bool Localizer::Match( const studica::Lidar::ScanData & scan, double & x, double & y, double & th,
+                       double & residual, double & inlier_ratio ) const {
+
+    std::shared_ptr<const DistanceField> f = std::atomic_load( &field );
+    if( !f ){ return false; }
+
+    // Scan points in the robot frame [m], built once per match
+    double px[360], py[360];
+    int count = 0;
+    for( int i = 0; i < 360; i += beam_step ){
+        double r = scan.distance[i] / 1000.0;
+        if( r <= min_range || r >= max_range ){ continue; }
+
+        double a = ( constant::LIDAR_FRONT_BEAM - i ) * M_PI / 180.0;
+        px[count] = r * std::cos( a ) + constant::LIDAR_OFFSET_X / 100.0;
+        py[count] = r * std::sin( a ) + constant::LIDAR_OFFSET_Y / 100.0;
+        count++;
+    }
+    if( count < min_points ){ return false; }
+
+    double tx = x / 100.0;
+    double ty = y / 100.0;
+    double tt = th * M_PI / 180.0;
+
+    int inliers = 0;
+    double sq = 0;
+
+    for( int it = 0; it < max_iterations; it++ ){
+        double c = std::cos( tt ), s = std::sin( tt );
+        double H[3][3] = {};
+        double g[3] = {};
+        inliers = 0;
+        sq = 0;
+
+        for( int k = 0; k < count; k++ ){
+            double wx = c * px[k] - s * py[k] + tx;
+            double wy = s * px[k] + c * py[k] + ty;
+
+            double d, gx, gy;
+            if( !f->Sample( wx, wy, d, gx, gy ) || d > outlier_dist ){ continue; }
+
+            // d(world point)/d(theta)
+            double J[3] = { gx, gy, gx * ( -s * px[k] - c * py[k] ) + gy * ( c * px[k] - s * py[k] ) };
+
+            for( int i = 0; i < 3; i++ ){
+                g[i] += J[i] * d;
+                for( int j = 0; j < 3; j++ ){ H[i][j] += J[i] * J[j]; }
+            }
+            inliers++;
+            sq += d * d;
+        }
+
+        if( inliers < min_points ){ return false; }
+
+        // Small damping keeps a single wall (unobservable along it) from diverging
+        for( int i = 0; i < 3; i++ ){ H[i][i] += 1e-3 * inliers; }
+
+        double step[3];
+        if( !Solve3( H, g, step ) ){ return false; }
+
+        tx -= step[0];
+        ty -= step[1];
+        tt -= step[2];
+
+        if( std::fabs( step[0] ) < 1e-4 && std::fabs( step[1] ) < 1e-4 && std::fabs( step[2] ) < 1e-4 ){ break; }
+    }
+
+    residual     = std::sqrt( sq / inliers );
+    inlier_ratio = static_cast<double>( inliers ) / count;
+
+    x  = tx * 100.0;
+    y  = ty * 100.0;
+    th = tt * 180.0 / M_PI;
+
+    return inlier_ratio >= min_inliers && residual <= max_residual;
+}
+
+void Localizer::OnScan( const LidarFrame & frame ){
+
+    // Every delta is relative to the pose it was computed on, wait until Movement applied the last one
+    PoseSample pose = move->GetPose();
+    if( pose.correction != pending_correction ){ return; }
+
+    int64_t start = timing::NowNs();
+
+    std::lock_guard<std::mutex> lock( status_mutex );
+
+    double x = pose.x, y = pose.y, th = pose.th;
+    bool ok = Match( frame.scan, x, y, th, current.residual, current.inlier_ratio );
+    current.matches++;
+    current.match_us = ( timing::NowNs() - start ) / 1e3;
+
+    double dx  = x - pose.x;
+    double dy  = y - pose.y;
+    double dth = WrapDegrees( th - pose.th );
+
+    if( ok && std::hypot( dx, dy ) <= max_jump_xy && std::fabs( dth ) <= max_jump_th ){
+        current.accepted++;
+        current.dx  = gain * dx;
+        current.dy  = gain * dy;
+        current.dth = gain * dth;
+        pending_correction = move->CorrectPose( current.dx, current.dy, current.dth );
+    }
+
+    status.Store( current );
+}
@@ -0,0 +1,168 @@
+/************************************
+ * Trajectory
+ * Time parameterized path through a list of waypoints.
+ *************************************/
+
+#include "Trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    struct Vec {
+        double x = 0;
+        double y = 0;
+    };
+
+    Vec operator+( Vec a, Vec b ){ return { a.x + b.x, a.y + b.y }; }
+    Vec operator-( Vec a, Vec b ){ return { a.x - b.x, a.y - b.y }; }
+    Vec operator*( double k, Vec a ){ return { k * a.x, k * a.y }; }
+
+    double Norm( Vec a ){ return std::hypot( a.x, a.y ); }
+
+    // Knot spacing of the centripetal parameterization, never zero for distinct points
+    double Knot( Vec a, Vec b ){ return std::max( std::sqrt( Norm( b - a ) ), 1e-6 ); }
+
+    // Catmull-Rom segment p1..p2 at u in [0, 1] (Barry-Goldman pyramid)
+    Vec CatmullRom( Vec p0, Vec p1, Vec p2, Vec p3, double u ){
+        double t0 = 0;
+        double t1 = t0 + Knot( p0, p1 );
+        double t2 = t1 + Knot( p1, p2 );
+        double t3 = t2 + Knot( p2, p3 );
+        double t  = t1 + u * ( t2 - t1 );
+
+        Vec a1 = ( ( t1 - t ) / ( t1 - t0 ) ) * p0 + ( ( t - t0 ) / ( t1 - t0 ) ) * p1;
+        Vec a2 = ( ( t2 - t ) / ( t2 - t1 ) ) * p1 + ( ( t - t1 ) / ( t2 - t1 ) ) * p2;
+        Vec a3 = ( ( t3 - t ) / ( t3 - t2 ) ) * p2 + ( ( t - t2 ) / ( t3 - t2 ) ) * p3;
+        Vec b1 = ( ( t2 - t ) / ( t2 - t0 ) ) * a1 + ( ( t - t0 ) / ( t2 - t0 ) ) * a2;
+        Vec b2 = ( ( t3 - t ) / ( t3 - t1 ) ) * a2 + ( ( t - t1 ) / ( t3 - t1 ) ) * a3;
+        return ( ( t2 - t ) / ( t2 - t1 ) ) * b1 + ( ( t - t1 ) / ( t2 - t1 ) ) * b2;
+    }
+
+    // Signed curvature of the circle through a, b, c
+    double Curvature( Vec a, Vec b, Vec c ){
+        Vec ab = b - a, bc = c - b, ac = c - a;
+        double den = Norm( ab ) * Norm( bc ) * Norm( ac );
+        if( den < 1e-12 ){ return 0; }
+        return 2 * ( ab.x * bc.y - ab.y * bc.x ) / den;
+    }
+
+    double WrapAngle( double a ){
+        while( a >  M_PI ){ a -= 2 * M_PI; }
+        while( a < -M_PI ){ a += 2 * M_PI; }
+        return a;
+    }
+}
+
+bool Trajectory::Generate( const std::vector<TrajectoryPoint> & points, const TrajectoryConstraints & c ){
+    states.clear();
+    if( c.max_velocity <= 0 || c.max_acceleration <= 0 ){ return false; }
+
+    // Repeated points would give zero length segments
+    std::vector<Vec> p;
+    std::vector<double> cap;
+    for( const TrajectoryPoint & pt : points ){
+        Vec v{ pt.x, pt.y };
+        if( !p.empty() && Norm( v - p.back() ) < 1e-3 ){ continue; }
+        p.push_back( v );
+        cap.push_back( pt.velocity > 0 ? std::min( pt.velocity, c.max_velocity ) : c.max_velocity );
+    }
+    if( p.size() < 2 ){ return false; }
+
+    const size_t n = p.size();
+    std::vector<Vec> pos;
+    std::vector<double> limit;
+
+    for( size_t i = 0; i + 1 < n; i++ ){
+        // Phantom end points mirror the first and last segments
+        Vec p0 = ( i > 0 )     ? p[i - 1] : 2.0 * p[0] - p[1];
+        Vec p3 = ( i + 2 < n ) ? p[i + 2] : 2.0 * p[n - 1] - p[n - 2];
+
+        int steps = std::max( 1, static_cast<int>( std::ceil( Norm( p[i + 1] - p[i] ) / sample_step ) ) );
+        bool last = ( i + 2 == n );
+        for( int j = 0; j < steps + ( last ? 1 : 0 ); j++ ){
+            double u = static_cast<double>( j ) / steps;
+            pos.push_back( CatmullRom( p0, p[i], p[i + 1], p3, u ) );
+            limit.push_back( cap[i] + u * ( cap[i + 1] - cap[i] ) );
+        }
+    }
+
+    const size_t m = pos.size();
+    states.resize( m );
+    for( size_t i = 0; i < m; i++ ){
+        TrajectoryState & st = states[i];
+        st.x = pos[i].x;
+        st.y = pos[i].y;
+        if( i > 0 ){ st.s = states[i - 1].s + Norm( pos[i] - pos[i - 1] ); }
+
+        Vec tangent = pos[ std::min( i + 1, m - 1 ) ] - pos[ i > 0 ? i - 1 : 0 ];
+        st.th = std::atan2( tangent.y, tangent.x );
+        if( i > 0 && i + 1 < m ){ st.k = Curvature( pos[i - 1], pos[i], pos[i + 1] ); }
+    }
+    if( m > 2 ){
+        states[0].k     = states[1].k;
+        states[m - 1].k = states[m - 2].k;
+    }
+
+    // Speed allowed by the curvature at every sample
+    for( size_t i = 0; i < m; i++ ){
+        double k = std::abs( states[i].k );
+        if( k > 1e-9 ){
+            limit[i] = std::min( limit[i], std::sqrt( c.max_centripetal / k ) );
+            limit[i] = std::min( limit[i], c.max_angular / k );
+        }
+    }
+
+    // Acceleration limit, forward then backward
+    states[0].v = std::min( std::max( c.start_velocity, 0.0 ), limit[0] );
+    for( size_t i = 1; i < m; i++ ){
+        double ds = states[i].s - states[i - 1].s;
+        states[i].v = std::min( limit[i], std::sqrt( states[i - 1].v * states[i - 1].v + 2 * c.max_acceleration * ds ) );
+    }
+    states[m - 1].v = std::min( states[m - 1].v, std::max( c.end_velocity, 0.0 ) );
+    for( size_t i = m - 1; i > 0; i-- ){
+        double ds = states[i].s - states[i - 1].s;
+        states[i - 1].v = std::min( states[i - 1].v, std::sqrt( states[i].v * states[i].v + 2 * c.max_acceleration * ds ) );
+    }
+
+    // Constant acceleration between samples
+    for( size_t i = 1; i < m; i++ ){
+        double ds = states[i].s - states[i - 1].s;
+        double v0 = states[i - 1].v, v1 = states[i].v;
+        // Both ends at rest only happens on very short paths: speed up, then brake
+        double dt = ( v0 + v1 > 1e-9 ) ? 2 * ds / ( v0 + v1 ) : 2 * std::sqrt( ds / c.max_acceleration );
+
+        states[i].t = states[i - 1].t + dt;
+        states[i - 1].a = ( ds > 1e-9 ) ? ( v1 * v1 - v0 * v0 ) / ( 2 * ds ) : 0;
+    }
+
+    if( Length() < 1e-3 ){
+        states.clear();
+        return false;
+    }
+    return true;
+}
+
+TrajectoryState Trajectory::Sample( double t ) const {
+    if( t <= 0 ){ return states.front(); }
+    if( t >= Duration() ){ return states.back(); }
+
+    auto it = std::upper_bound( states.begin(), states.end(), t,
+                                []( double time, const TrajectoryState & st ){ return time < st.t; } );
+    const TrajectoryState & b = *it;
+    const TrajectoryState & a = *( it - 1 );
+
+    double dt = b.t - a.t;
+    double u  = ( dt > 1e-9 ) ? ( t - a.t ) / dt : 0;
+
+    TrajectoryState st;
+    st.t  = t;
+    st.s  = a.s  + u * ( b.s  - a.s );
+    st.x  = a.x  + u * ( b.x  - a.x );
+    st.y  = a.y  + u * ( b.y  - a.y );
+    st.th = WrapAngle( a.th + u * WrapAngle( b.th - a.th ) );
+    st.k  = a.k  + u * ( b.k  - a.k );
+    st.v  = a.v  + u * ( b.v  - a.v );
+    st.a  = a.a;
+    return st;
+}
@@ -17,8 +17,8 @@
 #include "Functions.h"
 #include "Hardware.h"
 #include "Constants.h"
-
-#include "frc/Timer.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
 
 #include <frc/controller/PIDController.h>
 
@@ -70,6 +70,11 @@ class Oms
 
         frc2::PIDController pid_e{kP, kI, kD};
 
+        struct Dashboard {
+            telemetry::String process = telemetry::AddString( "Process" );
+            telemetry::Number height  = telemetry::AddNumber( "height" );
+        } dash;
+
 
 
 
@@ -9,16 +9,22 @@
 *************************************/
 
 #include "Oms.h"
+#include "Log.h"
+#include "LoopMetrics.h"
+
+namespace {
+    metrics::Loop oms_loop( "oms_driver" );
+}
 
 void Oms::oms_driver( double desired_height, double speed ){
 
-    frc::SmartDashboard::PutString("Process",  "Oms Driver" );
+    telemetry::Set( dash.process, "Oms Driver" );
 
     float desired_speed = 0;
 
     const float enc_prop = 1.0;
 
-    frc::Timer time;
+    timing::Timer time;
     time.Start();
 
     double current_time  = time.Get();
@@ -31,7 +37,9 @@ void Oms::oms_driver( double desired_height, double speed ){
     pid_e.SetIntegratorRange(-3.0, 3.0);
 
     if ( desired_height <= high_height && desired_height >= low_height || speed != 0 ){
-        
+
+        Rate rate( 40, &oms_loop );
+
         do{
             current_time = time.Get();
             double delta_time = current_time - previous_time;                  // [s]
@@ -77,17 +85,17 @@ void Oms::oms_driver( double desired_height, double speed ){
                 hardware->SetElevator( std::clamp(pid_e.Calculate(elevatorVelocity / 60.0, desired_speed / 60.0),  -0.75, 0.75) );
             }
             
-            printf( "height: %f, desired_speed: %f\n", height, desired_speed ); 
+            LOG_INFO_EVERY( 200, "height: %f, desired_speed: %f", height, desired_speed );
 
-            frc::SmartDashboard::PutNumber("height",  height );
+            telemetry::Set( dash.height, height );
 
 
-            delay( 40 );
+            rate.Sleep();
 
         }while( desired_speed != 0 && speed == 0 );
 
     }else{
-        printf( "Desired Position out of the range %f to %f", low_height, high_height );
+        LOG_WARN( "Desired Position out of the range %f to %f", low_height, high_height );
     }
 
     if( speed == 0 ){
@@ -100,7 +108,7 @@ void Oms::oms_driver( double desired_height, double speed ){
 
 void Oms::reset( int direction ){
 
-    frc::SmartDashboard::PutString("Process",  "Oms Reset" );
+    telemetry::Set( dash.process, "Oms Reset" );
     
     if( direction == 1 ){
         while( hardware->GetLimitHigh() ){ 
@@ -119,8 +127,8 @@ void Oms::reset( int direction ){
 
     hardware->SetElevator( 0 );
 
-    printf("new height is %f", height);
-    frc::SmartDashboard::PutNumber("height",  height );
+    LOG_INFO( "new height is %f", height );
+    telemetry::Set( dash.height, height );
 
 
     delay(150);
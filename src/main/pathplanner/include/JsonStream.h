@@ -0,0 +1,94 @@
+/************************************
+ * JsonStream
+ * Newline framing and single pass JSON decoding for PathPlannerComm.
+ *
+ * MessageBuffer -> receive buffer of one client. recv() writes straight
+ *                  into its free space, new bytes are scanned once for
+ *                  the newline and complete messages are read in place.
+ *                  Binary frames (WireProtocol.h) are framed by their size.
+ * JsonReader    -> pull tokenizer over one message. Strings are views
+ *                  into the message unless they hold escapes.
+ * DecodeMessage -> walks the reader once into a reused IncomingMessage,
+ *                  skipping unknown values of any nesting depth.
+ *************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "WireProtocol.h"
+
+namespace PathPlanner {
+
+    struct IncomingMessage;
+
+    class MessageBuffer {
+    public:
+        static constexpr size_t initial_size = 64 * 1024;
+        static constexpr size_t max_size     = 4 * 1024 * 1024;    // Longest message accepted
+        static constexpr size_t min_read     = 4096;               // Free space offered to recv()
+
+        MessageBuffer() : m_data(initial_size) {}
+
+        // Free space to receive into, compacting or growing first. nullptr when a message
+        // does not fit in max_size.
+        char* WritePtr(size_t& space);
+        void Commit(size_t bytes);
+
+        // Next complete JSON message without its newline, or binary frame with its header.
+        // Valid until the next WritePtr().
+        bool Next(const char*& begin, const char*& end);
+
+        size_t Pending() const { return m_write - m_read; }
+        void Clear() { m_read = m_write = m_scan = 0; }
+
+    private:
+        std::vector<char> m_data;
+        size_t m_read = 0;      // Start of the first incomplete message
+        size_t m_write = 0;     // End of the received bytes
+        size_t m_scan = 0;      // Bytes before this hold no newline
+    };
+
+    enum class JsonToken {
+        ObjectStart, ObjectEnd, ArrayStart, ArrayEnd,
+        Key, String, Number, True, False, Null,
+        End, Error
+    };
+
+    class JsonReader {
+    public:
+        JsonReader(const char* begin, const char* end) : m_pos(begin), m_end(end) {}
+
+        JsonToken Next();
+
+        // Key or String token, unescaped
+        std::string_view Text() const { return m_text; }
+        // Number token
+        double Number() const { return m_number; }
+
+        // Skips the value whose first token is first, false on malformed input
+        bool Skip(JsonToken first);
+
+        // True, and consumed, when the next token closes an array
+        bool ConsumeArrayEnd();
+
+    private:
+        void SkipSeparators();
+        bool ReadString();
+        bool ReadNumber();
+        bool ReadLiteral(const char* literal, size_t length);
+
+        const char* m_pos;
+        const char* m_end;
+        std::string_view m_text;
+        std::string m_scratch;      // Unescaped strings only
+        double m_number = 0;
+    };
+
+    // Fills msg from one JSON object, false when it is malformed
+    bool DecodeMessage(const char* begin, const char* end, IncomingMessage& msg);
+
+} // namespace PathPlanner
@@ -0,0 +1,50 @@
+/************************************
+ * PathCache
+ * Received paths and the field map kept on the robot across reboots,
+ * so autonomous routines can run before the GUI connects.
+ *
+ * File, little endian:
+ *   char magic[4] "PPCF", u32 format, u32 body size, u32 crc32 of the body
+ *   body:
+ *     u32 path count, per path:
+ *       u16 name size, name, u32 version, u32 count, count x f32 (x, y, heading, velocity)
+ *     u8 has map, u16 name size, name, u32 wall count, count x f32 (x1, y1, x2, y2)
+ *
+ * Save writes a temporary file next to the cache, syncs it and renames it
+ * over the old one, so a brown-out leaves either the old or the new file.
+ * Load maps the file and rejects it on any size or checksum mismatch.
+ *************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PathStore.h"
+
+namespace PathPlanner {
+
+    struct FieldMap;
+
+    namespace cache {
+
+        constexpr char     magic[4]     = {'P', 'P', 'C', 'F'};
+        constexpr uint32_t format       = 1;
+        constexpr size_t   header_size  = 16;
+
+        // Next to the deployed files, which a deploy does not remove
+        constexpr const char* default_file = "/home/lvuser/deploy/pathplanner.cache";
+
+        // map may be nullptr when no map was received
+        bool Save(const std::string& file, const std::vector<PathPtr>& paths, const FieldMap* map);
+
+        // False when the file is missing or damaged, paths and map are left empty then
+        bool Load(const std::string& file, std::vector<Path>& paths, FieldMap& map, bool& hasMap);
+
+        uint32_t Crc32(const char* data, size_t size);
+
+    } // namespace cache
+
+} // namespace PathPlanner
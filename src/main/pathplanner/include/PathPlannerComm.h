@@ -3,6 +3,27 @@
  * Handles TCP communication with RobotPathPlanner GUI
  * Author: Integration Module
  * Version: 1.0.0
+ *
+ * One reactor thread serves every client on epoll. Other threads never
+ * touch a socket: they queue messages and wake the reactor through an
+ * eventfd, and pose updates are pushed when they change, not on a timer.
+ * The pose and odometry are published through seqlocks, so the control
+ * loop never waits on the reactor, and no lock is held around socket I/O.
+ * Each client has its own non-blocking send queue. Poses are dropped for
+ * a client that falls behind, and a client that stops reading is closed.
+ * Clients that ask for it with hello get binary frames (WireProtocol.h).
+ *
+ * Published values are topics. Every publish bumps the topic version and
+ * the reactor sends each client the latest value it has not seen yet, so
+ * updates between two sends are coalesced. A client starts with pose and
+ * status on every change; a subscribe message picks topics and rates:
+ *   {"type":"subscribe","topics":{"pose":20,"status":5,"lidarScan":0}}
+ * Rates are in Hz, 0 unsubscribes. It is answered with subscribeAck
+ * listing the active topics (0 for every change), so the GUI can stop
+ * polling getState.
+ *
+ * Received paths and the map are saved to a cache file (PathCache.h) by a
+ * background thread and loaded back by Start(), before any GUI connects.
  *************************************/
 
 #ifndef PATHPLANNER_COMM_H
@@ -15,6 +36,15 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <array>
+#include <cstdint>
+
+#include "JsonStream.h"
+#include "SeqLock.h"
+#include "TripleBuffer.h"
+#include "PathStore.h"
+#include "PathCache.h"
 
 namespace PathPlanner {
 
@@ -33,6 +63,7 @@ namespace PathPlanner {
     struct Path {
         std::string name;
         std::vector<Waypoint> waypoints;
+        uint64_t version = 0;       // Set by PathStore, counts the uploads of this name
 
         Path(const std::string& name_ = "") : name(name_) {}
     };
@@ -47,6 +78,86 @@ namespace PathPlanner {
             : x(x_), y(y_), heading(heading_) {}
     };
 
+    // Wall segment of the field map
+    struct WallSegment {
+        double x1, y1;      // meters
+        double x2, y2;      // meters
+
+        WallSegment(double x1_ = 0, double y1_ = 0, double x2_ = 0, double y2_ = 0)
+            : x1(x1_), y1(y1_), x2(x2_), y2(y2_) {}
+    };
+
+    // Field map (MapData on the GUI side)
+    struct FieldMap {
+        std::string name;
+        std::vector<WallSegment> walls;
+    };
+
+    // Named field position marked on the GUI map
+    struct ReferencePoint {
+        std::string name;
+        double x = 0;               // meters
+        double y = 0;               // meters
+        double heading = 0;         // radians, only when hasHeading
+        bool hasHeading = false;
+    };
+
+    // Odometry and lidar localization health, published as the odometry topic
+    struct OdometryDiagnostics {
+        double x = 0;               // meters
+        double y = 0;               // meters
+        double heading = 0;         // radians
+        double age = 0;             // seconds since the odometry sample
+        uint32_t corrections = 0;   // lidar corrections applied to the odometry
+        uint32_t matches = 0;       // scan matches attempted
+        uint32_t accepted = 0;      // scan matches within the limits
+        double residual = 0;        // meters, rms of the last match
+        double inlierRatio = 0;
+    };
+
+    // One lidar revolution as published, a fixed size so it can be swapped without allocating
+    struct LidarScan {
+        static constexpr size_t max_ranges = 360;
+        size_t count = 0;
+        float ranges[max_ranges];
+    };
+
+    enum class Topic { Pose, Status, LidarScan, Odometry };
+    constexpr size_t topic_count = 4;
+
+    // Name used by subscribe and subscribeAck, nullptr for an invalid topic
+    const char* TopicName(Topic topic);
+
+    struct TopicRate {
+        Topic topic;
+        double rate;                // Hz, 0 unsubscribes
+    };
+
+    enum class MessageType { Unknown, SendPath, GetState, SendMapData, SendReferencePoints, Hello, Subscribe };
+
+    // Decoded GUI message, reused so its buffers keep their capacity
+    struct IncomingMessage {
+        MessageType type = MessageType::Unknown;
+        Path path;
+        FieldMap map;
+        std::vector<ReferencePoint> referencePoints;
+        int binaryVersion = 0;      // hello
+        bool deltaPose = false;
+        std::vector<TopicRate> topics;      // subscribe
+
+        void Clear() {
+            type = MessageType::Unknown;
+            binaryVersion = 0;
+            deltaPose = false;
+            topics.clear();
+            path.name.clear();
+            path.waypoints.clear();
+            map.name.clear();
+            map.walls.clear();
+            referencePoints.clear();
+        }
+    };
+
     // Communication class
     class PathPlannerComm {
     public:
@@ -57,73 +168,193 @@ namespace PathPlanner {
         void Start();
         void Stop();
 
+        // Cache of received paths and map, call before Start(). Empty disables it.
+        void SetCacheFile(const std::string& file);
+
         // Check if connected to GUI
         bool IsConnected() const;
+        int GetClientCount() const;
 
-        // Update robot pose (call this periodically, e.g., in RobotPeriodic)
+        // Update robot pose (call this periodically, e.g., in RobotPeriodic).
+        // Lock free, from one thread at a time.
         void UpdateRobotPose(double x, double y, double heading);
         void UpdateRobotPose(const RobotPose& pose);
 
         // Set callback for when a new path is received
         void SetPathReceivedCallback(std::function<void(const Path&)> callback);
 
-        // Get the latest received path
-        bool GetLatestPath(Path& path);
+        // Get the latest received path, nullptr when none arrived since the last call
+        PathPtr GetLatestPath();
+        bool GetLatestPath(Path& path);     // Copies the waypoints
 
-        // Get all stored paths
-        std::vector<Path> GetAllPaths();
+        // Get all stored paths, shared with the store
+        std::vector<PathPtr> GetAllPaths();
 
-        // Get a specific path by name
+        // Get a specific path by name, nullptr when there is none
+        PathPtr GetPathByName(const std::string& name);
         bool GetPathByName(const std::string& name, Path& path);
 
-        // Get a specific path by index
+        // Get a specific path by index, in order of first upload
+        PathPtr GetPathByIndex(int index);
         bool GetPathByIndex(int index, Path& path);
 
+        // Uploads of the named path so far, 0 when it is not stored
+        uint64_t GetPathVersion(const std::string& name) const;
+
         // Get number of stored paths
         int GetPathCount() const;
 
         // Clear all stored paths
         void ClearPaths();
 
-        // Send status message to GUI
+        // Set callback for when a new field map is received
+        void SetMapReceivedCallback(std::function<void(const FieldMap&)> callback);
+
+        // Get the latest received field map
+        bool GetMap(FieldMap& map);
+
+        // Set callback for when reference points are received
+        void SetReferencePointsReceivedCallback(std::function<void(const std::vector<ReferencePoint>&)> callback);
+
+        // Get the latest received reference points
+        std::vector<ReferencePoint> GetReferencePoints();
+
+        // Send status message to GUI, only sent when it differs from the last one
         void SendStatus(const std::string& status, bool isMoving = false);
 
+        // Latest lidar scan, one range per degree in meters, 0 without a return.
+        // Lock free like UpdateRobotPose, from one thread at a time, ranges past
+        // LidarScan::max_ranges are dropped
+        void PublishLidarScan(const float* ranges, size_t count);
+
+        // Lock free like UpdateRobotPose, from one thread at a time
+        void PublishOdometry(const OdometryDiagnostics& odometry);
+
+        // True while some client receives the topic, to skip preparing unused data
+        bool HasSubscribers(Topic topic) const;
+
         // Notify GUI of path execution events
         void NotifyPathExecutionStarted();
         void NotifyPathExecutionFinished(bool success);
 
+        // JSON encoders of the text protocol, no state
+        static std::string CreatePoseJson(const RobotPose& pose);
+        static std::string CreateStatusJson(const std::string& status, bool isMoving);
+        static std::string CreateLidarScanJson(const float* ranges, size_t count);
+        static std::string CreateOdometryJson(const OdometryDiagnostics& odometry);
+
+        static constexpr int    max_clients       = 8;
+        static constexpr size_t queue_soft_limit  = 64 * 1024;     // [bytes] poses are dropped above
+        static constexpr size_t queue_hard_limit  = 1024 * 1024;   // [bytes] the client is closed above
+        static constexpr double max_topic_rate    = 100;           // [Hz] faster subscriptions are clamped
+        static constexpr int    cache_delay_ms    = 500;           // Uploads within this are saved together
+
     private:
+        struct Subscription {
+            bool active = false;
+            int64_t period_ns = 0;      // 0 sends every change
+            int64_t lastSent_ns = 0;
+            uint64_t version = 0;       // Topic version sent last, 0 before the first
+        };
+
+        struct Client {
+            int fd = -1;
+            std::string address;
+            MessageBuffer inbox;
+            std::string outbox;         // Pending bytes, sent from outboxSent
+            size_t outboxSent = 0;
+            bool writeArmed = false;    // EPOLLOUT registered
+            bool closed = false;
+            bool binary = false;        // Frames negotiated with hello
+            wire::PoseEncoder poseEncoder;
+            std::array<Subscription, topic_count> topics;
+        };
+
+        // Broadcast in both encodings, each client gets the one it negotiated
+        struct OutgoingMessage {
+            std::string json;           // With its newline
+            std::string frame;
+        };
+
         int m_port;
         int m_serverSocket;
-        int m_clientSocket;
+        int m_epollFd;
+        int m_wakeFd;
         std::atomic<bool> m_running;
         std::atomic<bool> m_connected;
+        std::atomic<int> m_clientCount;
 
         std::thread m_serverThread;
-        std::thread m_sendThread;
 
-        RobotPose m_currentPose;
-        mutable std::mutex m_poseMutex;
+        std::vector<std::unique_ptr<Client>> m_clients;     // Reactor thread only
+
+        // Messages for every client, queued by other threads
+        std::vector<OutgoingMessage> m_outgoing;
+        std::mutex m_outgoingMutex;
 
-        Path m_latestPath;
-        bool m_hasNewPath;
-        std::vector<Path> m_allPaths;  // Store all received paths
-        mutable std::mutex m_pathMutex;
+        // Topic values. A version of 0 means nothing was published yet.
+        std::array<std::atomic<uint64_t>, topic_count> m_versions;
+        std::array<std::atomic<int>, topic_count> m_subscribers;     // Written by the reactor
+
+        SeqLock<RobotPose> m_pose;
+        SeqLock<OdometryDiagnostics> m_odometry;
+
+        std::string m_status;
+        bool m_statusMoving;
+        mutable std::mutex m_topicMutex;    // Status only, held to copy it
+
+        TripleBuffer<LidarScan> m_lidarScan;    // Read by the reactor only
+
+        PathStore m_paths;
+
+        std::string m_cacheFile;
+        std::thread m_cacheThread;
+        std::mutex m_cacheMutex;
+        std::condition_variable m_cacheCv;
+        bool m_cacheDirty;
 
         std::function<void(const Path&)> m_pathCallback;
 
-        // Thread functions
+        FieldMap m_map;
+        bool m_hasMap;
+        mutable std::mutex m_mapMutex;
+        std::function<void(const FieldMap&)> m_mapCallback;
+
+        std::vector<ReferencePoint> m_referencePoints;
+        mutable std::mutex m_referenceMutex;
+        std::function<void(const std::vector<ReferencePoint>&)> m_referenceCallback;
+
+        IncomingMessage m_incoming;     // Reactor thread only
+
+        // Cache
+        void LoadCache();
+        void SaveCacheLater();
+        void CacheThread();
+
+        // Reactor
         void ServerThread();
-        void SendThread();
+        bool OpenServer();
+        void AcceptClients();
+        bool ReadClient(Client& client);
+        bool FlushClient(Client& client);
+        void CloseClient(Client& client);
+        void RemoveClosedClients();
+        // Returns when the next rate limited topic is due, INT64_MAX when none is
+        int64_t DispatchOutgoing();
+        void Wake();
+        void Publish(Topic topic);
+        void Subscribe(Client& client, const std::vector<TopicRate>& topics);
+        void CountSubscribers();
 
         // Message handling
-        void HandleMessage(const std::string& message);
-        void SendMessage(const std::string& message);
-
-        // JSON parsing helpers
-        Path ParsePathFromJson(const std::string& json);
-        std::string CreatePoseJson(const RobotPose& pose);
-        std::string CreateStatusJson(const std::string& status, bool isMoving);
+        void HandleMessage(Client& client, const IncomingMessage& message);
+        // Any thread, to every client. Frame clients get the JSON wrapped when frame is empty.
+        void SendMessage(const std::string& json, std::string frame = std::string());
+        // Reactor thread only
+        void Enqueue(Client& client, const std::string& bytes, bool droppable);
+        void EnqueuePose(Client& client, const RobotPose& pose);
+        void EnqueueStatus(Client& client, const std::string& status, bool isMoving);
+        void EnqueueTopic(Client& client, Topic topic);
     };
 
 } // namespace PathPlanner
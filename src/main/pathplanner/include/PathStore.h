@@ -0,0 +1,55 @@
+/************************************
+ * PathStore
+ * Paths received from the GUI, indexed by name.
+ *
+ * Every stored path is an immutable snapshot behind a shared_ptr. Readers
+ * get the pointer, never a copy of the waypoints, and keep using it while
+ * the GUI uploads a new version: an update builds the new snapshot first
+ * and only swaps the pointer under the lock.
+ *************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PathPlanner {
+
+    struct Path;
+    using PathPtr = std::shared_ptr<const Path>;
+
+    class PathStore {
+    public:
+        // Stores a snapshot of path under its name, replacing an older one in place.
+        // Its version is 1 for a new name and counts up with every update.
+        PathPtr Put(const Path& path);
+
+        // Stores a path read back from the cache, keeping its version. It is not the latest path.
+        void Restore(Path path);
+
+        // nullptr when there is no such path
+        PathPtr Find(const std::string& name) const;
+        PathPtr At(int index) const;            // In order of first upload
+
+        // Path stored last, once. nullptr when nothing arrived since the last call.
+        PathPtr TakeLatest();
+
+        // Version of the stored path, 0 when there is none
+        uint64_t Version(const std::string& name) const;
+
+        std::vector<PathPtr> All() const;      // Pointer copies only
+        int Count() const;
+        void Clear();
+
+    private:
+        std::vector<std::shared_ptr<Path>> m_paths;
+        std::unordered_map<std::string, size_t> m_index;    // Name -> position in m_paths
+        std::shared_ptr<Path> m_latest;
+        mutable std::mutex m_mutex;
+    };
+
+} // namespace PathPlanner
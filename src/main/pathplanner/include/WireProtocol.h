@@ -0,0 +1,92 @@
+/************************************
+ * WireProtocol
+ * Binary framing between PathPlannerComm and the GUI RobotComm.
+ *
+ * A connection starts in newline delimited JSON. The GUI asks for frames with
+ *   {"type":"hello","binary":1,"deltaPose":true}
+ * and the robot answers {"type":"helloAck","binary":1,"deltaPose":true}
+ * before it sends any frame. Frames and JSON lines can be mixed in both
+ * directions afterwards: a frame starts with frame_magic, which never
+ * starts a JSON line.
+ *
+ * Frame, little endian:
+ *   u8 magic, u8 version, u8 type, u8 flags, u32 payload size, payload
+ *
+ * Payloads:
+ *   Pose       f32 x, f32 y [m], f32 heading [rad]
+ *   PoseDelta  i16 dx, i16 dy [0.1 mm], i16 dheading [0.1 mrad], added in
+ *              double precision to the pose the client decoded last
+ *   Status     u8 moving, 3 reserved bytes, char status[28] NUL padded
+ *   Execution  u8 event (0 started, 1 finished), u8 success
+ *   Path       u16 name size, name, u32 count, count x f32 (x, y, heading, velocity)
+ *   GetState   empty
+ *   Json       one JSON message without its newline
+ *   LidarScan  u16 count, count x u16 range [mm], beam i at i degrees, 0 without a return
+ *************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PathPlanner {
+
+    struct IncomingMessage;
+    struct RobotPose;
+    struct Path;
+
+    namespace wire {
+
+        constexpr uint8_t  frame_magic  = 0xB1;
+        constexpr uint8_t  version      = 1;
+        constexpr size_t   header_size  = 8;
+        constexpr size_t   status_size  = 28;
+
+        enum FrameType : uint8_t {
+            Pose      = 1,
+            PoseDelta = 2,
+            Status    = 3,
+            Execution = 4,
+            Path      = 5,
+            GetState  = 6,
+            Json      = 7,
+            LidarScan = 8
+        };
+
+        inline bool IsFrame(const char* data) { return static_cast<uint8_t>(data[0]) == frame_magic; }
+
+        // Header plus payload, needs header_size bytes
+        size_t FrameSize(const char* header);
+
+        void AppendPose(std::string& out, const RobotPose& pose);
+        void AppendStatus(std::string& out, const std::string& status, bool moving);
+        void AppendExecution(std::string& out, bool finished, bool success);
+        void AppendPath(std::string& out, const PathPlanner::Path& path);
+        void AppendGetState(std::string& out);
+        void AppendJson(std::string& out, const std::string& json);
+        void AppendLidarScan(std::string& out, const float* ranges, size_t count);
+
+        // Fills msg from one complete frame, false when malformed or from another version
+        bool DecodeFrame(const char* begin, const char* end, IncomingMessage& msg);
+
+        // Full poses or deltas against what the client decoded, one per client
+        class PoseEncoder {
+        public:
+            static constexpr int keyframe_interval = 50;    // Full pose at least every n poses
+
+            void Reset(bool deltas) { m_deltas = deltas; m_valid = false; }
+            void Append(std::string& out, const RobotPose& pose);
+
+        private:
+            bool m_deltas = false;
+            bool m_valid = false;
+            int m_sinceKeyframe = 0;
+            double m_x = 0;         // Pose held by the client
+            double m_y = 0;
+            double m_heading = 0;
+        };
+
+    } // namespace wire
+
+} // namespace PathPlanner
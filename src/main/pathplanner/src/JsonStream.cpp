@@ -0,0 +1,402 @@
+/************************************
+ * JsonStream
+ * Newline framing and single pass JSON decoding for PathPlannerComm.
+ *************************************/
+
+#include "JsonStream.h"
+#include "PathPlannerComm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace PathPlanner {
+
+    // ---------------- MessageBuffer ----------------
+
+    char* MessageBuffer::WritePtr(size_t& space) {
+        if (m_read == m_write) Clear();
+
+        // Move the incomplete message to the front, each byte moves at most once per message
+        if (m_data.size() - m_write < min_read && m_read > 0) {
+            std::memmove(m_data.data(), m_data.data() + m_read, m_write - m_read);
+            m_write -= m_read;
+            m_scan -= m_read;
+            m_read = 0;
+        }
+
+        if (m_data.size() - m_write < min_read) {
+            if (m_data.size() >= max_size) return nullptr;
+            m_data.resize(std::min(m_data.size() * 2, max_size));
+        }
+
+        space = m_data.size() - m_write;
+        return m_data.data() + m_write;
+    }
+
+    void MessageBuffer::Commit(size_t bytes) {
+        m_write += bytes;
+    }
+
+    bool MessageBuffer::Next(const char*& begin, const char*& end) {
+        const char* base = m_data.data();
+
+        if (m_read < m_write && wire::IsFrame(base + m_read)) {
+            if (m_write - m_read < wire::header_size) return false;
+
+            size_t size = wire::FrameSize(base + m_read);
+            if (m_write - m_read < size) return false;
+
+            begin = base + m_read;
+            end = begin + size;
+            m_read = m_scan = m_read + size;
+            return true;
+        }
+
+        const void* newline = std::memchr(base + m_scan, '\n', m_write - m_scan);
+        if (!newline) {
+            m_scan = m_write;
+            return false;
+        }
+
+        size_t pos = static_cast<const char*>(newline) - base;
+        begin = base + m_read;
+        end = base + pos;
+        if (end > begin && end[-1] == '\r') end--;
+
+        m_read = m_scan = pos + 1;
+        return true;
+    }
+
+    // ---------------- JsonReader ----------------
+
+    void JsonReader::SkipSeparators() {
+        // Separators carry no information for a reader that knows what it expects
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n' || *m_pos == ',')) m_pos++;
+    }
+
+    bool JsonReader::ConsumeArrayEnd() {
+        SkipSeparators();
+        if (m_pos < m_end && *m_pos == ']') {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    JsonToken JsonReader::Next() {
+        SkipSeparators();
+        if (m_pos >= m_end) return JsonToken::End;
+
+        switch (*m_pos) {
+            case '{': m_pos++; return JsonToken::ObjectStart;
+            case '}': m_pos++; return JsonToken::ObjectEnd;
+            case '[': m_pos++; return JsonToken::ArrayStart;
+            case ']': m_pos++; return JsonToken::ArrayEnd;
+            case '"': {
+                if (!ReadString()) return JsonToken::Error;
+
+                const char* p = m_pos;
+                while (p < m_end && (*p == ' ' || *p == '\t')) p++;
+                if (p < m_end && *p == ':') {
+                    m_pos = p + 1;
+                    return JsonToken::Key;
+                }
+                return JsonToken::String;
+            }
+            case 't': return ReadLiteral("true", 4)  ? JsonToken::True  : JsonToken::Error;
+            case 'f': return ReadLiteral("false", 5) ? JsonToken::False : JsonToken::Error;
+            case 'n': return ReadLiteral("null", 4)  ? JsonToken::Null  : JsonToken::Error;
+            default:
+                return ReadNumber() ? JsonToken::Number : JsonToken::Error;
+        }
+    }
+
+    bool JsonReader::Skip(JsonToken first) {
+        if (first != JsonToken::ObjectStart && first != JsonToken::ArrayStart) {
+            return first != JsonToken::End && first != JsonToken::Error &&
+                   first != JsonToken::ObjectEnd && first != JsonToken::ArrayEnd;
+        }
+
+        int depth = 1;
+        while (depth > 0) {
+            switch (Next()) {
+                case JsonToken::ObjectStart: case JsonToken::ArrayStart: depth++; break;
+                case JsonToken::ObjectEnd:   case JsonToken::ArrayEnd:   depth--; break;
+                case JsonToken::End: case JsonToken::Error: return false;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    bool JsonReader::ReadString() {
+        const char* start = ++m_pos;
+
+        // Fast path: no escapes, the text is a view into the message
+        const char* p = start;
+        while (p < m_end && *p != '"' && *p != '\\') p++;
+        if (p >= m_end) return false;
+        if (*p == '"') {
+            m_text = std::string_view(start, p - start);
+            m_pos = p + 1;
+            return true;
+        }
+
+        m_scratch.assign(start, p);
+        while (p < m_end && *p != '"') {
+            if (*p != '\\') {
+                m_scratch += *p++;
+                continue;
+            }
+            if (++p >= m_end) return false;
+
+            switch (*p) {
+                case 'b': m_scratch += '\b'; break;
+                case 'f': m_scratch += '\f'; break;
+                case 'n': m_scratch += '\n'; break;
+                case 'r': m_scratch += '\r'; break;
+                case 't': m_scratch += '\t'; break;
+                case 'u': {
+                    if (m_end - p < 5) return false;
+                    char hex[5] = { p[1], p[2], p[3], p[4], 0 };
+                    unsigned code = static_cast<unsigned>(std::strtoul(hex, nullptr, 16));
+                    // UTF-8, surrogate pairs are kept as two code points
+                    if (code < 0x80) {
+                        m_scratch += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        m_scratch += static_cast<char>(0xC0 | (code >> 6));
+                        m_scratch += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        m_scratch += static_cast<char>(0xE0 | (code >> 12));
+                        m_scratch += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        m_scratch += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    p += 4;
+                    break;
+                }
+                default: m_scratch += *p; break;     // '"', '\\' and '/'
+            }
+            p++;
+        }
+        if (p >= m_end) return false;
+
+        m_text = m_scratch;
+        m_pos = p + 1;
+        return true;
+    }
+
+    bool JsonReader::ReadNumber() {
+        // Copied out so strtod never reads past the message
+        char digits[64];
+        size_t n = 0;
+        while (m_pos < m_end && n < sizeof(digits) - 1 &&
+               ((*m_pos >= '0' && *m_pos <= '9') || *m_pos == '-' || *m_pos == '+' ||
+                *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E')) {
+            digits[n++] = *m_pos++;
+        }
+        digits[n] = 0;
+        if (n == 0) return false;
+
+        char* parsed;
+        m_number = std::strtod(digits, &parsed);
+        return parsed == digits + n;
+    }
+
+    bool JsonReader::ReadLiteral(const char* literal, size_t length) {
+        if (static_cast<size_t>(m_end - m_pos) < length || std::memcmp(m_pos, literal, length) != 0) return false;
+        m_pos += length;
+        return true;
+    }
+
+    // ---------------- Decoder ----------------
+
+    namespace {
+
+        bool ReadNumber(JsonReader& r, double& value) {
+            JsonToken t = r.Next();
+            if (t == JsonToken::Number) { value = r.Number(); return true; }
+            return r.Skip(t);
+        }
+
+        bool ReadString(JsonReader& r, std::string& value) {
+            JsonToken t = r.Next();
+            if (t == JsonToken::String) { value.assign(r.Text().data(), r.Text().size()); return true; }
+            return r.Skip(t);
+        }
+
+        bool ReadBool(JsonReader& r, bool& value) {
+            JsonToken t = r.Next();
+            if (t == JsonToken::True || t == JsonToken::False) { value = (t == JsonToken::True); return true; }
+            return r.Skip(t);
+        }
+
+        // Calls field(key) for every key of the next object, field reads or skips the value
+        template <typename F>
+        bool ReadObject(JsonReader& r, F field) {
+            JsonToken t = r.Next();
+            if (t != JsonToken::ObjectStart) return r.Skip(t);
+
+            while (true) {
+                t = r.Next();
+                if (t == JsonToken::ObjectEnd) return true;
+                if (t != JsonToken::Key) return false;
+                if (!field(r.Text())) return false;
+            }
+        }
+
+        // Calls item() for every element of the next array, item reads or skips it
+        template <typename F>
+        bool ReadArray(JsonReader& r, F item) {
+            JsonToken t = r.Next();
+            if (t != JsonToken::ArrayStart) return r.Skip(t);
+
+            while (true) {
+                if (r.ConsumeArrayEnd()) return true;
+                if (!item()) return false;
+            }
+        }
+
+        bool ReadPoint(JsonReader& r, double& x, double& y) {
+            return ReadObject(r, [&](std::string_view key) {
+                if (key == "x") return ReadNumber(r, x);
+                if (key == "y") return ReadNumber(r, y);
+                return r.Skip(r.Next());
+            });
+        }
+
+        bool ReadWaypoint(JsonReader& r, Waypoint& wp) {
+            // Same precedence as the GUI PathData::waypointFromJson
+            double theta_rad = 0, theta = 0, heading_deg = 0, heading = 0;
+            bool has_theta_rad = false, has_theta = false, has_heading_deg = false;
+            wp.velocity = 1.0;
+
+            bool ok = ReadObject(r, [&](std::string_view key) {
+                if (key == "x")           return ReadNumber(r, wp.x);
+                if (key == "y")           return ReadNumber(r, wp.y);
+                if (key == "velocity")    return ReadNumber(r, wp.velocity);
+                if (key == "theta_rad")   { has_theta_rad = true;   return ReadNumber(r, theta_rad); }
+                if (key == "theta")       { has_theta = true;       return ReadNumber(r, theta); }
+                if (key == "heading_deg") { has_heading_deg = true; return ReadNumber(r, heading_deg); }
+                if (key == "heading")     return ReadNumber(r, heading);
+                return r.Skip(r.Next());
+            });
+
+            if (has_theta_rad)        wp.heading = theta_rad;
+            else if (has_theta)       wp.heading = theta * M_PI / 180.0;
+            else if (has_heading_deg) wp.heading = heading_deg * M_PI / 180.0;
+            else                      wp.heading = heading;
+            return ok;
+        }
+
+        bool ReadWaypoints(JsonReader& r, std::vector<Waypoint>& waypoints) {
+            return ReadArray(r, [&]() {
+                waypoints.emplace_back();
+                return ReadWaypoint(r, waypoints.back());
+            });
+        }
+
+        bool ReadPath(JsonReader& r, Path& path) {
+            return ReadObject(r, [&](std::string_view key) {
+                if (key == "name")      return ReadString(r, path.name);
+                if (key == "waypoints") return ReadWaypoints(r, path.waypoints);
+                return r.Skip(r.Next());
+            });
+        }
+
+        bool ReadMap(JsonReader& r, FieldMap& map) {
+            return ReadObject(r, [&](std::string_view key) {
+                if (key == "name") return ReadString(r, map.name);
+                if (key == "lines") {
+                    return ReadArray(r, [&]() {
+                        WallSegment wall;
+                        bool has_start = false, has_end = false;
+                        bool ok = ReadObject(r, [&](std::string_view k) {
+                            if (k == "start") { has_start = true; return ReadPoint(r, wall.x1, wall.y1); }
+                            if (k == "end")   { has_end = true;   return ReadPoint(r, wall.x2, wall.y2); }
+                            return r.Skip(r.Next());
+                        });
+                        if (has_start && has_end) map.walls.push_back(wall);
+                        return ok;
+                    });
+                }
+                return r.Skip(r.Next());
+            });
+        }
+
+        bool ReadReferencePoints(JsonReader& r, std::vector<ReferencePoint>& points) {
+            return ReadArray(r, [&]() {
+                points.emplace_back();
+                ReferencePoint& p = points.back();
+                return ReadObject(r, [&](std::string_view key) {
+                    if (key == "name")       return ReadString(r, p.name);
+                    if (key == "x")          return ReadNumber(r, p.x);
+                    if (key == "y")          return ReadNumber(r, p.y);
+                    if (key == "heading")    return ReadNumber(r, p.heading);
+                    if (key == "hasHeading") return ReadBool(r, p.hasHeading);
+                    return r.Skip(r.Next());
+                });
+            });
+        }
+
+        // {"pose":20,"status":5}, unknown topics are ignored
+        bool ReadTopics(JsonReader& r, std::vector<TopicRate>& topics) {
+            return ReadObject(r, [&](std::string_view key) {
+                double rate = 0;
+                if (!ReadNumber(r, rate)) return false;
+                for (size_t i = 0; i < topic_count; i++) {
+                    Topic topic = static_cast<Topic>(i);
+                    if (key == TopicName(topic)) topics.push_back({topic, rate});
+                }
+                return true;
+            });
+        }
+
+        MessageType TypeFromName(std::string_view name) {
+            if (name == "sendPath")            return MessageType::SendPath;
+            if (name == "getState")            return MessageType::GetState;
+            if (name == "sendMapData")         return MessageType::SendMapData;
+            if (name == "sendReferencePoints") return MessageType::SendReferencePoints;
+            if (name == "hello")               return MessageType::Hello;
+            if (name == "subscribe")           return MessageType::Subscribe;
+            return MessageType::Unknown;
+        }
+    }
+
+    bool DecodeMessage(const char* begin, const char* end, IncomingMessage& msg) {
+        msg.Clear();
+        JsonReader r(begin, end);
+
+        // Keys come in any order (Qt sorts them), so every payload is decoded before the type is known
+        return ReadObject(r, [&](std::string_view key) {
+            if (key == "type") {
+                JsonToken t = r.Next();
+                if (t != JsonToken::String) return r.Skip(t);
+                msg.type = TypeFromName(r.Text());
+                return true;
+            }
+            if (key == "path")            return ReadPath(r, msg.path);
+            if (key == "mapData")         return ReadMap(r, msg.map);
+            if (key == "referencePoints") return ReadReferencePoints(r, msg.referencePoints);
+
+            // hello
+            if (key == "binary") {
+                double v = 0;
+                bool ok = ReadNumber(r, v);
+                msg.binaryVersion = static_cast<int>(v);
+                return ok;
+            }
+            if (key == "deltaPose")       return ReadBool(r, msg.deltaPose);
+
+            // subscribe
+            if (key == "topics")          return ReadTopics(r, msg.topics);
+
+            // Flat path, {"type":"sendPath","name":..,"waypoints":[..]}
+            if (key == "name")            return ReadString(r, msg.path.name);
+            if (key == "waypoints")       return ReadWaypoints(r, msg.path.waypoints);
+            return r.Skip(r.Next());
+        });
+    }
+
+} // namespace PathPlanner
@@ -0,0 +1,279 @@
+/************************************
+ * PathCache
+ * Received paths and the field map kept on the robot across reboots.
+ *************************************/
+
+#include "PathCache.h"
+#include "PathPlannerComm.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <libgen.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PathPlanner {
+namespace cache {
+
+    namespace {
+
+        constexpr std::array<uint32_t, 256> MakeCrcTable() {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return table;
+        }
+
+        constexpr std::array<uint32_t, 256> crc_table = MakeCrcTable();
+
+        void PutU8(std::string& out, uint8_t v) { out += static_cast<char>(v); }
+
+        void PutU16(std::string& out, uint16_t v) {
+            out += static_cast<char>(v & 0xFF);
+            out += static_cast<char>(v >> 8);
+        }
+
+        void PutU32(std::string& out, uint32_t v) {
+            for (int i = 0; i < 4; i++) out += static_cast<char>((v >> (8 * i)) & 0xFF);
+        }
+
+        void PutF32(std::string& out, double d) {
+            float f = static_cast<float>(d);
+            uint32_t v;
+            std::memcpy(&v, &f, sizeof(v));
+            PutU32(out, v);
+        }
+
+        void PutName(std::string& out, const std::string& name) {
+            size_t n = std::min<size_t>(name.size(), 0xFFFF);
+            PutU16(out, static_cast<uint16_t>(n));
+            out.append(name, 0, n);
+        }
+
+        // Bounds checked reads from the mapped file, every call fails once one did
+        class Reader {
+        public:
+            Reader(const char* begin, const char* end) : m_pos(begin), m_end(end) {}
+
+            bool Ok() const { return m_ok; }
+            bool AtEnd() const { return m_pos == m_end; }
+
+            const char* Take(size_t n) {
+                if (!m_ok || static_cast<size_t>(m_end - m_pos) < n) { m_ok = false; return nullptr; }
+                const char* p = m_pos;
+                m_pos += n;
+                return p;
+            }
+
+            uint8_t U8() {
+                const char* p = Take(1);
+                return p ? static_cast<uint8_t>(*p) : 0;
+            }
+
+            uint16_t U16() {
+                const uint8_t* b = reinterpret_cast<const uint8_t*>(Take(2));
+                return b ? static_cast<uint16_t>(b[0] | (b[1] << 8)) : 0;
+            }
+
+            uint32_t U32() {
+                const uint8_t* b = reinterpret_cast<const uint8_t*>(Take(4));
+                return b ? b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24) : 0;
+            }
+
+            double F32() {
+                uint32_t v = U32();
+                float f;
+                std::memcpy(&f, &v, sizeof(f));
+                return f;
+            }
+
+            bool Name(std::string& name) {
+                size_t n = U16();
+                const char* p = Take(n);
+                if (p) name.assign(p, n);
+                return p != nullptr;
+            }
+
+            // Element counts are checked against the bytes left before anything is allocated
+            bool Count(uint32_t& count, size_t element_size) {
+                count = U32();
+                if (m_ok && static_cast<size_t>(m_end - m_pos) / element_size < count) m_ok = false;
+                return m_ok;
+            }
+
+        private:
+            const char* m_pos;
+            const char* m_end;
+            bool m_ok = true;
+        };
+
+        bool ParseBody(Reader& r, std::vector<Path>& paths, FieldMap& map, bool& hasMap) {
+            uint32_t pathCount = r.U32();
+            for (uint32_t i = 0; i < pathCount && r.Ok(); i++) {
+                Path path;
+                uint32_t count;
+                if (!r.Name(path.name)) return false;
+                path.version = r.U32();
+                if (!r.Count(count, 16)) return false;
+
+                path.waypoints.resize(count);
+                for (Waypoint& wp : path.waypoints) {
+                    wp.x        = r.F32();
+                    wp.y        = r.F32();
+                    wp.heading  = r.F32();
+                    wp.velocity = r.F32();
+                }
+                paths.push_back(std::move(path));
+            }
+
+            hasMap = r.U8() != 0;
+            uint32_t wallCount;
+            if (!r.Name(map.name) || !r.Count(wallCount, 16)) return false;
+
+            map.walls.resize(wallCount);
+            for (WallSegment& wall : map.walls) {
+                wall.x1 = r.F32();
+                wall.y1 = r.F32();
+                wall.x2 = r.F32();
+                wall.y2 = r.F32();
+            }
+            return r.Ok() && r.AtEnd();
+        }
+
+        bool WriteAll(int fd, const std::string& data) {
+            size_t written = 0;
+            while (written < data.size()) {
+                ssize_t n = write(fd, data.data() + written, data.size() - written);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                written += n;
+            }
+            return true;
+        }
+
+        // The rename is only durable once the directory entry is on disk
+        void SyncDirectory(const std::string& file) {
+            std::string copy = file;
+            int fd = open(dirname(&copy[0]), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) return;
+            fsync(fd);
+            close(fd);
+        }
+    }
+
+    uint32_t Crc32(const char* data, size_t size) {
+        uint32_t c = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) c = crc_table[(c ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (c >> 8);
+        return c ^ 0xFFFFFFFFu;
+    }
+
+    bool Save(const std::string& file, const std::vector<PathPtr>& paths, const FieldMap* map) {
+        std::string body;
+        PutU32(body, static_cast<uint32_t>(paths.size()));
+        for (const PathPtr& path : paths) {
+            PutName(body, path->name);
+            PutU32(body, static_cast<uint32_t>(path->version));
+            PutU32(body, static_cast<uint32_t>(path->waypoints.size()));
+            for (const Waypoint& wp : path->waypoints) {
+                PutF32(body, wp.x);
+                PutF32(body, wp.y);
+                PutF32(body, wp.heading);
+                PutF32(body, wp.velocity);
+            }
+        }
+
+        PutU8(body, map ? 1 : 0);
+        PutName(body, map ? map->name : std::string());
+        PutU32(body, map ? static_cast<uint32_t>(map->walls.size()) : 0);
+        if (map) {
+            for (const WallSegment& wall : map->walls) {
+                PutF32(body, wall.x1);
+                PutF32(body, wall.y1);
+                PutF32(body, wall.x2);
+                PutF32(body, wall.y2);
+            }
+        }
+
+        std::string data(magic, sizeof(magic));
+        PutU32(data, format);
+        PutU32(data, static_cast<uint32_t>(body.size()));
+        PutU32(data, Crc32(body.data(), body.size()));
+        data += body;
+
+        const std::string temp = file + ".tmp";
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            LOG_ERROR( "[PathPlanner] Cannot write %s: %s", temp, strerror(errno) );
+            return false;
+        }
+
+        bool ok = WriteAll(fd, data) && fsync(fd) == 0;
+        ok = (close(fd) == 0) && ok;
+        if (!ok || rename(temp.c_str(), file.c_str()) != 0) {
+            LOG_ERROR( "[PathPlanner] Failed to save %s: %s", file, strerror(errno) );
+            unlink(temp.c_str());
+            return false;
+        }
+
+        SyncDirectory(file);
+        return true;
+    }
+
+    bool Load(const std::string& file, std::vector<Path>& paths, FieldMap& map, bool& hasMap) {
+        paths.clear();
+        map.name.clear();
+        map.walls.clear();
+        hasMap = false;
+
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size) {
+            close(fd);
+            return false;
+        }
+
+        const size_t size = st.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        const char* data = static_cast<const char*>(mapped);
+        Reader header(data, data + header_size);
+        header.Take(sizeof(magic));
+        uint32_t version  = header.U32();
+        uint32_t bodySize = header.U32();
+        uint32_t crc      = header.U32();
+
+        bool ok = std::memcmp(data, magic, sizeof(magic)) == 0 && version == format &&
+                  bodySize == size - header_size && crc == Crc32(data + header_size, bodySize);
+        if (ok) {
+            Reader body(data + header_size, data + size);
+            ok = ParseBody(body, paths, map, hasMap);
+        }
+        munmap(mapped, size);
+
+        if (!ok) {
+            LOG_WARN( "[PathPlanner] Ignoring damaged path cache %s", file );
+            paths.clear();
+            map.name.clear();
+            map.walls.clear();
+            hasMap = false;
+        }
+        return ok;
+    }
+
+} // namespace cache
+} // namespace PathPlanner
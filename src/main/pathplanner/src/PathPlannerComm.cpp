@@ -4,136 +4,129 @@
  *************************************/
 
 #include "PathPlannerComm.h"
-#include <iostream>
+#include "Log.h"
+#include <algorithm>
 #include <sstream>
 #include <cstring>
 #include <cmath>
+#include <cerrno>
 #include <chrono>
-#include <thread>
-
-// Platform-specific socket includes
-#ifdef _WIN32
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#else
-    #include <sys/socket.h>
-    #include <netinet/in.h>
-    #include <arpa/inet.h>
-    #include <unistd.h>
-    #include <fcntl.h>
-    #define INVALID_SOCKET -1
-    #define SOCKET_ERROR -1
-#endif
+#include <climits>
+#include <cstdio>
 
-namespace PathPlanner {
-
-    // Simple JSON parser (minimal implementation for our needs)
-    class SimpleJson {
-    public:
-        static std::string GetString(const std::string& json, const std::string& key) {
-            std::string searchKey = "\"" + key + "\":";
-            size_t pos = json.find(searchKey);
-            if (pos == std::string::npos) return "";
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
 
-            pos += searchKey.length();
-            while (pos < json.length() && (json[pos] == ' ' || json[pos] == '"')) pos++;
+#define INVALID_SOCKET -1
+#define SOCKET_ERROR -1
 
-            size_t endPos = json.find_first_of("\",}", pos);
-            if (endPos == std::string::npos) return "";
-
-            return json.substr(pos, endPos - pos);
-        }
+namespace PathPlanner {
 
-        static double GetNumber(const std::string& json, const std::string& key) {
-            std::string value = GetString(json, key);
-            if (value.empty()) return 0.0;
-            return std::stod(value);
+    namespace {
+        int64_t NowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
         }
+    }
 
-        static bool GetBool(const std::string& json, const std::string& key) {
-            std::string value = GetString(json, key);
-            return value == "true";
+    const char* TopicName(Topic topic) {
+        switch (topic) {
+            case Topic::Pose:      return "pose";
+            case Topic::Status:    return "status";
+            case Topic::LidarScan: return "lidarScan";
+            case Topic::Odometry:  return "odometry";
         }
-    };
+        return nullptr;
+    }
 
     PathPlannerComm::PathPlannerComm(int port)
         : m_port(port),
           m_serverSocket(INVALID_SOCKET),
-          m_clientSocket(INVALID_SOCKET),
+          m_epollFd(-1),
+          m_wakeFd(-1),
           m_running(false),
           m_connected(false),
-          m_currentPose(0, 0, 0),
-          m_hasNewPath(false) {
-
-#ifdef _WIN32
-        WSADATA wsaData;
-        WSAStartup(MAKEWORD(2, 2), &wsaData);
-#endif
+          m_clientCount(0),
+          m_statusMoving(false),
+          m_cacheFile(cache::default_file),
+          m_cacheDirty(false),
+          m_hasMap(false) {
+
+        for (size_t i = 0; i < topic_count; i++) {
+            m_versions[i] = 0;
+            m_subscribers[i] = 0;
+        }
+        // The origin is a pose too, new clients get it right away
+        m_versions[static_cast<size_t>(Topic::Pose)] = 1;
 
-        std::cout << "[PathPlanner] PathPlannerComm initialized on port " << m_port << std::endl;
+        LOG_INFO( "[PathPlanner] PathPlannerComm initialized on port %d", m_port );
     }
 
     PathPlannerComm::~PathPlannerComm() {
         Stop();
-
-#ifdef _WIN32
-        WSACleanup();
-#endif
     }
 
     void PathPlannerComm::Start() {
         if (m_running) {
-            std::cout << "[PathPlanner] Already running!" << std::endl;
+            LOG_WARN( "[PathPlanner] Already running!" );
+            return;
+        }
+
+        // Created here so other threads can wake the reactor for its whole life
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wakeFd < 0) {
+            LOG_ERROR( "[PathPlanner] Failed to create eventfd!" );
             return;
         }
 
+        // Stored paths are usable before the GUI connects
+        LoadCache();
+
         m_running = true;
         m_serverThread = std::thread(&PathPlannerComm::ServerThread, this);
-        m_sendThread = std::thread(&PathPlannerComm::SendThread, this);
+        if (!m_cacheFile.empty()) m_cacheThread = std::thread(&PathPlannerComm::CacheThread, this);
 
-        std::cout << "[PathPlanner] Communication started" << std::endl;
+        LOG_INFO( "[PathPlanner] Communication started" );
     }
 
     void PathPlannerComm::Stop() {
         if (!m_running) return;
 
         m_running = false;
-        m_connected = false;
+        Wake();
 
-        if (m_clientSocket != INVALID_SOCKET) {
-#ifdef _WIN32
-            closesocket(m_clientSocket);
-#else
-            close(m_clientSocket);
-#endif
-            m_clientSocket = INVALID_SOCKET;
-        }
+        if (m_serverThread.joinable()) m_serverThread.join();
 
-        if (m_serverSocket != INVALID_SOCKET) {
-#ifdef _WIN32
-            closesocket(m_serverSocket);
-#else
-            close(m_serverSocket);
-#endif
-            m_serverSocket = INVALID_SOCKET;
+        // Saves what is still pending
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            m_cacheCv.notify_all();
         }
+        if (m_cacheThread.joinable()) m_cacheThread.join();
 
-        if (m_serverThread.joinable()) m_serverThread.join();
-        if (m_sendThread.joinable()) m_sendThread.join();
+        close(m_wakeFd);
+        m_wakeFd = -1;
 
-        std::cout << "[PathPlanner] Communication stopped" << std::endl;
+        LOG_INFO( "[PathPlanner] Communication stopped" );
     }
 
     bool PathPlannerComm::IsConnected() const {
         return m_connected;
     }
 
+    int PathPlannerComm::GetClientCount() const {
+        return m_clientCount;
+    }
+
     void PathPlannerComm::UpdateRobotPose(double x, double y, double heading) {
-        std::lock_guard<std::mutex> lock(m_poseMutex);
-        m_currentPose.x = x;
-        m_currentPose.y = y;
-        m_currentPose.heading = heading;
+        m_pose.Store(RobotPose(x, y, heading));
+        Publish(Topic::Pose);
     }
 
     void PathPlannerComm::UpdateRobotPose(const RobotPose& pose) {
@@ -144,84 +137,197 @@ namespace PathPlanner {
         m_pathCallback = callback;
     }
 
+    PathPtr PathPlannerComm::GetLatestPath() {
+        return m_paths.TakeLatest();
+    }
+
     bool PathPlannerComm::GetLatestPath(Path& path) {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
-        if (!m_hasNewPath) return false;
+        PathPtr latest = m_paths.TakeLatest();
+        if (!latest) return false;
 
-        path = m_latestPath;
-        m_hasNewPath = false;
+        path = *latest;
         return true;
     }
 
-    std::vector<Path> PathPlannerComm::GetAllPaths() {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
-        return m_allPaths;
+    std::vector<PathPtr> PathPlannerComm::GetAllPaths() {
+        return m_paths.All();
+    }
+
+    PathPtr PathPlannerComm::GetPathByName(const std::string& name) {
+        return m_paths.Find(name);
     }
 
     bool PathPlannerComm::GetPathByName(const std::string& name, Path& path) {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
+        PathPtr found = m_paths.Find(name);
+        if (!found) return false;
+
+        path = *found;
+        return true;
+    }
 
-        for (const auto& p : m_allPaths) {
-            if (p.name == name) {
-                path = p;
-                return true;
+    PathPtr PathPlannerComm::GetPathByIndex(int index) {
+        return m_paths.At(index);
+    }
+
+    bool PathPlannerComm::GetPathByIndex(int index, Path& path) {
+        PathPtr found = m_paths.At(index);
+        if (!found) return false;
+
+        path = *found;
+        return true;
+    }
+
+    uint64_t PathPlannerComm::GetPathVersion(const std::string& name) const {
+        return m_paths.Version(name);
+    }
+
+    int PathPlannerComm::GetPathCount() const {
+        return m_paths.Count();
+    }
+
+    void PathPlannerComm::ClearPaths() {
+        m_paths.Clear();
+        SaveCacheLater();
+    }
+
+    void PathPlannerComm::SetCacheFile(const std::string& file) {
+        m_cacheFile = file;
+    }
+
+    void PathPlannerComm::LoadCache() {
+        if (m_cacheFile.empty()) return;
+
+        std::vector<Path> paths;
+        FieldMap map;
+        bool hasMap = false;
+        if (!cache::Load(m_cacheFile, paths, map, hasMap)) return;
+
+        for (Path& path : paths) m_paths.Restore(std::move(path));
+        LOG_INFO( "[PathPlanner] Loaded %d paths%s from %s", m_paths.Count(), hasMap ? " and the map" : "", m_cacheFile );
+
+        if (hasMap) {
+            {
+                std::lock_guard<std::mutex> lock(m_mapMutex);
+                m_map = map;
+                m_hasMap = true;
             }
+            if (m_mapCallback) m_mapCallback(map);
         }
-        return false;
     }
 
-    bool PathPlannerComm::GetPathByIndex(int index, Path& path) {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
+    void PathPlannerComm::SaveCacheLater() {
+        if (m_cacheFile.empty()) return;
 
-        if (index < 0 || index >= static_cast<int>(m_allPaths.size())) {
-            return false;
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        m_cacheDirty = true;
+        m_cacheCv.notify_all();
+    }
+
+    void PathPlannerComm::CacheThread() {
+        // fsync can take long on the SD card, it never runs on the reactor
+        std::unique_lock<std::mutex> lock(m_cacheMutex);
+        while (true) {
+            m_cacheCv.wait(lock, [this] { return m_cacheDirty || !m_running; });
+            if (!m_cacheDirty) return;
+
+            // Paths of one upload arrive back to back
+            m_cacheCv.wait_for(lock, std::chrono::milliseconds(cache_delay_ms), [this] { return !m_running; });
+            m_cacheDirty = false;
+            lock.unlock();
+
+            FieldMap map;
+            bool hasMap = GetMap(map);
+            if (cache::Save(m_cacheFile, m_paths.All(), hasMap ? &map : nullptr)) {
+                LOG_INFO( "[PathPlanner] Saved paths to %s", m_cacheFile );
+            }
+
+            lock.lock();
         }
+    }
+
+    void PathPlannerComm::SetMapReceivedCallback(std::function<void(const FieldMap&)> callback) {
+        m_mapCallback = callback;
+    }
 
-        path = m_allPaths[index];
+    bool PathPlannerComm::GetMap(FieldMap& map) {
+        std::lock_guard<std::mutex> lock(m_mapMutex);
+        if (!m_hasMap) return false;
+
+        map = m_map;
         return true;
     }
 
-    int PathPlannerComm::GetPathCount() const {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
-        return static_cast<int>(m_allPaths.size());
+    void PathPlannerComm::SetReferencePointsReceivedCallback(std::function<void(const std::vector<ReferencePoint>&)> callback) {
+        m_referenceCallback = callback;
     }
 
-    void PathPlannerComm::ClearPaths() {
-        std::lock_guard<std::mutex> lock(m_pathMutex);
-        m_allPaths.clear();
-        m_hasNewPath = false;
+    std::vector<ReferencePoint> PathPlannerComm::GetReferencePoints() {
+        std::lock_guard<std::mutex> lock(m_referenceMutex);
+        return m_referencePoints;
     }
 
     void PathPlannerComm::SendStatus(const std::string& status, bool isMoving) {
-        if (!m_connected) return;
-        std::string json = CreateStatusJson(status, isMoving);
-        SendMessage(json);
+        {
+            std::lock_guard<std::mutex> lock(m_topicMutex);
+            bool published = m_versions[static_cast<size_t>(Topic::Status)] != 0;
+            if (published && status == m_status && isMoving == m_statusMoving) return;
+
+            m_status = status;
+            m_statusMoving = isMoving;
+        }
+        Publish(Topic::Status);
+
+        LOG_INFO( "[PathPlanner] Sent status: %s (moving: %d)", status, isMoving );
+    }
+
+    void PathPlannerComm::PublishLidarScan(const float* ranges, size_t count) {
+        LidarScan& scan = m_lidarScan.WriteBuffer();
+        scan.count = std::min(count, LidarScan::max_ranges);
+        std::copy(ranges, ranges + scan.count, scan.ranges);
+        m_lidarScan.Publish();
+        Publish(Topic::LidarScan);
+    }
+
+    void PathPlannerComm::PublishOdometry(const OdometryDiagnostics& odometry) {
+        m_odometry.Store(odometry);
+        Publish(Topic::Odometry);
+    }
 
-        std::cout << "[PathPlanner] Sent status: " << status << " (moving: " << isMoving << ")" << std::endl;
+    bool PathPlannerComm::HasSubscribers(Topic topic) const {
+        return m_subscribers[static_cast<size_t>(topic)] > 0;
+    }
+
+    void PathPlannerComm::Publish(Topic topic) {
+        m_versions[static_cast<size_t>(topic)]++;
+        if (m_subscribers[static_cast<size_t>(topic)] > 0) Wake();
     }
 
     void PathPlannerComm::NotifyPathExecutionStarted() {
         if (!m_connected) return;
-        SendMessage("{\"type\":\"pathExecutionStarted\"}");
+        std::string frame;
+        wire::AppendExecution(frame, false, true);
+        SendMessage("{\"type\":\"pathExecutionStarted\"}", frame);
 
-        std::cout << "[PathPlanner] Sent path execution started notification" << std::endl;
+        LOG_INFO( "[PathPlanner] Sent path execution started notification" );
     }
 
     void PathPlannerComm::NotifyPathExecutionFinished(bool success) {
         if (!m_connected) return;
         std::string json = "{\"type\":\"pathExecutionFinished\",\"success\":";
         json += success ? "true}" : "false}";
-        SendMessage(json);
 
-        std::cout << "[PathPlanner] Sent path execution finished: " << (success ? "success" : "failed") << std::endl;
+        std::string frame;
+        wire::AppendExecution(frame, true, success);
+        SendMessage(json, frame);
+
+        LOG_INFO( "[PathPlanner] Sent path execution finished: %s", success ? "success" : "failed" );
     }
 
-    void PathPlannerComm::ServerThread() {
-        // Create server socket
-        m_serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    bool PathPlannerComm::OpenServer() {
+        m_serverSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (m_serverSocket == INVALID_SOCKET) {
-            std::cerr << "[PathPlanner] Failed to create server socket!" << std::endl;
-            return;
+            LOG_ERROR( "[PathPlanner] Failed to create server socket!" );
+            return false;
         }
 
         // Set socket options
@@ -236,212 +342,515 @@ namespace PathPlanner {
         serverAddr.sin_port = htons(m_port);
 
         if (bind(m_serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-            std::cerr << "[PathPlanner] Failed to bind socket to port " << m_port << std::endl;
-            return;
+            LOG_ERROR( "[PathPlanner] Failed to bind socket to port %d", m_port );
+            return false;
         }
 
-        // Listen for connections
-        if (listen(m_serverSocket, 1) == SOCKET_ERROR) {
-            std::cerr << "[PathPlanner] Failed to listen on socket!" << std::endl;
-            return;
+        if (listen(m_serverSocket, max_clients) == SOCKET_ERROR) {
+            LOG_ERROR( "[PathPlanner] Failed to listen on socket!" );
+            return false;
         }
 
-        std::cout << "[PathPlanner] Server listening on port " << m_port << std::endl;
+        m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (m_epollFd < 0) {
+            LOG_ERROR( "[PathPlanner] Failed to create epoll instance!" );
+            return false;
+        }
 
-        while (m_running) {
-            // Accept connection
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = m_serverSocket;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_serverSocket, &ev);
+        ev.data.fd = m_wakeFd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+
+        return true;
+    }
+
+    void PathPlannerComm::ServerThread() {
+        if (OpenServer()) {
+            LOG_INFO( "[PathPlanner] Server listening on port %d", m_port );
+
+            struct epoll_event events[16];
+            int64_t nextDue = INT64_MAX;
+            while (m_running) {
+                // Wake up for the next rate limited topic, otherwise only on events
+                int timeout = -1;
+                if (nextDue != INT64_MAX) {
+                    int64_t wait = nextDue - NowNs();
+                    timeout = wait > 0 ? static_cast<int>((wait + 999999) / 1000000) : 0;
+                }
+
+                int n = epoll_wait(m_epollFd, events, 16, timeout);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    LOG_ERROR( "[PathPlanner] epoll_wait failed: %s", strerror(errno) );
+                    break;
+                }
+
+                for (int i = 0; i < n; i++) {
+                    int fd = events[i].data.fd;
+                    uint32_t flags = events[i].events;
+
+                    if (fd == m_serverSocket) {
+                        AcceptClients();
+                    } else if (fd == m_wakeFd) {
+                        uint64_t count;
+                        while (read(m_wakeFd, &count, sizeof(count)) > 0) {}
+                    } else {
+                        for (auto& c : m_clients) {
+                            if (c->fd != fd || c->closed) continue;
+
+                            if (flags & (EPOLLERR | EPOLLHUP)) CloseClient(*c);
+                            if (!c->closed && (flags & EPOLLIN) && !ReadClient(*c)) CloseClient(*c);
+                            if (!c->closed && (flags & EPOLLOUT) && !FlushClient(*c)) CloseClient(*c);
+                            break;
+                        }
+                    }
+                }
+
+                nextDue = DispatchOutgoing();
+                RemoveClosedClients();
+            }
+        }
+
+        for (auto& c : m_clients) CloseClient(*c);
+        RemoveClosedClients();
+
+        if (m_epollFd >= 0) close(m_epollFd);
+        if (m_serverSocket != INVALID_SOCKET) close(m_serverSocket);
+        m_epollFd = -1;
+        m_serverSocket = INVALID_SOCKET;
+    }
+
+    void PathPlannerComm::AcceptClients() {
+        while (true) {
             struct sockaddr_in clientAddr;
             socklen_t clientLen = sizeof(clientAddr);
 
-            std::cout << "[PathPlanner] Waiting for GUI connection..." << std::endl;
-            m_clientSocket = accept(m_serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
-
-            if (m_clientSocket == INVALID_SOCKET) {
-                if (m_running) {
-                    std::cerr << "[PathPlanner] Accept failed!" << std::endl;
+            int fd = accept4(m_serverSocket, (struct sockaddr*)&clientAddr, &clientLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    LOG_ERROR( "[PathPlanner] Accept failed: %s", strerror(errno) );
                 }
+                return;
+            }
+
+            if (static_cast<int>(m_clients.size()) >= max_clients) {
+                LOG_WARN( "[PathPlanner] Too many clients, refusing connection" );
+                close(fd);
                 continue;
             }
 
-            m_connected = true;
-            std::cout << "[PathPlanner] GUI connected!" << std::endl;
+            // Small messages, send them right away
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char*)&opt, sizeof(opt));
 
-            // Receive messages
-            char buffer[4096];
-            std::string receivedData;
+            std::unique_ptr<Client> client(new Client());
+            client->fd = fd;
+            client->address = std::string(inet_ntoa(clientAddr.sin_addr)) + ":" + std::to_string(ntohs(clientAddr.sin_port));
 
-            while (m_running && m_connected) {
-                memset(buffer, 0, sizeof(buffer));
-                int bytesReceived = recv(m_clientSocket, buffer, sizeof(buffer) - 1, 0);
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                close(fd);
+                continue;
+            }
 
-                if (bytesReceived <= 0) {
-                    m_connected = false;
-                    std::cout << "[PathPlanner] GUI disconnected" << std::endl;
-                    break;
-                }
+            LOG_INFO( "[PathPlanner] GUI connected from %s", client->address );
 
-                receivedData += std::string(buffer, bytesReceived);
+            // Every pose and status change until the client subscribes, the latest ones are sent right away
+            client->topics[static_cast<size_t>(Topic::Pose)].active = true;
+            client->topics[static_cast<size_t>(Topic::Status)].active = true;
 
-                // Process complete messages (newline-delimited)
-                size_t pos;
-                while ((pos = receivedData.find('\n')) != std::string::npos) {
-                    std::string message = receivedData.substr(0, pos);
-                    receivedData = receivedData.substr(pos + 1);
+            m_clients.push_back(std::move(client));
+            m_clientCount = static_cast<int>(m_clients.size());
+            m_connected = true;
+            CountSubscribers();
+        }
+    }
 
-                    if (!message.empty()) {
-                        std::cout << "[PathPlanner] Received message: " << message << std::endl;
-                        HandleMessage(message);
-                    }
+    bool PathPlannerComm::ReadClient(Client& client) {
+        while (true) {
+            size_t space;
+            char* buffer = client.inbox.WritePtr(space);
+            if (!buffer) {
+                LOG_ERROR( "[PathPlanner] Message from %s exceeds %zu bytes", client.address, MessageBuffer::max_size );
+                return false;
+            }
+
+            ssize_t bytesReceived = recv(client.fd, buffer, space, 0);
+            if (bytesReceived == 0) return false;
+            if (bytesReceived < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+                if (errno == EINTR) continue;
+                return false;
+            }
+            client.inbox.Commit(bytesReceived);
+
+            // Process complete messages (newline-delimited), decoded in place
+            const char* begin;
+            const char* end;
+            while (client.inbox.Next(begin, end)) {
+                if (begin == end) continue;
+
+                bool decoded = wire::IsFrame(begin) ? wire::DecodeFrame(begin, end, m_incoming)
+                                                    : DecodeMessage(begin, end, m_incoming);
+                if (!decoded) {
+                    LOG_WARN( "[PathPlanner] Malformed message from %s", client.address );
+                    continue;
                 }
+
+                HandleMessage(client, m_incoming);
+                if (client.closed) return true;
+            }
+        }
+    }
+
+    bool PathPlannerComm::FlushClient(Client& client) {
+        while (client.outboxSent < client.outbox.size()) {
+            ssize_t sent = send(client.fd, client.outbox.data() + client.outboxSent,
+                                client.outbox.size() - client.outboxSent, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                LOG_ERROR( "[PathPlanner] Send to %s failed: %s", client.address, strerror(errno) );
+                return false;
             }
+            client.outboxSent += sent;
+        }
 
-#ifdef _WIN32
-            closesocket(m_clientSocket);
-#else
-            close(m_clientSocket);
-#endif
-            m_clientSocket = INVALID_SOCKET;
+        if (client.outboxSent == client.outbox.size()) {
+            client.outbox.clear();
+            client.outboxSent = 0;
         }
+
+        // Only wait for EPOLLOUT while something is pending
+        bool wantWrite = !client.outbox.empty();
+        if (wantWrite != client.writeArmed) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            ev.data.fd = client.fd;
+            epoll_ctl(m_epollFd, EPOLL_CTL_MOD, client.fd, &ev);
+            client.writeArmed = wantWrite;
+        }
+        return true;
     }
 
-    void PathPlannerComm::SendThread() {
-        while (m_running) {
-            if (m_connected) {
-                // Send robot pose update (20Hz)
-                RobotPose pose;
-                {
-                    std::lock_guard<std::mutex> lock(m_poseMutex);
-                    pose = m_currentPose;
+    void PathPlannerComm::CloseClient(Client& client) {
+        if (client.closed) return;
+
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+        close(client.fd);
+        client.closed = true;
+
+        LOG_INFO( "[PathPlanner] GUI disconnected (%s)", client.address );
+    }
+
+    void PathPlannerComm::RemoveClosedClients() {
+        size_t before = m_clients.size();
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                       [](const std::unique_ptr<Client>& c) { return c->closed; }),
+                        m_clients.end());
+
+        if (m_clients.size() != before) {
+            m_clientCount = static_cast<int>(m_clients.size());
+            m_connected = !m_clients.empty();
+            CountSubscribers();
+        }
+    }
+
+    int64_t PathPlannerComm::DispatchOutgoing() {
+        std::vector<OutgoingMessage> outgoing;
+        {
+            std::lock_guard<std::mutex> lock(m_outgoingMutex);
+            outgoing.swap(m_outgoing);
+        }
+
+        int64_t nextDue = INT64_MAX;
+        if (m_clients.empty()) return nextDue;
+
+        uint64_t versions[topic_count];
+        for (size_t i = 0; i < topic_count; i++) versions[i] = m_versions[i];
+        const int64_t now = NowNs();
+
+        for (auto& c : m_clients) {
+            if (c->closed) continue;
+
+            for (const OutgoingMessage& message : outgoing) Enqueue(*c, c->binary ? message.frame : message.json, false);
+
+            // Only the latest value of a topic is sent, whatever changed since the last send is coalesced
+            for (size_t i = 0; i < topic_count && !c->closed; i++) {
+                Subscription& sub = c->topics[i];
+                if (!sub.active || versions[i] == 0 || versions[i] == sub.version) continue;
+
+                int64_t due = sub.lastSent_ns + sub.period_ns;
+                if (now < due) {
+                    nextDue = std::min(nextDue, due);
+                    continue;
                 }
 
-                std::string json = CreatePoseJson(pose);
-                SendMessage(json);
+                EnqueueTopic(*c, static_cast<Topic>(i));
+                sub.version = versions[i];
+                sub.lastSent_ns = now;
             }
 
-            // Sleep for 50ms (20Hz)
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (!c->closed && !FlushClient(*c)) CloseClient(*c);
         }
+        return nextDue;
     }
 
-    void PathPlannerComm::HandleMessage(const std::string& message) {
-        std::string type = SimpleJson::GetString(message, "type");
+    void PathPlannerComm::Wake() {
+        if (m_wakeFd < 0) return;
 
-        // Only print detailed info for sendPath messages
-        if (type == "sendPath") {
-            std::cout << "[PathPlanner] ===== PATH MESSAGE RECEIVED =====" << std::endl;
-            std::cout << "[PathPlanner] Full message: " << message << std::endl;
-        }
+        uint64_t one = 1;
+        ssize_t ret = write(m_wakeFd, &one, sizeof(one));
+        (void)ret;      // EAGAIN only when the counter is saturated, the reactor is awake anyway
+    }
 
-        if (type == "sendPath") {
-            // Parse path from JSON
-            Path path = ParsePathFromJson(message);
+    void PathPlannerComm::HandleMessage(Client& client, const IncomingMessage& message) {
+        if (message.type == MessageType::SendPath) {
+            const Path& path = message.path;
 
-            std::cout << "[PathPlanner] ===== PATH DATA =====" << std::endl;
-            std::cout << "[PathPlanner] Path name: " << path.name << std::endl;
-            std::cout << "[PathPlanner] Number of waypoints: " << path.waypoints.size() << std::endl;
+            LOG_INFO( "[PathPlanner] Path received: %s (%zu waypoints)", path.name, path.waypoints.size() );
 
-            for (size_t i = 0; i < path.waypoints.size(); i++) {
+            // Waypoints only at debug level, long paths would flood the console
+            const size_t printed = logging::GetLevel() <= logging::Level::Debug ? std::min<size_t>(path.waypoints.size(), 10) : 0;
+            for (size_t i = 0; i < printed; i++) {
                 const auto& wp = path.waypoints[i];
-                std::cout << "[PathPlanner]   Waypoint " << i << ": "
-                         << "x=" << wp.x << "m, "
-                         << "y=" << wp.y << "m, "
-                         << "heading=" << wp.heading << "rad, "
-                         << "velocity=" << wp.velocity << "m/s" << std::endl;
+                LOG_DEBUG( "[PathPlanner]   Waypoint %zu: x=%gm, y=%gm, heading=%grad, velocity=%gm/s",
+                           i, wp.x, wp.y, wp.heading, wp.velocity );
+            }
+            if (printed < path.waypoints.size()) {
+                LOG_DEBUG( "[PathPlanner]   ... %zu more", path.waypoints.size() - printed );
             }
-            std::cout << "[PathPlanner] ================================" << std::endl;
+            // Store in all paths - replace if name already exists
+            PathPtr stored = m_paths.Put(path);
+            if (stored->version > 1) {
+                LOG_INFO( "[PathPlanner] Updated existing path: %s (version %llu)", path.name,
+                          static_cast<unsigned long long>(stored->version) );
+            } else {
+                LOG_INFO( "[PathPlanner] Added new path: %s (Total paths: %d)", path.name, m_paths.Count() );
+            }
+
+            SaveCacheLater();
+
+            // Call callback if set
+            if (m_pathCallback) {
+                m_pathCallback(*stored);
+            }
+        }
+        else if (message.type == MessageType::SendMapData) {
+            const FieldMap& map = message.map;
+
+            LOG_INFO( "[PathPlanner] Map received: %s (%zu walls)", map.name, map.walls.size() );
 
             {
-                std::lock_guard<std::mutex> lock(m_pathMutex);
-                m_latestPath = path;
-                m_hasNewPath = true;
-
-                // Store in all paths - replace if name already exists
-                bool found = false;
-                for (auto& p : m_allPaths) {
-                    if (p.name == path.name) {
-                        p = path;  // Replace existing path
-                        found = true;
-                        std::cout << "[PathPlanner] Updated existing path: " << path.name << std::endl;
-                        break;
-                    }
-                }
+                std::lock_guard<std::mutex> lock(m_mapMutex);
+                m_map = map;
+                m_hasMap = true;
+            }
+            SaveCacheLater();
 
-                if (!found) {
-                    m_allPaths.push_back(path);
-                    std::cout << "[PathPlanner] Added new path: " << path.name
-                             << " (Total paths: " << m_allPaths.size() << ")" << std::endl;
-                }
+            if (m_mapCallback) {
+                m_mapCallback(map);
             }
+        }
+        else if (message.type == MessageType::SendReferencePoints) {
+            LOG_INFO( "[PathPlanner] Reference points received: %zu", message.referencePoints.size() );
 
-            // Call callback if set
-            if (m_pathCallback) {
-                m_pathCallback(path);
+            {
+                std::lock_guard<std::mutex> lock(m_referenceMutex);
+                m_referencePoints = message.referencePoints;
+            }
+
+            if (m_referenceCallback) {
+                m_referenceCallback(message.referencePoints);
             }
         }
-        else if (type == "getState") {
+        else if (message.type == MessageType::GetState) {
             // Don't spam console with state requests
-            SendStatus("idle", false);
-
-            // Also send current robot pose
+            std::string status = "idle";
+            bool isMoving = false;
             {
-                std::lock_guard<std::mutex> lock(m_poseMutex);
-                std::string poseJson = CreatePoseJson(m_currentPose);
-                SendMessage(poseJson);
+                std::lock_guard<std::mutex> lock(m_topicMutex);
+                if (!m_status.empty()) {
+                    status = m_status;
+                    isMoving = m_statusMoving;
+                }
             }
+            EnqueueStatus(client, status, isMoving);
+
+            // Also send current robot pose
+            EnqueuePose(client, m_pose.Load());
+            if (!client.closed && !FlushClient(client)) CloseClient(client);
+        }
+        else if (message.type == MessageType::Hello) {
+            // Acknowledged in JSON, frames start right after it
+            int binary = std::min<int>(message.binaryVersion, wire::version);
+            bool deltaPose = binary > 0 && message.deltaPose;
+
+            std::string ack = "{\"type\":\"helloAck\",\"binary\":" + std::to_string(binary) +
+                              ",\"deltaPose\":" + (deltaPose ? "true" : "false") + "}\n";
+            Enqueue(client, ack, false);
+
+            client.binary = binary > 0;
+            client.poseEncoder.Reset(deltaPose);
+
+            LOG_INFO( "[PathPlanner] %s uses %s%s", client.address, client.binary ? "binary frames" : "JSON",
+                      deltaPose ? " with pose deltas" : "" );
+
+            if (!client.closed && !FlushClient(client)) CloseClient(client);
+        }
+        else if (message.type == MessageType::Subscribe) {
+            Subscribe(client, message.topics);
+            if (!client.closed && !FlushClient(client)) CloseClient(client);
         }
     }
 
-    void PathPlannerComm::SendMessage(const std::string& message) {
-        if (!m_connected || m_clientSocket == INVALID_SOCKET) return;
+    void PathPlannerComm::Subscribe(Client& client, const std::vector<TopicRate>& topics) {
+        for (const TopicRate& t : topics) {
+            Subscription& sub = client.topics[static_cast<size_t>(t.topic)];
+            double rate = std::min(t.rate, max_topic_rate);
 
-        std::string toSend = message + "\n";
-        int result = send(m_clientSocket, toSend.c_str(), toSend.length(), 0);
+            if (!(rate > 0)) {
+                sub.active = false;
+                continue;
+            }
 
-        // If send fails, mark as disconnected
-        if (result <= 0) {
-            std::cerr << "[PathPlanner] Send failed, marking disconnected" << std::endl;
-            m_connected = false;
+            // A new subscriber gets the current value on the next dispatch
+            if (!sub.active) sub.version = 0;
+            sub.active = true;
+            sub.period_ns = static_cast<int64_t>(1e9 / rate);
         }
+
+        std::ostringstream ack;
+        ack << "{\"type\":\"subscribeAck\",\"topics\":{";
+        bool first = true;
+        for (size_t i = 0; i < topic_count; i++) {
+            const Subscription& sub = client.topics[i];
+            if (!sub.active) continue;
+            ack << (first ? "" : ",") << "\"" << TopicName(static_cast<Topic>(i)) << "\":"
+                << (sub.period_ns > 0 ? 1e9 / sub.period_ns : 0.0);
+            first = false;
+        }
+        ack << "}}";
+        const std::string line = ack.str();
+        Enqueue(client, line + "\n", false);
+
+        CountSubscribers();
+        LOG_INFO( "[PathPlanner] %s subscribed: %s", client.address, line );
     }
 
-    Path PathPlannerComm::ParsePathFromJson(const std::string& json) {
-        Path path;
+    void PathPlannerComm::CountSubscribers() {
+        int counts[topic_count] = {};
+        for (const auto& c : m_clients) {
+            if (c->closed) continue;
+            for (size_t i = 0; i < topic_count; i++) counts[i] += c->topics[i].active ? 1 : 0;
+        }
+        for (size_t i = 0; i < topic_count; i++) m_subscribers[i] = counts[i];
+    }
 
-        // Extract path name
-        path.name = SimpleJson::GetString(json, "name");
+    void PathPlannerComm::SendMessage(const std::string& json, std::string frame) {
+        if (!m_connected) return;
 
-        // Find waypoints array
-        size_t waypointsPos = json.find("\"waypoints\":");
-        if (waypointsPos == std::string::npos) return path;
+        OutgoingMessage message;
+        message.json = json + "\n";
+        if (frame.empty()) wire::AppendJson(frame, json);
+        message.frame = std::move(frame);
 
-        size_t arrayStart = json.find('[', waypointsPos);
-        size_t arrayEnd = json.find(']', arrayStart);
-        if (arrayStart == std::string::npos || arrayEnd == std::string::npos) return path;
+        {
+            std::lock_guard<std::mutex> lock(m_outgoingMutex);
+            m_outgoing.push_back(std::move(message));
+        }
+        Wake();
+    }
 
-        std::string waypointsArray = json.substr(arrayStart + 1, arrayEnd - arrayStart - 1);
+    void PathPlannerComm::Enqueue(Client& client, const std::string& bytes, bool droppable) {
+        size_t pending = client.outbox.size() - client.outboxSent;
 
-        // Parse individual waypoints
-        size_t pos = 0;
-        while (pos < waypointsArray.length()) {
-            size_t objStart = waypointsArray.find('{', pos);
-            if (objStart == std::string::npos) break;
+        // A newer pose follows soon, skip this one for a slow client
+        if (droppable && pending > queue_soft_limit) return;
 
-            size_t objEnd = waypointsArray.find('}', objStart);
-            if (objEnd == std::string::npos) break;
+        if (pending + bytes.size() > queue_hard_limit) {
+            LOG_WARN( "[PathPlanner] %s is not reading, closing it", client.address );
+            CloseClient(client);
+            return;
+        }
 
-            std::string waypointJson = waypointsArray.substr(objStart, objEnd - objStart + 1);
+        // Reclaim the sent prefix before it grows the buffer
+        if (client.outboxSent > 0 && client.outboxSent >= client.outbox.size() / 2) {
+            client.outbox.erase(0, client.outboxSent);
+            client.outboxSent = 0;
+        }
 
-            Waypoint wp;
-            wp.x = SimpleJson::GetNumber(waypointJson, "x");
-            wp.y = SimpleJson::GetNumber(waypointJson, "y");
-            wp.heading = SimpleJson::GetNumber(waypointJson, "heading");
-            wp.velocity = SimpleJson::GetNumber(waypointJson, "velocity");
+        client.outbox += bytes;
+    }
+
+    void PathPlannerComm::EnqueuePose(Client& client, const RobotPose& pose) {
+        // Dropped before encoding, a delta must never refer to a skipped pose
+        if (client.outbox.size() - client.outboxSent > queue_soft_limit) return;
 
-            path.waypoints.push_back(wp);
-            pos = objEnd + 1;
+        if (client.binary) {
+            std::string frame;
+            client.poseEncoder.Append(frame, pose);
+            Enqueue(client, frame, false);
+        } else {
+            Enqueue(client, CreatePoseJson(pose) + "\n", false);
         }
+    }
 
-        return path;
+    void PathPlannerComm::EnqueueStatus(Client& client, const std::string& status, bool isMoving) {
+        if (client.binary) {
+            std::string frame;
+            wire::AppendStatus(frame, status, isMoving);
+            Enqueue(client, frame, false);
+        } else {
+            Enqueue(client, CreateStatusJson(status, isMoving) + "\n", false);
+        }
+    }
+
+    void PathPlannerComm::EnqueueTopic(Client& client, Topic topic) {
+        switch (topic) {
+            case Topic::Pose:
+                EnqueuePose(client, m_pose.Load());
+                break;
+
+            case Topic::Status: {
+                // Copied first, Enqueue may close the socket
+                std::string status;
+                bool isMoving;
+                {
+                    std::lock_guard<std::mutex> lock(m_topicMutex);
+                    status = m_status;
+                    isMoving = m_statusMoving;
+                }
+                EnqueueStatus(client, status, isMoving);
+                break;
+            }
+            case Topic::LidarScan: {
+                // The next scan replaces it, dropped for a slow client. Formatted
+                // from the reactor's own slot, the control thread never waits on it.
+                const LidarScan& scan = m_lidarScan.Acquire();
+                std::string bytes;
+                if (client.binary) wire::AppendLidarScan(bytes, scan.ranges, scan.count);
+                else               bytes = CreateLidarScanJson(scan.ranges, scan.count) + "\n";
+                Enqueue(client, bytes, true);
+                break;
+            }
+            case Topic::Odometry: {
+                std::string json = CreateOdometryJson(m_odometry.Load());
+                std::string bytes;
+                if (client.binary) wire::AppendJson(bytes, json);
+                else               bytes = json + "\n";
+                Enqueue(client, bytes, true);
+                break;
+            }
+        }
     }
 
     std::string PathPlannerComm::CreatePoseJson(const RobotPose& pose) {
@@ -461,4 +870,32 @@ namespace PathPlanner {
         return oss.str();
     }
 
+    std::string PathPlannerComm::CreateLidarScanJson(const float* ranges, size_t count) {
+        std::string json = "{\"type\":\"lidarScan\",\"ranges\":[";
+        json.reserve(json.size() + count * 6 + 2);
+
+        char item[24];
+        for (size_t i = 0; i < count; i++) {
+            int n = std::snprintf(item, sizeof(item), "%s%.3f", i ? "," : "", ranges[i]);
+            json.append(item, n);
+        }
+        json += "]}";
+        return json;
+    }
+
+    std::string PathPlannerComm::CreateOdometryJson(const OdometryDiagnostics& odometry) {
+        std::ostringstream oss;
+        oss << "{\"type\":\"odometry\","
+            << "\"x\":" << odometry.x << ","
+            << "\"y\":" << odometry.y << ","
+            << "\"heading\":" << odometry.heading << ","
+            << "\"age\":" << odometry.age << ","
+            << "\"corrections\":" << odometry.corrections << ","
+            << "\"matches\":" << odometry.matches << ","
+            << "\"accepted\":" << odometry.accepted << ","
+            << "\"residual\":" << odometry.residual << ","
+            << "\"inlierRatio\":" << odometry.inlierRatio << "}";
+        return oss.str();
+    }
+
 } // namespace PathPlanner
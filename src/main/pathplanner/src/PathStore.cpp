@@ -0,0 +1,87 @@
+/************************************
+ * PathStore
+ * Paths received from the GUI, indexed by name.
+ *************************************/
+
+#include "PathStore.h"
+#include "PathPlannerComm.h"
+
+namespace PathPlanner {
+
+    PathPtr PathStore::Put(const Path& path) {
+        // The copy is made before locking, readers only wait for the swap
+        std::shared_ptr<Path> snapshot = std::make_shared<Path>(path);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_index.find(snapshot->name);
+        if (it == m_index.end()) {
+            snapshot->version = 1;
+            m_index.emplace(snapshot->name, m_paths.size());
+            m_paths.push_back(snapshot);
+        } else {
+            snapshot->version = m_paths[it->second]->version + 1;
+            m_paths[it->second] = snapshot;
+        }
+
+        m_latest = snapshot;
+        return snapshot;
+    }
+
+    void PathStore::Restore(Path path) {
+        std::shared_ptr<Path> snapshot = std::make_shared<Path>(std::move(path));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_index.find(snapshot->name);
+        if (it == m_index.end()) {
+            m_index.emplace(snapshot->name, m_paths.size());
+            m_paths.push_back(snapshot);
+        } else {
+            m_paths[it->second] = snapshot;
+        }
+    }
+
+    PathPtr PathStore::Find(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(name);
+        return it == m_index.end() ? nullptr : m_paths[it->second];
+    }
+
+    PathPtr PathStore::At(int index) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (index < 0 || index >= static_cast<int>(m_paths.size())) return nullptr;
+        return m_paths[index];
+    }
+
+    PathPtr PathStore::TakeLatest() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PathPtr latest = std::move(m_latest);
+        m_latest.reset();
+        return latest;
+    }
+
+    uint64_t PathStore::Version(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(name);
+        return it == m_index.end() ? 0 : m_paths[it->second]->version;
+    }
+
+    std::vector<PathPtr> PathStore::All() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::vector<PathPtr>(m_paths.begin(), m_paths.end());
+    }
+
+    int PathStore::Count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<int>(m_paths.size());
+    }
+
+    void PathStore::Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paths.clear();
+        m_index.clear();
+        m_latest.reset();
+    }
+
+} // namespace PathPlanner
@@ -0,0 +1,225 @@
+/************************************
+ * WireProtocol
+ * Binary framing between PathPlannerComm and the GUI RobotComm.
+ *************************************/
+
+#include "WireProtocol.h"
+#include "PathPlannerComm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace PathPlanner {
+namespace wire {
+
+    namespace {
+
+        // Explicit little endian, independent of the host
+        void PutU8(std::string& out, uint8_t v) { out += static_cast<char>(v); }
+
+        void PutU16(std::string& out, uint16_t v) {
+            out += static_cast<char>(v & 0xFF);
+            out += static_cast<char>(v >> 8);
+        }
+
+        void PutU32(std::string& out, uint32_t v) {
+            for (int i = 0; i < 4; i++) out += static_cast<char>((v >> (8 * i)) & 0xFF);
+        }
+
+        void PutF32(std::string& out, float f) {
+            uint32_t v;
+            std::memcpy(&v, &f, sizeof(v));
+            PutU32(out, v);
+        }
+
+        uint32_t GetU32(const char* p) {
+            const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+            return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24);
+        }
+
+        uint16_t GetU16(const char* p) {
+            const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+            return static_cast<uint16_t>(b[0] | (b[1] << 8));
+        }
+
+        float GetF32(const char* p) {
+            uint32_t v = GetU32(p);
+            float f;
+            std::memcpy(&f, &v, sizeof(f));
+            return f;
+        }
+
+        // Header with a placeholder size, returns where the payload starts
+        size_t BeginFrame(std::string& out, FrameType type) {
+            PutU8(out, frame_magic);
+            PutU8(out, version);
+            PutU8(out, type);
+            PutU8(out, 0);
+            PutU32(out, 0);
+            return out.size();
+        }
+
+        void EndFrame(std::string& out, size_t payload) {
+            uint32_t size = static_cast<uint32_t>(out.size() - payload);
+            for (int i = 0; i < 4; i++) out[payload - 4 + i] = static_cast<char>((size >> (8 * i)) & 0xFF);
+        }
+
+        constexpr double delta_scale = 1e-4;    // [m] and [rad] per delta unit
+
+        // Quantized delta, false when it does not fit an i16
+        bool Quantize(double delta, int16_t& q) {
+            double v = std::round(delta / delta_scale);
+            if (v < -32767 || v > 32767) return false;
+            q = static_cast<int16_t>(v);
+            return true;
+        }
+    }
+
+    size_t FrameSize(const char* header) {
+        return header_size + GetU32(header + 4);
+    }
+
+    void AppendPose(std::string& out, const RobotPose& pose) {
+        size_t payload = BeginFrame(out, Pose);
+        PutF32(out, static_cast<float>(pose.x));
+        PutF32(out, static_cast<float>(pose.y));
+        PutF32(out, static_cast<float>(pose.heading));
+        EndFrame(out, payload);
+    }
+
+    void AppendStatus(std::string& out, const std::string& status, bool moving) {
+        size_t payload = BeginFrame(out, Status);
+        PutU8(out, moving ? 1 : 0);
+        out.append(3, '\0');
+
+        size_t n = std::min(status.size(), status_size);
+        out.append(status, 0, n);
+        out.append(status_size - n, '\0');
+        EndFrame(out, payload);
+    }
+
+    void AppendExecution(std::string& out, bool finished, bool success) {
+        size_t payload = BeginFrame(out, Execution);
+        PutU8(out, finished ? 1 : 0);
+        PutU8(out, success ? 1 : 0);
+        EndFrame(out, payload);
+    }
+
+    void AppendPath(std::string& out, const PathPlanner::Path& path) {
+        size_t payload = BeginFrame(out, FrameType::Path);
+        size_t name = std::min<size_t>(path.name.size(), 0xFFFF);
+        PutU16(out, static_cast<uint16_t>(name));
+        out.append(path.name, 0, name);
+
+        PutU32(out, static_cast<uint32_t>(path.waypoints.size()));
+        out.reserve(out.size() + path.waypoints.size() * 16);
+        for (const Waypoint& wp : path.waypoints) {
+            PutF32(out, static_cast<float>(wp.x));
+            PutF32(out, static_cast<float>(wp.y));
+            PutF32(out, static_cast<float>(wp.heading));
+            PutF32(out, static_cast<float>(wp.velocity));
+        }
+        EndFrame(out, payload);
+    }
+
+    void AppendGetState(std::string& out) {
+        size_t payload = BeginFrame(out, GetState);
+        EndFrame(out, payload);
+    }
+
+    void AppendJson(std::string& out, const std::string& json) {
+        size_t payload = BeginFrame(out, Json);
+        out += json;
+        EndFrame(out, payload);
+    }
+
+    void AppendLidarScan(std::string& out, const float* ranges, size_t count) {
+        size_t payload = BeginFrame(out, LidarScan);
+        count = std::min<size_t>(count, 0xFFFF);
+        PutU16(out, static_cast<uint16_t>(count));
+        out.reserve(out.size() + count * 2);
+        for (size_t i = 0; i < count; i++) {
+            double mm = std::round(ranges[i] * 1000.0);
+            PutU16(out, static_cast<uint16_t>(std::clamp(mm, 0.0, 65535.0)));
+        }
+        EndFrame(out, payload);
+    }
+
+    bool DecodeFrame(const char* begin, const char* end, IncomingMessage& msg) {
+        msg.Clear();
+
+        if (static_cast<size_t>(end - begin) < header_size || !IsFrame(begin)) return false;
+        if (static_cast<uint8_t>(begin[1]) != version) return false;
+        if (FrameSize(begin) != static_cast<size_t>(end - begin)) return false;
+
+        const char* p = begin + header_size;
+        const size_t size = end - p;
+
+        switch (static_cast<uint8_t>(begin[2])) {
+            case GetState:
+                msg.type = MessageType::GetState;
+                return true;
+
+            case FrameType::Path: {
+                if (size < 6) return false;
+                size_t name = GetU16(p);
+                if (size < 2 + name + 4) return false;
+                msg.path.name.assign(p + 2, name);
+
+                const char* q = p + 2 + name;
+                uint32_t count = GetU32(q);
+                q += 4;
+                if (static_cast<size_t>(end - q) != static_cast<size_t>(count) * 16) return false;
+
+                msg.path.waypoints.resize(count);
+                for (Waypoint& wp : msg.path.waypoints) {
+                    wp.x        = GetF32(q);
+                    wp.y        = GetF32(q + 4);
+                    wp.heading  = GetF32(q + 8);
+                    wp.velocity = GetF32(q + 12);
+                    q += 16;
+                }
+                msg.type = MessageType::SendPath;
+                return true;
+            }
+
+            case Json:
+                return DecodeMessage(p, end, msg);
+
+            default:
+                // Robot to GUI frames, nothing to do with them here
+                return false;
+        }
+    }
+
+    void PoseEncoder::Append(std::string& out, const RobotPose& pose) {
+        int16_t dx, dy, dh;
+        bool delta = m_deltas && m_valid && m_sinceKeyframe < keyframe_interval &&
+                     Quantize(pose.x - m_x, dx) && Quantize(pose.y - m_y, dy) && Quantize(pose.heading - m_heading, dh);
+
+        if (!delta) {
+            AppendPose(out, pose);
+            m_x = static_cast<float>(pose.x);
+            m_y = static_cast<float>(pose.y);
+            m_heading = static_cast<float>(pose.heading);
+            m_valid = true;
+            m_sinceKeyframe = 0;
+            return;
+        }
+
+        size_t payload = BeginFrame(out, PoseDelta);
+        PutU16(out, static_cast<uint16_t>(dx));
+        PutU16(out, static_cast<uint16_t>(dy));
+        PutU16(out, static_cast<uint16_t>(dh));
+        EndFrame(out, payload);
+
+        // Same arithmetic as the client, so quantization never accumulates
+        m_x += dx * delta_scale;
+        m_y += dy * delta_scale;
+        m_heading += dh * delta_scale;
+        m_sinceKeyframe++;
+    }
+
+} // namespace wire
+} // namespace PathPlanner
@@ -0,0 +1,69 @@
+/************************************
+ * LidarSectors
+ * Batch statistics over angular sectors of a 360 beam lidar scan.
+ *
+ * One vectorized pass converts the whole scan to validity weights and
+ * cartesian points (SSE2 / NEON, scalar fallback), then every sector is
+ * reduced from those arrays: min, median and trimmed mean range plus a
+ * total least squares wall fit with outlier rejection.
+ *
+ * Angles are in the lidar beam frame: beam i points at i degrees.
+ *************************************/
+
+#pragma once
+
+#include <cstdint>
+
+struct LidarSector {
+    int first_beam;     // May be negative or >= 360, wraps around
+    int count;          // Number of beams, at most 360
+};
+
+struct SectorStats {
+    int   valid = 0;            // Beams inside the valid range
+    float min = -1;             // [m]
+    float median = -1;          // [m]
+    float trimmed_mean = -1;    // [m] mean of the central 60% of the ranges
+
+    bool  wall_fit = false;     // Enough inliers to fit a line
+    int   inliers = 0;
+    float wall_distance = -1;   // [m] perpendicular distance from the lidar to the wall
+    float wall_angle = 0;       // [deg] wall normal minus sector center direction, 0 = facing the wall squarely
+    float fit_rms = 0;          // [m] residual of the inliers
+};
+
+class LidarSectorKernel
+{
+    public:
+        static constexpr int beams = 360;
+
+        LidarSectorKernel( float min_range_mm = 50, float max_range_mm = 5000 );
+
+        // distance_mm must hold 360 ranges. Not thread safe: uses internal scratch arrays.
+        void Compute( const float * distance_mm, const LidarSector * sectors, int count, SectorStats * out );
+
+        static constexpr int min_fit_points  = 5;
+        static constexpr float trim_fraction = 0.2f;     // Dropped from each end for the trimmed mean
+        static constexpr float outlier_sigma = 3.0f;     // Robust sigmas kept by the wall fit
+        static constexpr float outlier_floor = 0.01f;    // [m] never reject residuals below this
+
+    private:
+        void Prepare( const float * distance_mm );
+        void Reduce( const LidarSector & sector, SectorStats & stats );
+
+        float min_range;
+        float max_range;
+
+        alignas(16) float cos_table[beams];
+        alignas(16) float sin_table[beams];
+
+        // Per scan scratch, invalid beams have zero weight and infinite range
+        alignas(16) float range[beams];
+        alignas(16) float weight[beams];
+        alignas(16) float px[beams];
+        alignas(16) float py[beams];
+
+        float scratch[beams];
+        float residual[beams];
+        int   index[beams];
+};
@@ -2,14 +2,76 @@
 
 #include "Hardware.h"
 #include "Functions.h"
+#include "Scheduler.h"
+#include "SeqLock.h"
+#include "Telemetry.h"
 
 #include <math.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+// Filtered view of one sensor channel, published once per sample
+struct SensorReading {
+    double latest  = 0;
+    double mean    = 0;
+    double median  = 0;
+    uint32_t samples = 0;   // Total samples taken since start
+    int64_t stamp_ns = 0;   // CLOCK_MONOTONIC time of the latest sample
+};
+
+// Ring buffer written by the acquisition thread; readers only touch the snapshot
+template <int N>
+class SensorChannel
+{
+    public:
+        void Push( double value, int64_t stamp_ns ){
+            ring[head] = value;
+            head = ( head + 1 ) % N;
+            if( count < N ){ count++; }
+            total++;
+
+            double sorted[N];
+            double sum = 0;
+            for( int i = 0; i < count; i++ ){ sorted[i] = ring[i]; sum += ring[i]; }
+            std::sort( sorted, sorted + count );
+
+            SensorReading r;
+            r.latest   = value;
+            r.mean     = sum / count;
+            r.median   = ( count % 2 ) ? sorted[count / 2] : ( sorted[count / 2 - 1] + sorted[count / 2] ) / 2.0;
+            r.samples  = total;
+            r.stamp_ns = stamp_ns;
+            snapshot.Store( r );
+        }
+
+        SensorReading Read() const { return snapshot.Load(); }
+
+    private:
+        double ring[N] = {};
+        int head  = 0;
+        int count = 0;
+        uint32_t total = 0;
+
+        SeqLock<SensorReading> snapshot;
+};
+
+// Range sensors looking at the walls, for Sensor::SetRangeCallback()
+enum class RangeChannel { SHARP_RIGHT, SHARP_LEFT, US_RIGHT, US_LEFT };
 
 class Sensor
 {
     public:
         Sensor( Hardware * h ) : hardware{h}{  }
-        ~Sensor(){ }
+        ~Sensor(){ StopAcquisition(); }
+
+        // Samples every channel in the background; getters then return immediately
+        void StartAcquisition();
+        void StopAcquisition();
+        bool IsAcquiring() const { return acquisition.IsRunning(); }
+
+        // Called on the acquisition thread with every new range sample [cm], keep it short
+        void SetRangeCallback( std::function<void( RangeChannel, double, int64_t )> callback );
 
         void Periodic();
 
@@ -30,6 +92,8 @@ class Sensor
         double cobra_cl = 0;
         double cobra_cr = 0;
 
+        static constexpr int window = 5;    // Samples averaged per reading
+
     private:
         Hardware * hardware;
 
@@ -40,4 +104,43 @@ class Sensor
         double us_right_dist = 0;
         double us_left_dist  = 0;
 
+        void SampleAnalog();
+        void SampleUltrasonic();
+        void PublishDashboard();
+        void NotifyRange( RangeChannel channel, double range, int64_t stamp_ns );
+
+        std::function<void( RangeChannel, double, int64_t )> range_callback;
+        std::mutex callback_mutex;
+
+        SensorChannel<window> sharp_right;
+        SensorChannel<window> sharp_left;
+        SensorChannel<window> sharp_arm;
+        SensorChannel<window> us_right;
+        SensorChannel<window> us_left;
+        SensorChannel<window> cobra[4];
+
+        bool acquisition_configured = false;
+        bool ping_right = true;     // Ultrasonic sensors are pinged alternately to avoid cross-talk
+
+        static constexpr double analog_period     = 10;    // [ms]
+        static constexpr double ultrasonic_period = 30;    // [ms] each sensor is pinged every 60 ms
+        static constexpr double dashboard_period  = 100;   // [ms]
+
+        struct Dashboard {
+            telemetry::Number sharp_right_dist = telemetry::AddNumber( "sharp_right_dist" );
+            telemetry::Number sharp_left_dist  = telemetry::AddNumber( "sharp_left_dist" );
+            telemetry::Number sharp_arm_dist   = telemetry::AddNumber( "sharp_arm_dist" );
+            telemetry::Number us_right_dist    = telemetry::AddNumber( "us_right_dist" );
+            telemetry::Number us_left_dist     = telemetry::AddNumber( "us_left_dist" );
+            telemetry::Number cobra_l          = telemetry::AddNumber( "cobra_l" );
+            telemetry::Number cobra_r          = telemetry::AddNumber( "cobra_r" );
+            telemetry::Number cobra_cl         = telemetry::AddNumber( "cobra_cl" );
+            telemetry::Number cobra_cr         = telemetry::AddNumber( "cobra_cr" );
+            telemetry::Number right            = telemetry::AddNumber( "right" );
+            telemetry::Number left             = telemetry::AddNumber( "left" );
+        } dash;
+
+        // Declared last so the thread stops before the channels are destroyed
+        Scheduler acquisition{"sensors"};
+
 };
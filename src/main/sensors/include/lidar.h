@@ -4,29 +4,70 @@
 
 #include <string.h>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
 #include "math.h"
 
 #include "Functions.h"
 #include "Movement.h"
 #include "Sensors.h"
+#include "SeqLock.h"
+#include "TripleBuffer.h"
+#include "LidarSectors.h"
+#include "Telemetry.h"
 
 #include <frc/smartdashboard/SmartDashboard.h>
 
+// Windowed ranges computed once per scan by the ingest thread
+struct LidarRanges {
+    uint64_t generation = 0;    // 0 until the first scan arrives
+    int64_t stamp_ns = 0;
+    double front = -1;          // [m], -1 when no beam of the window is valid
+    double left  = -1;
+    double right = -1;
+
+    double front_wall = -1;     // [m] perpendicular distance to the fitted wall, -1 without a fit
+    double left_wall  = -1;
+    double right_wall = -1;
+
+    double front_angle = 0;     // [deg] wall normal relative to the sensor direction, CCW positive
+    double left_angle  = 0;
+    double right_angle = 0;
+};
+
+struct LidarFrame {
+    studica::Lidar::ScanData scan;
+    LidarRanges ranges;
+};
+
 class Lidar
 {
     public:
         Lidar( Movement * m, Sensor * s ) : move{m}, sensor{s}{}
+        ~Lidar(){ StopIngest(); }
         void Periodic();
         void StartLidar();
         void StopLidar();
         float lidar_mean( double & sensor_dist, int & scan_ang );
         void linear_align( float dist, std::string direction );
+        float setAngle( float angle, std::string direction );
 
         double GetLidarFront( );
         double GetLidarLeft( );
         double GetLidarRight( );
 
-        studica::Lidar::ScanData getScan();
+        // Latest complete scan, read in place. Only one thread may use it,
+        // the reference stays valid until that thread calls it again.
+        const studica::Lidar::ScanData & getScan();
+
+        // Safe from any thread
+        LidarRanges GetRanges() const { return ranges.Load(); }
+        bool WaitScan( uint64_t after_generation, double timeout_ms );
+
+        // Called on the ingest thread for every new scan, keep it short
+        void SetScanCallback( std::function<void( const LidarFrame & )> callback );
 
 
     private:
@@ -35,7 +76,7 @@ class Lidar
         /**
          * kUSB1 = Top USB 2.0 port of VMX
          * kUSB2 = Bottom USB 2.0 port of VMX
-         */ 
+         */
         studica::Lidar lidar{studica::Lidar::Port::kUSB1};
         // Scan data struct
         studica::Lidar::ScanData scanData;
@@ -52,4 +93,41 @@ class Lidar
         int right_ang_ = 360;
         int front_ang_ = 270;
 
-};
\ No newline at end of file
+        // Scan ingest pipeline
+        void StartIngest();
+        void StopIngest();
+        void IngestLoop();
+        void ComputeRanges( const studica::Lidar::ScanData & scan, LidarRanges & r );
+        void ObserveWalls( const LidarRanges & r );     // Wall fits to the odometry filter
+
+        TripleBuffer<LidarFrame> frames;
+        SeqLock<LidarRanges> ranges;
+        studica::Lidar::ScanData last_scan;     // Ingest thread only, to detect a new revolution
+        LidarSectorKernel sector_kernel;        // Ingest thread only
+        std::thread ingest_thread;
+        std::atomic<bool> ingesting{false};
+        uint64_t generation = 0;
+
+        std::function<void( const LidarFrame & )> scan_callback;
+        std::mutex callback_mutex;
+
+        static constexpr int    scan_beams      = 360;
+        static constexpr int    range_window    = 3;      // Beams on each side of the center beam
+        static constexpr int    wall_window     = 15;     // Beams on each side used for the wall fit
+        static constexpr double ingest_period   = 10;     // [ms] driver polling period
+        static constexpr double scan_timeout    = 500;    // [ms]
+        static constexpr int    max_empty_scans = 5;      // Scans without a valid window before giving up
+        static constexpr double wall_sigma      = 1.5;    // [cm] wall fit distance noise, for the odometry filter
+        static constexpr double angle_sigma     = 1.5;    // [deg] wall fit angle noise
+
+        struct Dashboard {
+            telemetry::String process        = telemetry::AddString( "Process" );
+            telemetry::Number angle_left     = telemetry::AddNumber( "Angle Left" );
+            telemetry::Number distance_left  = telemetry::AddNumber( "Distance Left" );
+            telemetry::Number angle_right    = telemetry::AddNumber( "Angle Right" );
+            telemetry::Number distance_right = telemetry::AddNumber( "Distance Right" );
+            telemetry::Number angle_front    = telemetry::AddNumber( "Angle Front" );
+            telemetry::Number distance_front = telemetry::AddNumber( "Distance Front" );
+        } dash;
+
+};
@@ -0,0 +1,270 @@
+/************************************
+ * LidarSectors
+ * Batch statistics over angular sectors of a 360 beam lidar scan.
+ *************************************/
+
+#include "LidarSectors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define LIDAR_SECTORS_NEON 1
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define LIDAR_SECTORS_SSE 1
+#endif
+
+namespace {
+
+    struct Sums {
+        float n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+        float min = std::numeric_limits<float>::infinity();
+    };
+
+    // Beams [begin, end) of the prepared arrays, begin/end inside [0, 360]
+    void Accumulate( const float * range, const float * weight, const float * px, const float * py,
+                     int begin, int end, Sums & s ){
+        int i = begin;
+
+#if defined(LIDAR_SECTORS_SSE)
+        __m128 n = _mm_setzero_ps(), sx = n, sy = n, sxx = n, sxy = n, syy = n;
+        __m128 mn = _mm_set1_ps( s.min );
+        for( ; i + 4 <= end; i += 4 ){
+            __m128 x = _mm_loadu_ps( px + i );
+            __m128 y = _mm_loadu_ps( py + i );
+            n   = _mm_add_ps( n,   _mm_loadu_ps( weight + i ) );
+            sx  = _mm_add_ps( sx,  x );
+            sy  = _mm_add_ps( sy,  y );
+            sxx = _mm_add_ps( sxx, _mm_mul_ps( x, x ) );
+            sxy = _mm_add_ps( sxy, _mm_mul_ps( x, y ) );
+            syy = _mm_add_ps( syy, _mm_mul_ps( y, y ) );
+            mn  = _mm_min_ps( mn,  _mm_loadu_ps( range + i ) );
+        }
+        alignas(16) float lanes[7][4];
+        _mm_store_ps( lanes[0], n );   _mm_store_ps( lanes[1], sx );  _mm_store_ps( lanes[2], sy );
+        _mm_store_ps( lanes[3], sxx ); _mm_store_ps( lanes[4], sxy ); _mm_store_ps( lanes[5], syy );
+        _mm_store_ps( lanes[6], mn );
+        for( int k = 0; k < 4; k++ ){
+            s.n += lanes[0][k]; s.sx += lanes[1][k]; s.sy += lanes[2][k];
+            s.sxx += lanes[3][k]; s.sxy += lanes[4][k]; s.syy += lanes[5][k];
+            s.min = std::min( s.min, lanes[6][k] );
+        }
+#elif defined(LIDAR_SECTORS_NEON)
+        float32x4_t n = vdupq_n_f32( 0 ), sx = n, sy = n, sxx = n, sxy = n, syy = n;
+        float32x4_t mn = vdupq_n_f32( s.min );
+        for( ; i + 4 <= end; i += 4 ){
+            float32x4_t x = vld1q_f32( px + i );
+            float32x4_t y = vld1q_f32( py + i );
+            n   = vaddq_f32( n,   vld1q_f32( weight + i ) );
+            sx  = vaddq_f32( sx,  x );
+            sy  = vaddq_f32( sy,  y );
+            sxx = vmlaq_f32( sxx, x, x );
+            sxy = vmlaq_f32( sxy, x, y );
+            syy = vmlaq_f32( syy, y, y );
+            mn  = vminq_f32( mn,  vld1q_f32( range + i ) );
+        }
+        float lanes[7][4];
+        vst1q_f32( lanes[0], n );   vst1q_f32( lanes[1], sx );  vst1q_f32( lanes[2], sy );
+        vst1q_f32( lanes[3], sxx ); vst1q_f32( lanes[4], sxy ); vst1q_f32( lanes[5], syy );
+        vst1q_f32( lanes[6], mn );
+        for( int k = 0; k < 4; k++ ){
+            s.n += lanes[0][k]; s.sx += lanes[1][k]; s.sy += lanes[2][k];
+            s.sxx += lanes[3][k]; s.sxy += lanes[4][k]; s.syy += lanes[5][k];
+            s.min = std::min( s.min, lanes[6][k] );
+        }
+#endif
+
+        for( ; i < end; i++ ){
+            s.n   += weight[i];
+            s.sx  += px[i];
+            s.sy  += py[i];
+            s.sxx += px[i] * px[i];
+            s.sxy += px[i] * py[i];
+            s.syy += py[i] * py[i];
+            s.min  = std::min( s.min, range[i] );
+        }
+    }
+
+    // Total least squares line x*cos(a) + y*sin(a) = rho, with rho >= 0
+    void FitLine( const Sums & s, float & alpha, float & rho ){
+        float mx = s.sx / s.n;
+        float my = s.sy / s.n;
+        float cxx = s.sxx / s.n - mx * mx;
+        float cyy = s.syy / s.n - my * my;
+        float cxy = s.sxy / s.n - mx * my;
+
+        alpha = 0.5f * std::atan2( -2.0f * cxy, cyy - cxx );
+        rho   = mx * std::cos( alpha ) + my * std::sin( alpha );
+
+        if( rho < 0 ){
+            rho   = -rho;
+            alpha = alpha + static_cast<float>( M_PI );
+        }
+    }
+
+    float WrapDegrees( float ang ){
+        while( ang >  180 ){ ang -= 360; }
+        while( ang < -180 ){ ang += 360; }
+        return ang;
+    }
+}
+
+LidarSectorKernel::LidarSectorKernel( float min_range_mm, float max_range_mm )
+    : min_range{min_range_mm}, max_range{max_range_mm} {
+
+    for( int i = 0; i < beams; i++ ){
+        cos_table[i] = std::cos( i * M_PI / 180.0 );
+        sin_table[i] = std::sin( i * M_PI / 180.0 );
+    }
+}
+
+void LidarSectorKernel::Compute( const float * distance_mm, const LidarSector * sectors, int count, SectorStats * out ){
+    Prepare( distance_mm );
+
+    for( int i = 0; i < count; i++ ){
+        Reduce( sectors[i], out[i] );
+    }
+}
+
+void LidarSectorKernel::Prepare( const float * distance_mm ){
+
+    const float inf = std::numeric_limits<float>::infinity();
+    int i = 0;
+
+#if defined(LIDAR_SECTORS_SSE)
+    const __m128 vmin  = _mm_set1_ps( min_range );
+    const __m128 vmax  = _mm_set1_ps( max_range );
+    const __m128 scale = _mm_set1_ps( 0.001f );
+    const __m128 one   = _mm_set1_ps( 1.0f );
+    const __m128 vinf  = _mm_set1_ps( inf );
+
+    for( ; i + 4 <= beams; i += 4 ){
+        __m128 d     = _mm_loadu_ps( distance_mm + i );
+        __m128 valid = _mm_and_ps( _mm_cmpgt_ps( d, vmin ), _mm_cmplt_ps( d, vmax ) );
+        __m128 r     = _mm_and_ps( valid, _mm_mul_ps( d, scale ) );
+
+        _mm_store_ps( range  + i, _mm_or_ps( r, _mm_andnot_ps( valid, vinf ) ) );
+        _mm_store_ps( weight + i, _mm_and_ps( valid, one ) );
+        _mm_store_ps( px     + i, _mm_mul_ps( r, _mm_load_ps( cos_table + i ) ) );
+        _mm_store_ps( py     + i, _mm_mul_ps( r, _mm_load_ps( sin_table + i ) ) );
+    }
+#elif defined(LIDAR_SECTORS_NEON)
+    const float32x4_t vmin  = vdupq_n_f32( min_range );
+    const float32x4_t vmax  = vdupq_n_f32( max_range );
+    const float32x4_t scale = vdupq_n_f32( 0.001f );
+    const float32x4_t one   = vdupq_n_f32( 1.0f );
+    const float32x4_t zero  = vdupq_n_f32( 0.0f );
+    const float32x4_t vinf  = vdupq_n_f32( inf );
+
+    for( ; i + 4 <= beams; i += 4 ){
+        float32x4_t d     = vld1q_f32( distance_mm + i );
+        uint32x4_t  valid = vandq_u32( vcgtq_f32( d, vmin ), vcltq_f32( d, vmax ) );
+        float32x4_t r     = vbslq_f32( valid, vmulq_f32( d, scale ), zero );
+
+        vst1q_f32( range  + i, vbslq_f32( valid, r, vinf ) );
+        vst1q_f32( weight + i, vbslq_f32( valid, one, zero ) );
+        vst1q_f32( px     + i, vmulq_f32( r, vld1q_f32( cos_table + i ) ) );
+        vst1q_f32( py     + i, vmulq_f32( r, vld1q_f32( sin_table + i ) ) );
+    }
+#endif
+
+    for( ; i < beams; i++ ){
+        float d = distance_mm[i];
+        bool valid = d > min_range && d < max_range;
+        float r = valid ? d * 0.001f : 0.0f;
+
+        range[i]  = valid ? r : inf;
+        weight[i] = valid ? 1.0f : 0.0f;
+        px[i]     = r * cos_table[i];
+        py[i]     = r * sin_table[i];
+    }
+}
+
+void LidarSectorKernel::Reduce( const LidarSector & sector, SectorStats & stats ){
+
+    stats = SectorStats();
+
+    int count = std::min( std::max( sector.count, 0 ), beams );
+    int first = ( ( sector.first_beam % beams ) + beams ) % beams;
+
+    // A sector crossing beam 359 -> 0 is reduced as two contiguous spans
+    int spans[2][2] = { { first, std::min( first + count, beams ) }, { 0, std::max( first + count - beams, 0 ) } };
+
+    Sums sums;
+    int valid = 0;
+    for( auto & span : spans ){
+        Accumulate( range, weight, px, py, span[0], span[1], sums );
+        for( int i = span[0]; i < span[1]; i++ ){
+            if( weight[i] > 0 ){
+                scratch[valid] = range[i];
+                index[valid]   = i;
+                valid++;
+            }
+        }
+    }
+
+    stats.valid = valid;
+    if( valid == 0 ){ return; }
+
+    stats.min = sums.min;
+
+    std::sort( scratch, scratch + valid );
+    stats.median = ( valid % 2 ) ? scratch[valid / 2] : 0.5f * ( scratch[valid / 2 - 1] + scratch[valid / 2] );
+
+    int trim = static_cast<int>( valid * trim_fraction );
+    float sum = 0;
+    for( int i = trim; i < valid - trim; i++ ){ sum += scratch[i]; }
+    stats.trimmed_mean = sum / ( valid - 2 * trim );
+
+    if( valid < min_fit_points ){ return; }
+
+    // First fit on every valid beam, then refit on the inliers only
+    float alpha, rho;
+    FitLine( sums, alpha, rho );
+
+    float ca = std::cos( alpha ), sa = std::sin( alpha );
+    for( int k = 0; k < valid; k++ ){
+        int i = index[k];
+        residual[k] = std::fabs( px[i] * ca + py[i] * sa - rho );
+        scratch[k]  = residual[k];
+    }
+    std::nth_element( scratch, scratch + valid / 2, scratch + valid );
+    float sigma = 1.4826f * scratch[valid / 2];
+    float threshold = std::max( outlier_sigma * sigma, outlier_floor );
+
+    Sums inlier_sums;
+    for( int k = 0; k < valid; k++ ){
+        if( residual[k] > threshold ){ continue; }
+        int i = index[k];
+        inlier_sums.n   += 1;
+        inlier_sums.sx  += px[i];
+        inlier_sums.sy  += py[i];
+        inlier_sums.sxx += px[i] * px[i];
+        inlier_sums.sxy += px[i] * py[i];
+        inlier_sums.syy += py[i] * py[i];
+    }
+
+    stats.inliers = static_cast<int>( inlier_sums.n );
+    if( stats.inliers < min_fit_points ){ return; }
+
+    FitLine( inlier_sums, alpha, rho );
+
+    ca = std::cos( alpha ); sa = std::sin( alpha );
+    float sq = 0;
+    for( int k = 0; k < valid; k++ ){
+        if( residual[k] > threshold ){ continue; }
+        int i = index[k];
+        float e = px[i] * ca + py[i] * sa - rho;
+        sq += e * e;
+    }
+
+    float center = first + ( count - 1 ) / 2.0f;
+
+    stats.wall_fit      = true;
+    stats.wall_distance = rho;
+    stats.wall_angle    = WrapDegrees( alpha * 180.0f / static_cast<float>( M_PI ) - center );
+    stats.fit_rms       = std::sqrt( sq / stats.inliers );
+}
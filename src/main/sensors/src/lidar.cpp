@@ -1,7 +1,17 @@
 #include "lidar.h"
+#include "Log.h"
+#include "LoopMetrics.h"
+
+#include <algorithm>
+#include <chrono>
 
 #define DEBUG true
 
+namespace {
+    metrics::Loop ingest_loop( "lidar_ingest" );
+    metrics::Loop align_loop ( "linear_align" );
+}
+
 void Lidar::StartLidar()
 {
     
@@ -10,35 +20,48 @@ void Lidar::StartLidar()
     lidar.ClusterConfig(50.0f, 5);
     lidar.EnableFilter(studica::Lidar::Filter::kCLUSTER, true);
 
+    StartIngest();
+
     lidar_mean( right_scan, right_ang );
     lidar_mean( left_scan, left_ang );
     lidar_mean( front_scan, front_ang );
 
+    const studica::Lidar::ScanData & scan = getScan();
     for( int i = 0; i < 360; i++){
-        std::cout << "angle: " << scanData.angle[i] << " dist: " <<  scanData.distance[i] << std::endl;
+        LOG_DEBUG( "angle: %g dist: %g", scan.angle[i], scan.distance[i] );
     }
 
 }
 
 void Lidar::StopLidar()
 {
+    StopIngest();
     lidar.Stop();
     lidarRunning = false;
 }
 
 void Lidar::Periodic()
 {
+    if (ingesting) {
+        // Ranges are already computed by the ingest thread, nothing to copy
+        LidarRanges r = ranges.Load();
+        left_scan  = r.left;
+        right_scan = r.right;
+        front_scan = r.front;
+        return;
+    }
+
     if (lidarRunning)
         scanData = lidar.GetData(); // Update scanData struct
 
     #if DEBUG //Print out sensor info
 
-        frc::SmartDashboard::PutNumber("Angle Left",        left_ang   );
-        frc::SmartDashboard::PutNumber("Distance Left",     left_scan  );
-        frc::SmartDashboard::PutNumber("Angle Right",       right_ang  );
-        frc::SmartDashboard::PutNumber("Distance Right",    right_scan );
-        frc::SmartDashboard::PutNumber("Angle Front",       front_ang  );
-        frc::SmartDashboard::PutNumber("Distance Front",    front_scan );
+        telemetry::Set( dash.angle_left, left_ang );
+        telemetry::Set( dash.distance_left, left_scan );
+        telemetry::Set( dash.angle_right, right_ang );
+        telemetry::Set( dash.distance_right, right_scan );
+        telemetry::Set( dash.angle_front, front_ang );
+        telemetry::Set( dash.distance_front, front_scan );
 
     #endif
 
@@ -47,16 +70,160 @@ void Lidar::Periodic()
     front_scan = scanData.distance[front_ang] / 1000.0;
 }
 
-studica::Lidar::ScanData Lidar::getScan(){
-    return lidar.GetData();
+const studica::Lidar::ScanData & Lidar::getScan(){
+    if( ingesting ){ return frames.Acquire().scan; }
+
+    scanData = lidar.GetData();
+    return scanData;
+}
+
+void Lidar::StartIngest(){
+    if( ingesting ){ return; }
+
+    ingesting = true;
+    ingest_thread = std::thread( &Lidar::IngestLoop, this );
+}
+
+void Lidar::StopIngest(){
+    if( !ingesting ){ return; }
+
+    ingesting = false;
+    if( ingest_thread.joinable() ){ ingest_thread.join(); }
+}
+
+void Lidar::IngestLoop(){
+
+    Rate rate( ingest_period, &ingest_loop );
+
+    while( ingesting ){
+
+        LidarFrame & frame = frames.WriteBuffer();
+        frame.scan = lidar.GetData();
+
+        // The driver hands back the same scan until the next revolution completes,
+        // only publish when the ranges actually changed
+        const LidarRanges last = ranges.Load();
+        if( last.generation == 0 || memcmp( frame.scan.distance, last_scan.distance, sizeof(last_scan.distance) ) != 0 ){
+
+            memcpy( last_scan.distance, frame.scan.distance, sizeof(last_scan.distance) );
+
+            LidarRanges r;
+            r.generation = ++generation;
+            r.stamp_ns   = timing::NowNs();
+            ComputeRanges( frame.scan, r );
+
+            frame.ranges = r;
+            frames.Publish();
+            ranges.Store( r );
+            ObserveWalls( r );
+
+            // The published buffer is not written again before the next Publish()
+            std::lock_guard<std::mutex> lock( callback_mutex );
+            if( scan_callback ){ scan_callback( frame ); }
+        }
+
+        rate.Sleep();
+    }
+}
+
+void Lidar::SetScanCallback( std::function<void( const LidarFrame & )> callback ){
+    std::lock_guard<std::mutex> lock( callback_mutex );
+    scan_callback = callback;
+}
+
+void Lidar::ComputeRanges( const studica::Lidar::ScanData & scan, LidarRanges & r ){
+
+    // Narrow sectors give the range along each direction, wide ones the wall fit
+    const LidarSector sectors[6] = {
+        { front_ang_ - range_window, 2 * range_window + 1 },
+        { left_ang_  - range_window, 2 * range_window + 1 },
+        { right_ang_ - range_window, 2 * range_window + 1 },
+        { front_ang_ - wall_window,  2 * wall_window  + 1 },
+        { left_ang_  - wall_window,  2 * wall_window  + 1 },
+        { right_ang_ - wall_window,  2 * wall_window  + 1 },
+    };
+    SectorStats stats[6];
+
+    sector_kernel.Compute( scan.distance, sectors, 6, stats );
+
+    r.front = stats[0].median;
+    r.left  = stats[1].median;
+    r.right = stats[2].median;
+
+    // Beam indices grow clockwise seen from the robot, so angles flip sign
+    r.front_wall  = stats[3].wall_fit ? stats[3].wall_distance : -1;
+    r.left_wall   = stats[4].wall_fit ? stats[4].wall_distance : -1;
+    r.right_wall  = stats[5].wall_fit ? stats[5].wall_distance : -1;
+    r.front_angle = -stats[3].wall_angle;
+    r.left_angle  = -stats[4].wall_angle;
+    r.right_angle = -stats[5].wall_angle;
+}
+
+void Lidar::ObserveWalls( const LidarRanges & r ){
+
+    // Sensor axes on the robot frame, the wall fits are perpendicular distances along them
+    const double wall[3]  = { r.front_wall,  r.left_wall,  r.right_wall };
+    const double angle[3] = { r.front_angle, r.left_angle, r.right_angle };
+    const double axis[3]  = { 0, 90, -90 };
+
+    for( int i = 0; i < 3; i++ ){
+        if( wall[i] <= 0 ){ continue; }
+
+        RangeObservation o;
+        o.mount    = { constant::LIDAR_OFFSET_X, constant::LIDAR_OFFSET_Y, axis[i] };
+        o.stamp_ns = r.stamp_ns;
+
+        o.kind  = RangeObservation::WALL;
+        o.value = wall[i] * 100;
+        o.sigma = wall_sigma;
+        move->ObserveRange( o );
+
+        o.kind  = RangeObservation::HEADING;
+        o.value = angle[i];
+        o.sigma = angle_sigma;
+        move->ObserveRange( o );
+    }
+}
+
+float Lidar::setAngle( float angle, std::string direction ){
+
+    // Same estimate as Sensor::setAngle, with the wall angle fitted on the last scan
+    WaitScan( ranges.Load().generation, scan_timeout );
+    LidarRanges r = ranges.Load();
+
+    double angle_diff = 0;
+    bool fit = false;
+    if     ( direction.compare( "front" ) == 0 ){ angle_diff = r.front_angle; fit = r.front_wall > 0; }
+    else if( direction.compare( "left" )  == 0 ){ angle_diff = r.left_angle;  fit = r.left_wall  > 0; }
+    else if( direction.compare( "right" ) == 0 ){ angle_diff = r.right_angle; fit = r.right_wall > 0; }
+
+    if( !fit ){
+        LOG_WARN( "Lidar setAngle: no wall fit on the %s", direction );
+        return angle;
+    }
+
+    float estimated_angle_degrees = straight_ang( angle ) - angle_diff;
+    estimated_angle_degrees = Quotient_Remainder( estimated_angle_degrees, 360 );
+
+    return estimated_angle_degrees;
+}
+
+bool Lidar::WaitScan( uint64_t after_generation, double timeout_ms ){
+    int64_t deadline = timing::NowNs() + static_cast<int64_t>( timeout_ms * 1e6 );
+
+    while( ranges.Load().generation <= after_generation ){
+        if( !ingesting || timing::NowNs() > deadline ){ return false; }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+    }
+    return true;
 }
 
 
 void Lidar::linear_align( float dist, std::string direction ){
 
-    frc::SmartDashboard::PutString("Process",  "Linear Align" );
+    telemetry::Set( dash.process, "Linear Align" );
 
-    std::cout << "Starting Sensor Alignment " << direction << std::endl;
+    LOG_INFO( "Starting Sensor Alignment %s", direction );
     
     float sensor_dist = 0;
     int count = 0;
@@ -113,6 +280,8 @@ void Lidar::linear_align( float dist, std::string direction ){
     }
     Twist cmd;
 
+    Rate rate( 20, &align_loop );
+
     while( count < 5 ){
 
         Periodic();
@@ -185,13 +354,13 @@ void Lidar::linear_align( float dist, std::string direction ){
         cmd.angular.z  = desired_vth;
 
         // std::cout << "vx: " << cmd.linear.x << " vy: " << cmd.linear.y << " vth: " << cmd.angular.z << " dist: " << sensor_dist << " th_diff: " << th_diff << std::endl;
-        std::cout << "des_ang: " << des_ang << " get_th(): " << move->get_th() << std::endl;
+        LOG_INFO_EVERY( 250, "des_ang: %g get_th(): %g", des_ang, move->get_th() );
 
         move->cmd_drive( cmd.linear.x, cmd.linear.y, cmd.angular.z );
 
         prev_speed = desired_vth;
 
-        delay(20);
+        rate.Sleep();
     }
 
     move->cmd_drive(0,0,0);
@@ -200,6 +369,20 @@ void Lidar::linear_align( float dist, std::string direction ){
 }
 
 float Lidar::lidar_mean( double & sensor_dist, int & scan_ang ){
+
+    if( ingesting ){
+        // Each scan already carries a windowed median, so one fresh scan is enough
+        uint64_t last = ranges.Load().generation;
+        for( int i = 0; i < max_empty_scans; i++ ){
+            if( !WaitScan( last, scan_timeout ) ){ break; }
+            last = ranges.Load().generation;
+
+            Periodic();
+            if( sensor_dist > 0 && sensor_dist < 5 ){ return sensor_dist; }
+        }
+        LOG_WARN( "Lidar mean is -1" );
+        return -1;
+    }
    
     const int n_samples = 3;
 
@@ -250,7 +433,7 @@ float Lidar::lidar_mean( double & sensor_dist, int & scan_ang ){
         dist = -1;
     }
 
-    std::cout << "Lidar mean is " << dist << std::endl;
+    LOG_INFO( "Lidar mean is %g", dist );
 
     return dist;
 }
@@ -1,6 +1,94 @@
 #include "Sensors.h"
 
+void Sensor::StartAcquisition(){
+    if( acquisition.IsRunning() ){ return; }
+
+    if( !acquisition_configured ){
+        acquisition.AddTask( "analog",     analog_period,     [this]{ SampleAnalog();     } );
+        acquisition.AddTask( "ultrasonic", ultrasonic_period, [this]{ SampleUltrasonic(); } );
+        acquisition.AddTask( "dashboard",  dashboard_period,  [this]{ PublishDashboard(); } );
+        acquisition_configured = true;
+    }
+
+    acquisition.Start();
+}
+
+void Sensor::StopAcquisition(){
+    acquisition.Stop();
+}
+
+void Sensor::SetRangeCallback( std::function<void( RangeChannel, double, int64_t )> callback ){
+    std::lock_guard<std::mutex> lock( callback_mutex );
+    range_callback = callback;
+}
+
+void Sensor::NotifyRange( RangeChannel channel, double range, int64_t stamp_ns ){
+    std::lock_guard<std::mutex> lock( callback_mutex );
+    if( range_callback ){ range_callback( channel, range, stamp_ns ); }
+}
+
+void Sensor::SampleAnalog(){
+    int64_t now = timing::NowNs();
+
+    const double right = hardware->GetRightSharp();
+    const double left  = hardware->GetLeftSharp();
+
+    sharp_right.Push( right, now );
+    sharp_left.Push ( left,  now );
+    sharp_arm.Push  ( hardware->GetArmSharp(),   now );
+
+    for( int i = 0; i < 4; i++ ){
+        cobra[i].Push( hardware->GetCobra(i), now );
+    }
+
+    NotifyRange( RangeChannel::SHARP_RIGHT, right, now );
+    NotifyRange( RangeChannel::SHARP_LEFT,  left,  now );
+}
+
+void Sensor::SampleUltrasonic(){
+    const int64_t now = timing::NowNs();
+    const double range = ping_right ? hardware->GetRightUS() : hardware->GetLeftUS();
+
+    if( ping_right ){ us_right.Push( range, now ); }
+    else            { us_left.Push ( range, now ); }
+
+    NotifyRange( ping_right ? RangeChannel::US_RIGHT : RangeChannel::US_LEFT, range, now );
+
+    ping_right = !ping_right;
+}
+
+void Sensor::PublishDashboard(){
+    telemetry::Set( dash.sharp_right_dist, sharp_right.Read().latest );
+    telemetry::Set( dash.sharp_left_dist, sharp_left.Read().latest );
+    telemetry::Set( dash.sharp_arm_dist, sharp_arm.Read().latest );
+
+    telemetry::Set( dash.us_right_dist, us_right.Read().latest );
+    telemetry::Set( dash.us_left_dist, us_left.Read().latest );
+
+    telemetry::Set( dash.cobra_l, cobra[0].Read().latest );
+    telemetry::Set( dash.cobra_r, cobra[3].Read().latest );
+    telemetry::Set( dash.cobra_cl, cobra[1].Read().latest );
+    telemetry::Set( dash.cobra_cr, cobra[2].Read().latest );
+}
+
 void Sensor::Periodic(){
+
+    if( acquisition.IsRunning() ){
+        // Latest values from the acquisition thread, no sensor I/O here
+        sharp_right_dist = sharp_right.Read().latest;
+        sharp_left_dist  = sharp_left.Read().latest;
+        sharp_arm_dist   = sharp_arm.Read().latest;
+
+        us_right_dist = us_right.Read().latest;
+        us_left_dist  = us_left.Read().latest;
+
+        cobra_l  = cobra[0].Read().latest > 2.5;
+        cobra_r  = cobra[3].Read().latest > 2.5;
+        cobra_cl = cobra[1].Read().latest > 2.5;
+        cobra_cr = cobra[2].Read().latest > 2.5;
+        return;
+    }
+
     sharp_right_dist = hardware->GetRightSharp();
     sharp_left_dist  = hardware->GetLeftSharp();
     sharp_arm_dist   = hardware->GetArmSharp();
@@ -13,38 +101,43 @@ void Sensor::Periodic(){
     cobra_cl = hardware->GetCobra(1) > 2.5;
     cobra_cr = hardware->GetCobra(2) > 2.5;
 
-    frc::SmartDashboard::PutNumber("sharp_right_dist", sharp_right_dist );
-    frc::SmartDashboard::PutNumber("sharp_left_dist", sharp_left_dist );
-    frc::SmartDashboard::PutNumber("sharp_arm_dist", sharp_arm_dist );
+    telemetry::Set( dash.sharp_right_dist, sharp_right_dist );
+    telemetry::Set( dash.sharp_left_dist, sharp_left_dist );
+    telemetry::Set( dash.sharp_arm_dist, sharp_arm_dist );
 
-    frc::SmartDashboard::PutNumber("us_right_dist", us_right_dist );
-    frc::SmartDashboard::PutNumber("us_left_dist", us_left_dist );
+    telemetry::Set( dash.us_right_dist, us_right_dist );
+    telemetry::Set( dash.us_left_dist, us_left_dist );
 
-    frc::SmartDashboard::PutNumber("cobra_l",  hardware->GetCobra(0) );
-    frc::SmartDashboard::PutNumber("cobra_r",  hardware->GetCobra(3) );
-    frc::SmartDashboard::PutNumber("cobra_cl", hardware->GetCobra(1) );
-    frc::SmartDashboard::PutNumber("cobra_cr", hardware->GetCobra(2) ); 
+    telemetry::Set( dash.cobra_l, hardware->GetCobra(0) );
+    telemetry::Set( dash.cobra_r, hardware->GetCobra(3) );
+    telemetry::Set( dash.cobra_cl, hardware->GetCobra(1) );
+    telemetry::Set( dash.cobra_cr, hardware->GetCobra(2) );
 
 }
 
 
 
 double Sensor::GetRightSharp(){
-    return sensor_mean( sharp_right_dist, 5 );
+    if( acquisition.IsRunning() ){ return sharp_right.Read().mean; }
+    return sensor_mean( sharp_right_dist, window );
 }
 
 double Sensor::GetLeftSharp(){
-    return sensor_mean( sharp_left_dist, 5 );
+    if( acquisition.IsRunning() ){ return sharp_left.Read().mean; }
+    return sensor_mean( sharp_left_dist, window );
 }
 
 double Sensor::GetArmSharp(){
-    return sensor_mean( sharp_arm_dist, 5 );
+    if( acquisition.IsRunning() ){ return sharp_arm.Read().mean; }
+    return sensor_mean( sharp_arm_dist, window );
 }
 double Sensor::GetRightUS(){
-    return sensor_mean( us_right_dist, 5 );
+    if( acquisition.IsRunning() ){ return us_right.Read().mean; }
+    return sensor_mean( us_right_dist, window );
 }
 double Sensor::GetLeftUS(){
-    return sensor_mean( us_left_dist, 5 );
+    if( acquisition.IsRunning() ){ return us_left.Read().mean; }
+    return sensor_mean( us_left_dist, window );
 }
 
 float Sensor::sensor_mean( double & sensor_dist, int samples ){
@@ -73,11 +166,17 @@ float Sensor::get_angle_wall( int sample ){
 
     float baseline_distance = 20;
 
-    float right = sensor_mean(us_right_dist, sample);
-    float left  = sensor_mean(us_left_dist,  sample);
+    float right, left;
+    if( acquisition.IsRunning() ){
+        right = us_right.Read().mean;
+        left  = us_left.Read().mean;
+    }else{
+        right = sensor_mean(us_right_dist, sample);
+        left  = sensor_mean(us_left_dist,  sample);
+    }
 
-    frc::SmartDashboard::PutNumber("right", right );
-    frc::SmartDashboard::PutNumber("left", left );
+    telemetry::Set( dash.right, right );
+    telemetry::Set( dash.left, left );
 
     float sensor_difference = right - left;
     float angle_diff = atan(sensor_difference / baseline_distance);
@@ -108,4 +207,3 @@ float Sensor::setAngle( float angle ){
 
     return estimated_angle_degrees;
 }
-
@@ -0,0 +1,61 @@
+/************************************
+ * SimClock
+ * Virtual time for the simulation, installed with timing::SetClock().
+ *
+ * The driver thread (the one that built the clock, normally the mission)
+ * moves time forward: each of its sleeps steps the model up to the
+ * deadline and returns immediately, so a 20 ms control period costs only
+ * the computation. Other threads (sensor acquisition, telemetry) block
+ * until the virtual time reaches their deadline. When the driver itself
+ * is blocked for idle_timeout real ms, e.g. joining one of those threads,
+ * the sleeping thread moves time instead.
+ *************************************/
+
+#pragma once
+
+#include "Scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class SimClock : public timing::Clock
+{
+    public:
+        // step advances the model by dt [s], called at most every step_ms of virtual time
+        SimClock( std::function<void( double dt )> step, double step_ms = 1 );
+
+        int64_t NowNs() override { return now_ns; }
+        void SleepUntilNs( int64_t deadline_ns ) override;
+
+        // Virtual seconds per real second, 0 runs as fast as possible
+        void SetRealTimeFactor( double factor ){ real_time_factor = factor; }
+        // Virtual seconds run per real second since the clock was built
+        double GetSpeedup() const;
+
+        // Moves the driver role to the calling thread
+        void TakeDriver(){ driver = std::this_thread::get_id(); }
+
+        static constexpr int idle_timeout = 5;     // [ms] real
+
+    private:
+        void Advance( int64_t deadline_ns );
+
+        std::function<void( double )> step;
+        const int64_t step_ns;
+
+        std::atomic<int64_t> now_ns{ 0 };
+        std::atomic<std::thread::id> driver;
+        std::atomic<double> real_time_factor{ 0 };
+
+        const int64_t start_ns;                                 // Virtual
+        const std::chrono::steady_clock::time_point start_real;
+
+        std::mutex advance_mutex;           // One thread steps the model at a time
+        std::mutex wait_mutex;
+        std::condition_variable advanced;
+};
@@ -0,0 +1,141 @@
+/************************************
+ * SimHardware
+ * Kinematic model of the robot behind the Hardware interface.
+ *
+ * Drive     -> left / right / back wheels follow their PWM with a first
+ *              order lag, integrated into the pose on the 400 x 400 field.
+ * Elevator  -> same lag, stopped by the limit switches at the OMS limits.
+ * Servos    -> slew towards the commanded angle, hold it when offline.
+ * Sensors   -> encoder ticks from the wheel travel, navX yaw from the
+ *              heading, sharp and ultrasonic ranges ray cast against the
+ *              field walls and the obstacles added by the scenario.
+ *
+ * Building it installs its SimClock, so every control loop, delay() and
+ * scheduler thread of the process runs on virtual time.
+ *************************************/
+
+#pragma once
+
+#include "Hardware.h"
+#include "SimClock.h"
+#include "Constants.h"
+
+#include <mutex>
+#include <vector>
+
+class SimHardware : public Hardware
+{
+    public:
+        SimHardware( double step_ms = 1 );
+        ~SimHardware();
+
+        double GetLeftEncoder() override;
+        double GetBackEncoder() override;
+        double GetRightEncoder() override;
+        double GetElevatorEncoder() override;
+        double GetYaw() override;
+        double GetAngle() override;
+        double GetCobra( int channel ) override;
+        void ResetYaw() override;
+        void ResetEncoders() override;
+        void SetGripper( double angle ) override;
+        void SetGripperOff() override;
+        void SetBase( double angle ) override;
+        void SetBaseOff() override;
+        void SetArm( double angle ) override;
+        void SetArmOff() override;
+        void SetRunningLED( bool on ) override;
+        void SetStoppedLED( bool on ) override;
+        void SetLeft( double pwm ) override;
+        void SetRight( double pwm ) override;
+        void SetBack( double pwm ) override;
+        void SetElevator( double pwm ) override;
+
+        bool GetStartButton() override;
+        bool GetStopButton() override;
+        bool GetLimitHigh() override;
+        bool GetLimitLow() override;
+
+        double GetRightSharp() override;
+        double GetLeftSharp() override;
+        double GetArmSharp() override;
+
+        double GetRightSharpVoltage() override;
+        double GetLeftSharpVoltage() override;
+        double GetArmSharpVoltage() override;
+
+        double GetRightUS() override;
+        double GetLeftUS() override;
+
+        void ReadOdometry( OdometrySample & s ) override;      // Every field on the same model step
+
+        // Scenario setup and ground truth, thread safe
+        struct Pose {
+            double x  = 0;      // [cm]
+            double y  = 0;      // [cm]
+            double th = 0;      // [degrees] counter clockwise, as Movement
+        };
+
+        void SetPose( double x, double y, double th );
+        Pose GetTruePose();
+        double GetHeight();                                         // Elevator [cm]
+        void AddObstacle( double x0, double y0, double x1, double y1 );   // Box seen by the range sensors [cm]
+        void SetStartButton( bool pressed );
+        void SetStopButton( bool pressed );
+        void SetCobra( int channel, double volts );
+
+        SimClock & GetClock(){ return clock; }
+
+        static constexpr double field_size         = constant::FIELD_SIZE;   // [cm]
+        static constexpr double max_wheel_speed    = 70;    // [cm/s] at PWM 1, Movement's max_motor_speed
+        static constexpr double wheel_lag          = 0.1;   // [s]
+        static constexpr double max_elevator_speed = 60;    // [cm/s] at PWM 1
+        static constexpr double elevator_lag       = 0.05;  // [s]
+        static constexpr double low_height         = 17.5;  // [cm] limit switches, as Oms
+        static constexpr double high_height        = 40;    // [cm]
+        static constexpr double pinion_radius      = 1.25;  // [cm]
+        static constexpr double servo_speed        = 300;   // [degrees/s]
+
+        static constexpr double sharp_min = 8,  sharp_max = 80;     // [cm]
+        static constexpr double us_min    = 2,  us_max    = 400;    // [cm]
+
+    private:
+        struct Box {
+            double x0, y0, x1, y1;
+        };
+
+        struct Servo {
+            double target = 0;
+            double angle  = 0;
+            bool online   = false;
+        };
+
+        void Step( double dt );
+        double Range( const SensorMount & m, double min, double max ) const;
+        double SharpVoltage( const SensorMount & m ) const;
+        void SetServo( Servo & s, double angle, int & commanded );
+
+        std::mutex mutex;
+
+        Pose pose;
+        double heading_total = 0;   // Unwrapped [degrees]
+        double yaw_zero = 0;        // Heading at the last ResetYaw() [degrees]
+
+        double pwm_left = 0, pwm_right = 0, pwm_back = 0, pwm_elevator = 0;
+        double speed_left = 0, speed_right = 0, speed_back = 0, speed_elevator = 0;     // [cm/s]
+        double travel_left = 0, travel_right = 0, travel_back = 0, travel_elevator = 0; // Since the last reset [cm]
+        double height = low_height;
+
+        Servo gripper, base, arm;
+
+        bool start_pressed = false;
+        bool stop_pressed  = false;
+        bool running_led   = false;
+        bool stopped_led   = false;
+        double cobra[4] = {};
+
+        std::vector<Box> obstacles;
+
+        // Last, the model above must exist before the first step
+        SimClock clock;
+};
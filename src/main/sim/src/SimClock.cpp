@@ -0,0 +1,61 @@
+/************************************
+ * SimClock
+ * Virtual time for the simulation.
+ *************************************/
+
+#include "SimClock.h"
+
+#include <algorithm>
+
+SimClock::SimClock( std::function<void( double )> step, double step_ms )
+    : step{ std::move( step ) }, step_ns{ static_cast<int64_t>( step_ms * 1e6 ) },
+      start_ns{ 1000000000LL }, start_real{ std::chrono::steady_clock::now() }{
+    // Starts at 1 s, so no stamp taken on virtual time is mistaken for "never"
+    now_ns = start_ns;
+    driver = std::this_thread::get_id();
+}
+
+void SimClock::SleepUntilNs( int64_t deadline_ns ){
+    if( std::this_thread::get_id() == driver.load() ){
+        Advance( deadline_ns );
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock( wait_mutex );
+    while( now_ns < deadline_ns ){
+        const int64_t seen = now_ns;
+        advanced.wait_for( lock, std::chrono::milliseconds( idle_timeout ) );
+
+        // The driver is blocked, possibly on this thread
+        if( now_ns == seen ){
+            lock.unlock();
+            Advance( deadline_ns );
+            lock.lock();
+        }
+    }
+}
+
+void SimClock::Advance( int64_t deadline_ns ){
+    std::lock_guard<std::mutex> lock( advance_mutex );
+
+    while( now_ns < deadline_ns ){
+        const int64_t next = std::min( now_ns + step_ns, deadline_ns );
+        step( ( next - now_ns ) * 1e-9 );
+
+        {
+            std::lock_guard<std::mutex> wait_lock( wait_mutex );
+            now_ns = next;
+        }
+        advanced.notify_all();
+
+        const double factor = real_time_factor;
+        if( factor > 0 ){
+            std::this_thread::sleep_until( start_real + std::chrono::nanoseconds( static_cast<int64_t>( ( next - start_ns ) / factor ) ) );
+        }
+    }
+}
+
+double SimClock::GetSpeedup() const {
+    const double real = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_real ).count();
+    return real > 0 ? ( now_ns - start_ns ) * 1e-9 / real : 0;
+}
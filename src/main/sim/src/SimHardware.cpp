@@ -0,0 +1,298 @@
+/************************************
+ * SimHardware
+ * Kinematic model of the robot behind the Hardware interface.
+ *************************************/
+
+#include "SimHardware.h"
+#include "Functions.h"
+
+#include <algorithm>
+#include <cmath>
+
+SimHardware::SimHardware( double step_ms ) : clock{ [this]( double dt ){ Step( dt ); }, step_ms }
+{
+    pose.x = field_size / 2;
+    pose.y = field_size / 2;
+
+    timing::SetClock( &clock );
+
+    ResetEncoders();
+    ResetYaw();
+}
+
+SimHardware::~SimHardware()
+{
+    timing::SetClock( nullptr );
+}
+
+void SimHardware::Step( double dt )
+{
+    std::lock_guard<std::mutex> lock( mutex );
+
+    // Wheels follow their PWM with a first order lag
+    const double wheel = 1 - std::exp( -dt / wheel_lag );
+    speed_left  += ( pwm_left  * max_wheel_speed - speed_left  ) * wheel;
+    speed_right += ( pwm_right * max_wheel_speed - speed_right ) * wheel;
+    speed_back  += ( pwm_back  * max_wheel_speed - speed_back  ) * wheel;
+
+    travel_left  += speed_left  * dt;
+    travel_right += speed_right * dt;
+    travel_back  += speed_back  * dt;
+
+    // Differential drive, the back wheel pushes sideways
+    const double v = ( speed_left + speed_right ) / 2;                          // [cm/s]
+    const double w = ( speed_right - speed_left ) / ( 2 * constant::FRAME_RADIUS );   // [rad/s]
+    const double th_mid = pose.th * ( M_PI / 180.0 ) + w * dt / 2;
+
+    pose.x += ( v * std::cos( th_mid ) - speed_back * std::sin( th_mid ) ) * dt;
+    pose.y += ( v * std::sin( th_mid ) + speed_back * std::cos( th_mid ) ) * dt;
+
+    const double dth = w * dt * ( 180.0 / M_PI );
+    heading_total += dth;
+    pose.th = std::fmod( pose.th + dth, 360.0 );
+    if( pose.th < 0 ){ pose.th += 360; }
+
+    // The walls stop the robot
+    pose.x = std::clamp( pose.x, constant::FRAME_RADIUS, field_size - constant::FRAME_RADIUS );
+    pose.y = std::clamp( pose.y, constant::FRAME_RADIUS, field_size - constant::FRAME_RADIUS );
+
+    // Elevator, stalled at the ends of its travel
+    speed_elevator += ( pwm_elevator * max_elevator_speed - speed_elevator ) * ( 1 - std::exp( -dt / elevator_lag ) );
+    double next_height = height + speed_elevator * dt;
+    if( next_height > high_height || next_height < low_height ){
+        next_height = std::clamp( next_height, low_height, high_height );
+        speed_elevator = 0;
+    }
+    travel_elevator += next_height - height;
+    height = next_height;
+
+    for( Servo * s : { &gripper, &base, &arm } ){
+        if( !s->online ){ continue; }
+        const double step = servo_speed * dt;
+        s->angle += std::clamp( s->target - s->angle, -step, step );
+    }
+}
+
+double SimHardware::Range( const SensorMount & m, double min, double max ) const
+{
+    const double th = pose.th * ( M_PI / 180.0 );
+    const double px = pose.x + m.x * std::cos( th ) - m.y * std::sin( th );
+    const double py = pose.y + m.x * std::sin( th ) + m.y * std::cos( th );
+    const double dx = std::cos( th + m.th * ( M_PI / 180.0 ) );
+    const double dy = std::sin( th + m.th * ( M_PI / 180.0 ) );
+
+    // Walls around the field, the sensor is inside it
+    double range = max;
+    if( dx >  1e-9 ){ range = std::min( range, ( field_size - px ) / dx ); }
+    if( dx < -1e-9 ){ range = std::min( range, -px / dx ); }
+    if( dy >  1e-9 ){ range = std::min( range, ( field_size - py ) / dy ); }
+    if( dy < -1e-9 ){ range = std::min( range, -py / dy ); }
+
+    // Slab test against every obstacle
+    for( const Box & b : obstacles ){
+        double enter = 0, leave = range;
+        auto slab = [&]( double p, double d, double lo, double hi ){
+            if( std::fabs( d ) < 1e-9 ){ return p >= lo && p <= hi; }
+            double a = ( lo - p ) / d;
+            double c = ( hi - p ) / d;
+            if( a > c ){ std::swap( a, c ); }
+            enter = std::max( enter, a );
+            leave = std::min( leave, c );
+            return enter <= leave;
+        };
+        if( slab( px, dx, b.x0, b.x1 ) && slab( py, dy, b.y0, b.y1 ) ){ range = std::min( range, enter ); }
+    }
+
+    return std::clamp( range, min, max );
+}
+
+// Inverse of sharp_function_*(), so the distance goes through the same conversion as on the robot
+double SimHardware::SharpVoltage( const SensorMount & m ) const
+{
+    return std::pow( Range( m, sharp_min, sharp_max ) / 27.726, -1 / 1.2045 );
+}
+
+void SimHardware::SetServo( Servo & s, double angle, int & commanded )
+{
+    if     ( angle > 300 ){ angle = 300; }
+    else if( angle < 0 )  { angle = 0; }
+
+    std::lock_guard<std::mutex> lock( mutex );
+    commanded = angle;
+    s.target  = angle;
+    s.online  = true;
+}
+
+void SimHardware::ResetEncoders()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    travel_left = travel_right = travel_back = travel_elevator = 0;
+}
+
+void SimHardware::ResetYaw()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    yaw_zero = heading_total;
+}
+
+void SimHardware::SetLeft( double pwm ){
+    std::lock_guard<std::mutex> lock( mutex );
+    pwm_left = pwm;
+}
+void SimHardware::SetRight( double pwm ){
+    std::lock_guard<std::mutex> lock( mutex );
+    pwm_right = pwm;
+}
+void SimHardware::SetBack( double pwm ){
+    std::lock_guard<std::mutex> lock( mutex );
+    pwm_back = pwm;
+}
+void SimHardware::SetElevator( double pwm ){
+    std::lock_guard<std::mutex> lock( mutex );
+    pwm_elevator = pwm;
+}
+
+void SimHardware::SetGripper( double angle ){ SetServo( gripper, angle, grip_ang ); }
+void SimHardware::SetBase( double angle ){ SetServo( base, angle, base_ang ); }
+void SimHardware::SetArm( double angle ){ SetServo( arm, angle, arm_ang ); }
+
+void SimHardware::SetGripperOff(){
+    std::lock_guard<std::mutex> lock( mutex );
+    gripper.online = false;
+}
+void SimHardware::SetBaseOff(){
+    std::lock_guard<std::mutex> lock( mutex );
+    base.online = false;
+}
+void SimHardware::SetArmOff(){
+    std::lock_guard<std::mutex> lock( mutex );
+    arm.online = false;
+}
+
+void SimHardware::SetRunningLED( bool on ){
+    std::lock_guard<std::mutex> lock( mutex );
+    running_led = on;
+}
+void SimHardware::SetStoppedLED( bool on ){
+    std::lock_guard<std::mutex> lock( mutex );
+    stopped_led = on;
+}
+
+double SimHardware::GetLeftEncoder(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return std::trunc( travel_left / constant::DIST_PER_TICK );
+}
+double SimHardware::GetBackEncoder(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return std::trunc( travel_back / constant::DIST_PER_TICK );
+}
+double SimHardware::GetRightEncoder(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return std::trunc( travel_right / constant::DIST_PER_TICK );
+}
+double SimHardware::GetElevatorEncoder(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return std::trunc( travel_elevator / ( 2 * M_PI * pinion_radius ) * constant::PULSE_PER_REV );
+}
+
+double SimHardware::GetYaw(){
+    return close_angle( std::fmod( GetAngle(), 360.0 ) );
+}
+double SimHardware::GetAngle(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return -( heading_total - yaw_zero );
+}
+
+void SimHardware::ReadOdometry( OdometrySample & s ){
+    std::lock_guard<std::mutex> lock( mutex );
+    s.left  = std::trunc( travel_left  / constant::DIST_PER_TICK );
+    s.right = std::trunc( travel_right / constant::DIST_PER_TICK );
+    s.back  = std::trunc( travel_back  / constant::DIST_PER_TICK );
+    s.yaw   = close_angle( std::fmod( -( heading_total - yaw_zero ), 360.0 ) );
+    s.stamp_ns = timing::NowNs();
+}
+
+double SimHardware::GetCobra( int channel ){
+    std::lock_guard<std::mutex> lock( mutex );
+    return ( channel >= 0 && channel < 4 ) ? cobra[channel] : 0;
+}
+
+bool SimHardware::GetStartButton(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return !start_pressed;
+}
+bool SimHardware::GetStopButton(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return stop_pressed;
+}
+bool SimHardware::GetLimitHigh(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return height < high_height;
+}
+bool SimHardware::GetLimitLow(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return height > low_height;
+}
+
+double SimHardware::GetRightSharp(){ return sharp_function_right( GetRightSharpVoltage() ); }
+double SimHardware::GetLeftSharp(){ return sharp_function_left( GetLeftSharpVoltage() ); }
+double SimHardware::GetArmSharp(){ return sharp_function_left( GetArmSharpVoltage() ); }
+
+double SimHardware::GetRightSharpVoltage(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return SharpVoltage( constant::SHARP_RIGHT_MOUNT );
+}
+double SimHardware::GetLeftSharpVoltage(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return SharpVoltage( constant::SHARP_LEFT_MOUNT );
+}
+double SimHardware::GetArmSharpVoltage(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return SharpVoltage( constant::SHARP_ARM_MOUNT );
+}
+
+double SimHardware::GetRightUS(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return Range( constant::US_RIGHT_MOUNT, us_min, us_max );
+}
+double SimHardware::GetLeftUS(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return Range( constant::US_LEFT_MOUNT, us_min, us_max );
+}
+
+void SimHardware::SetPose( double x, double y, double th ){
+    std::lock_guard<std::mutex> lock( mutex );
+    pose.x = x;
+    pose.y = y;
+    pose.th = th;
+    heading_total = th;
+    yaw_zero = th;      // The navX is zeroed where the robot is placed
+}
+
+SimHardware::Pose SimHardware::GetTruePose(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return pose;
+}
+
+double SimHardware::GetHeight(){
+    std::lock_guard<std::mutex> lock( mutex );
+    return height;
+}
+
+void SimHardware::AddObstacle( double x0, double y0, double x1, double y1 ){
+    std::lock_guard<std::mutex> lock( mutex );
+    obstacles.push_back( { std::min( x0, x1 ), std::min( y0, y1 ), std::max( x0, x1 ), std::max( y0, y1 ) } );
+}
+
+void SimHardware::SetStartButton( bool pressed ){
+    std::lock_guard<std::mutex> lock( mutex );
+    start_pressed = pressed;
+}
+void SimHardware::SetStopButton( bool pressed ){
+    std::lock_guard<std::mutex> lock( mutex );
+    stop_pressed = pressed;
+}
+void SimHardware::SetCobra( int channel, double volts ){
+    std::lock_guard<std::mutex> lock( mutex );
+    if( channel >= 0 && channel < 4 ){ cobra[channel] = volts; }
+}
@@ -9,6 +9,7 @@
 *************************************/
 
 #include "ManualDrive.h"
+#include "Log.h"
 
 void Drive::Execute()
 {
@@ -61,5 +62,5 @@ void Drive::Execute()
     prev_vy = vy;
     prev_vth = vth;
 
-    std::cout << "vx: " << vx << " vy: " << vy << " vth: " << vth << std::endl;
+    LOG_INFO_EVERY( 200, "vx: %g vy: %g vth: %g", vx, vy, vth );
 }   
@@ -10,69 +10,91 @@
 
 #pragma once
 
-#include <frc/smartdashboard/SmartDashboard.h>
-#include <frc/DigitalInput.h>
-#include <frc/DigitalOutput.h>
-#include <frc/AnalogInput.h>
-#include <frc/Ultrasonic.h>
+#include "Scheduler.h"
 
-#include "studica/TitanQuad.h"
-#include "studica/TitanQuadEncoder.h"
-#include "studica/Servo.h"
-#include "studica/Cobra.h"
-
-#include "Constants.h"
-#include "Functions.h"
-
-#include "AHRS.h"
-#include <math.h>
+#include <cstdint>
 
+// Wheel encoders and navX read together, for the odometry
+struct OdometrySample {
+    double left  = 0;           // Encoder ticks
+    double right = 0;
+    double back  = 0;
+    double yaw   = 0;           // As GetYaw() [degrees]
+    int64_t stamp_ns = 0;       // timing::NowNs() in the middle of the reads
+};
 
+// Every device the control code talks to. VmxHardware drives the VMX-pi,
+// SimHardware integrates a kinematic model of the robot on virtual time.
+// Encoders in ticks, angles in degrees, distances in cm, motors in PWM [-1, 1]
+// with positive values driving forward / up.
 class Hardware
 {
     public:
-        Hardware();
-        double GetLeftEncoder(void);
-        double GetBackEncoder(void);
-        double GetRightEncoder(void);
-        double GetElevatorEncoder(void);
-        double GetYaw(void);
-        double GetAngle(void);
-        double GetCobra( int channel );
-        void ResetYaw(void);
-        void ResetEncoders(void);
-        void SetGripper( double angle );
-        void SetGripperOff(  );
-        void SetBase( double angle );
-        void SetBaseOff( );
-        void SetArm( double angle );
-        void SetArmOff( );
-        void SetRunningLED(bool on);
-        void SetStoppedLED(bool on);
-        void SetLeft( double pwm );
-        void SetRight( double pwm );
-        void SetBack( double pwm );
-        void SetElevator( double pwm );
-
-        void StopActuators();
-        void ReactivateActuators();
-
-
-        bool GetStartButton();
-        bool GetStopButton();
-        bool GetLimitHigh();
-        bool GetLimitLow();
-
-        double GetRightSharp();
-        double GetLeftSharp();
-        double GetArmSharp();
-
-        double GetRightSharpVoltage();
-        double GetLeftSharpVoltage();
-        double GetArmSharpVoltage();
-
-        double GetRightUS();
-        double GetLeftUS();
+        virtual ~Hardware() = default;
+
+        virtual double GetLeftEncoder(void) = 0;
+        virtual double GetBackEncoder(void) = 0;
+        virtual double GetRightEncoder(void) = 0;
+        virtual double GetElevatorEncoder(void) = 0;
+        virtual double GetYaw(void) = 0;            // navX convention, clockwise positive [-180, 180]
+        virtual double GetAngle(void) = 0;          // Same, accumulated without wrapping
+        virtual double GetCobra( int channel ) = 0; // [V]
+        virtual void ResetYaw(void) = 0;
+        virtual void ResetEncoders(void) = 0;
+        virtual void SetGripper( double angle ) = 0;
+        virtual void SetGripperOff(  ) = 0;
+        virtual void SetBase( double angle ) = 0;
+        virtual void SetBaseOff( ) = 0;
+        virtual void SetArm( double angle ) = 0;
+        virtual void SetArmOff( ) = 0;
+        virtual void SetRunningLED(bool on) = 0;
+        virtual void SetStoppedLED(bool on) = 0;
+        virtual void SetLeft( double pwm ) = 0;
+        virtual void SetRight( double pwm ) = 0;
+        virtual void SetBack( double pwm ) = 0;
+        virtual void SetElevator( double pwm ) = 0;
+
+        // One batch of the odometry inputs. The default reads them one by one, a backend
+        // that can sample them at the same instant overrides it.
+        virtual void ReadOdometry( OdometrySample & s ){
+            const int64_t start_ns = timing::NowNs();
+            s.left  = GetLeftEncoder();
+            s.right = GetRightEncoder();
+            s.back  = GetBackEncoder();
+            s.yaw   = GetYaw();
+            s.stamp_ns = start_ns + ( timing::NowNs() - start_ns ) / 2;
+        }
+
+        void StopActuators(){
+            SetElevator( 0 );
+            SetLeft ( 0 );
+            SetRight( 0 );
+            SetGripperOff( );
+            SetBaseOff( );
+            SetArmOff( );
+        }
+        void ReactivateActuators(){
+            SetGripper( grip_ang );
+            SetBase( base_ang );
+            SetArm( arm_ang );
+        }
+
+        // Raw digital inputs, the polarity differs between them
+        virtual bool GetStartButton() = 0;          // false while pressed
+        virtual bool GetStopButton() = 0;           // true while pressed, callers stop the motors on true
+        virtual bool GetLimitHigh() = 0;            // false while pressed, at the top of the elevator
+        virtual bool GetLimitLow() = 0;             // false while pressed, at the bottom of the elevator
+
+        virtual double GetRightSharp() = 0;
+        virtual double GetLeftSharp() = 0;
+        virtual double GetArmSharp() = 0;
+
+        virtual double GetRightSharpVoltage() = 0;
+        virtual double GetLeftSharpVoltage() = 0;
+        virtual double GetArmSharpVoltage() = 0;
+
+        virtual double GetRightUS() = 0;
+        virtual double GetLeftUS() = 0;
 
 
 
@@ -80,45 +102,4 @@ class Hardware
         int grip_ang = 0;
         int base_ang = 150;
 
-
-
-    private:
-        studica::TitanQuad LeftMotor     {constant::TITAN_ID, 15600, constant::LEFT_MOTOR    };
-        studica::TitanQuad BackMotor     {constant::TITAN_ID, 15600, constant::BACK_MOTOR    };
-        studica::TitanQuad RightMotor    {constant::TITAN_ID, 15600, constant::RIGHT_MOTOR   };
-        studica::TitanQuad ElevatorMotor {constant::TITAN_ID, 15600, constant::ELEVATOR_MOTOR};
-
-        studica::TitanQuadEncoder LeftEncoder     {LeftMotor,     constant::LEFT_MOTOR,     constant::DIST_PER_TICK};
-        studica::TitanQuadEncoder BackEncoder     {BackMotor,     constant::BACK_MOTOR,     constant::DIST_PER_TICK};
-        studica::TitanQuadEncoder RightEncoder    {RightMotor,    constant::RIGHT_MOTOR,    constant::DIST_PER_TICK};
-        studica::TitanQuadEncoder ElevatorEncoder {ElevatorMotor, constant::ELEVATOR_MOTOR, constant::DIST_PER_TICK};
-
-        studica::Servo servo_gripper{4};
-        studica::Servo servo_base{5}; 
-        studica::Servo servo_arm{6}; 
-
-
-        AHRS navX{frc::SPI::Port::kMXP};
-
-        frc::DigitalInput startButton{constant::START_BUTTON};
-        frc::DigitalInput stopButton {constant::STOP_BUTTON };
-        frc::DigitalInput switchHigh {constant::LIMIT_HIGH  };
-        frc::DigitalInput switchLow  {constant::LIMIT_LOW   };
-
-        frc::DigitalOutput runningLED{constant::RUNNING_LED};
-        frc::DigitalOutput stoppedLED{constant::STOPPED_LED};
-
-        studica::Cobra cobra{};
-
-        frc::AnalogInput sharp_right{constant::SHARP_RIGHT};
-        frc::AnalogInput sharp_left {constant::SHARP_LEFT };
-        frc::AnalogInput sharp_arm  {constant::SHARP_ARM  };
-
-        frc::Ultrasonic us_l{ constant::US_LEFT_TRIG,  constant::US_LEFT_ECHO  };
-        frc::Ultrasonic us_r{ constant::US_RIGHT_TRIG, constant::US_RIGHT_ECHO }; 
-
-
-
-
-};
-
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+/************************************
+ * Author: Felipe Ferreira
+ * Release version: 1.0.0.0
+ * 
+ * Modified by: 
+ * Last modification date: 
+ * New version:
+
+*************************************/
+
+#pragma once
+
+#include "Hardware.h"
+
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <frc/DigitalInput.h>
+#include <frc/DigitalOutput.h>
+#include <frc/AnalogInput.h>
+#include <frc/Ultrasonic.h>
+
+#include "studica/TitanQuad.h"
+#include "studica/TitanQuadEncoder.h"
+#include "studica/Servo.h"
+#include "studica/Cobra.h"
+
+#include "Constants.h"
+#include "Functions.h"
+
+#include "AHRS.h"
+#include <math.h>
+
+
+class VmxHardware : public Hardware
+{
+    public:
+        VmxHardware();
+
+        double GetLeftEncoder() override;
+        double GetBackEncoder() override;
+        double GetRightEncoder() override;
+        double GetElevatorEncoder() override;
+        double GetYaw() override;
+        double GetAngle() override;
+        double GetCobra( int channel ) override;
+        void ResetYaw() override;
+        void ResetEncoders() override;
+        void SetGripper( double angle ) override;
+        void SetGripperOff() override;
+        void SetBase( double angle ) override;
+        void SetBaseOff() override;
+        void SetArm( double angle ) override;
+        void SetArmOff() override;
+        void SetRunningLED( bool on ) override;
+        void SetStoppedLED( bool on ) override;
+        void SetLeft( double pwm ) override;
+        void SetRight( double pwm ) override;
+        void SetBack( double pwm ) override;
+        void SetElevator( double pwm ) override;
+
+        bool GetStartButton() override;
+        bool GetStopButton() override;
+        bool GetLimitHigh() override;
+        bool GetLimitLow() override;
+
+        double GetRightSharp() override;
+        double GetLeftSharp() override;
+        double GetArmSharp() override;
+
+        double GetRightSharpVoltage() override;
+        double GetLeftSharpVoltage() override;
+        double GetArmSharpVoltage() override;
+
+        double GetRightUS() override;
+        double GetLeftUS() override;
+
+    private:
+        studica::TitanQuad LeftMotor     {constant::TITAN_ID, 15600, constant::LEFT_MOTOR    };
+        studica::TitanQuad BackMotor     {constant::TITAN_ID, 15600, constant::BACK_MOTOR    };
+        studica::TitanQuad RightMotor    {constant::TITAN_ID, 15600, constant::RIGHT_MOTOR   };
+        studica::TitanQuad ElevatorMotor {constant::TITAN_ID, 15600, constant::ELEVATOR_MOTOR};
+
+        studica::TitanQuadEncoder LeftEncoder     {LeftMotor,     constant::LEFT_MOTOR,     constant::DIST_PER_TICK};
+        studica::TitanQuadEncoder BackEncoder     {BackMotor,     constant::BACK_MOTOR,     constant::DIST_PER_TICK};
+        studica::TitanQuadEncoder RightEncoder    {RightMotor,    constant::RIGHT_MOTOR,    constant::DIST_PER_TICK};
+        studica::TitanQuadEncoder ElevatorEncoder {ElevatorMotor, constant::ELEVATOR_MOTOR, constant::DIST_PER_TICK};
+
+        studica::Servo servo_gripper{4};
+        studica::Servo servo_base{5}; 
+        studica::Servo servo_arm{6}; 
+
+
+        AHRS navX{frc::SPI::Port::kMXP};
+
+        frc::DigitalInput startButton{constant::START_BUTTON};
+        frc::DigitalInput stopButton {constant::STOP_BUTTON };
+        frc::DigitalInput switchHigh {constant::LIMIT_HIGH  };
+        frc::DigitalInput switchLow  {constant::LIMIT_LOW   };
+
+        frc::DigitalOutput runningLED{constant::RUNNING_LED};
+        frc::DigitalOutput stoppedLED{constant::STOPPED_LED};
+
+        studica::Cobra cobra{};
+
+        frc::AnalogInput sharp_right{constant::SHARP_RIGHT};
+        frc::AnalogInput sharp_left {constant::SHARP_LEFT };
+        frc::AnalogInput sharp_arm  {constant::SHARP_ARM  };
+
+        frc::Ultrasonic us_l{ constant::US_LEFT_TRIG,  constant::US_LEFT_ECHO  };
+        frc::Ultrasonic us_r{ constant::US_RIGHT_TRIG, constant::US_RIGHT_ECHO }; 
+
+
+
+
+};
+
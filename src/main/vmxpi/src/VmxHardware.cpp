@@ -8,17 +8,17 @@
 
 *************************************/
 
-#include "Hardware.h"
+#include "VmxHardware.h"
 
 #define DEBUG true
 
-Hardware::Hardware()
+VmxHardware::VmxHardware()
 {
     ResetEncoders();
     ResetYaw();
 }
 
-void Hardware::ResetEncoders()
+void VmxHardware::ResetEncoders()
 {
     LeftEncoder.Reset();
     BackEncoder.Reset();
@@ -26,28 +26,28 @@ void Hardware::ResetEncoders()
     ElevatorEncoder.Reset();
 }
 
-void Hardware::ResetYaw()
+void VmxHardware::ResetYaw()
 {
     navX.ZeroYaw();
 }
-void Hardware::SetLeft( double pwm ){
+void VmxHardware::SetLeft( double pwm ){
     if( pwm == 0 ){ LeftMotor.StopMotor();}
     else{ LeftMotor.Set( pwm ); }
 }
-void Hardware::SetRight( double pwm ){
+void VmxHardware::SetRight( double pwm ){
     if( pwm == 0 ){ RightMotor.StopMotor();}
     else{ RightMotor.Set( -pwm ); }
 }
-void Hardware::SetBack( double pwm ){
+void VmxHardware::SetBack( double pwm ){
     if( pwm == 0 ){ BackMotor.StopMotor();}
     else{ BackMotor.Set( pwm ); }
 }
-void Hardware::SetElevator( double pwm ){
+void VmxHardware::SetElevator( double pwm ){
     if( pwm == 0 ){ ElevatorMotor.StopMotor();}
     else{ ElevatorMotor.Set( -pwm ); }
 }
 
-void Hardware::SetGripper( double angle ){
+void VmxHardware::SetGripper( double angle ){
 
     if     ( angle > 300 ){ angle = 300; }
     else if( angle < 0 )  { angle = 0; }
@@ -55,10 +55,10 @@ void Hardware::SetGripper( double angle ){
     grip_ang = angle;
     servo_gripper.SetAngle( angle );
 }
-void Hardware::SetGripperOff(  ){
+void VmxHardware::SetGripperOff(  ){
     servo_gripper.SetOffline( );
 }
-void Hardware::SetBase( double angle ){
+void VmxHardware::SetBase( double angle ){
 
     if     ( angle > 300 ){ angle = 300; }
     else if( angle < 0 )  { angle = 0; }
@@ -66,10 +66,10 @@ void Hardware::SetBase( double angle ){
     base_ang = angle;
     servo_base.SetAngle( angle );
 }
-void Hardware::SetBaseOff( ){
+void VmxHardware::SetBaseOff( ){
     servo_base.SetOffline( );
 }
-void Hardware::SetArm( double angle ){
+void VmxHardware::SetArm( double angle ){
 
     if     ( angle > 300 ){ angle = 300; }
     else if( angle < 0 )  { angle = 0; }
@@ -77,108 +77,92 @@ void Hardware::SetArm( double angle ){
     arm_ang = angle;
     servo_arm.SetAngle( angle );
 }
-void Hardware::SetArmOff( ){
+void VmxHardware::SetArmOff( ){
     servo_arm.SetOffline( );
 }
 
-void Hardware::SetRunningLED(bool on)
+void VmxHardware::SetRunningLED(bool on)
 {
     runningLED.Set(on);
 }
 
-void Hardware::SetStoppedLED(bool on)
+void VmxHardware::SetStoppedLED(bool on)
 {
     stoppedLED.Set(on);
 }
 
-double Hardware::GetLeftEncoder()
+double VmxHardware::GetLeftEncoder()
 {
     return LeftEncoder.GetRaw();
 }
 
-double Hardware::GetBackEncoder()
+double VmxHardware::GetBackEncoder()
 {
     return BackEncoder.GetRaw();
 }
 
-double Hardware::GetRightEncoder()
+double VmxHardware::GetRightEncoder()
 {
     return -RightEncoder.GetRaw();
 }
 
-double Hardware::GetElevatorEncoder()
+double VmxHardware::GetElevatorEncoder()
 {
     return -ElevatorEncoder.GetRaw();
 }
 
-double Hardware::GetYaw()
+double VmxHardware::GetYaw()
 {
     return navX.GetYaw();
 }
 
-double Hardware::GetAngle()
+double VmxHardware::GetAngle()
 {
     return navX.GetAngle();
 }
 
-bool Hardware::GetStopButton(){
+bool VmxHardware::GetStopButton(){
     return stopButton.Get();
 }
-bool Hardware::GetStartButton(){
+bool VmxHardware::GetStartButton(){
     return startButton.Get();
 }
 
-bool Hardware::GetLimitHigh(){
+bool VmxHardware::GetLimitHigh(){
     return switchHigh.Get();
 }
-bool Hardware::GetLimitLow(){
+bool VmxHardware::GetLimitLow(){
     return switchLow.Get();
 }
 
-double Hardware::GetCobra( int channel ){
+double VmxHardware::GetCobra( int channel ){
     return cobra.GetVoltage(channel);
 }
 
-double Hardware::GetRightSharp(){
+double VmxHardware::GetRightSharp(){
     return sharp_function_right( sharp_right.GetVoltage() );
 }
-double Hardware::GetRightSharpVoltage(){
+double VmxHardware::GetRightSharpVoltage(){
     return sharp_right.GetVoltage();
 }
-double Hardware::GetLeftSharp(){
+double VmxHardware::GetLeftSharp(){
     return sharp_function_left( sharp_left.GetVoltage() );
 }
-double Hardware::GetLeftSharpVoltage(){
+double VmxHardware::GetLeftSharpVoltage(){
     return sharp_left.GetVoltage();
 }
-double Hardware::GetArmSharp(){
+double VmxHardware::GetArmSharp(){
     return sharp_function_left( sharp_arm.GetVoltage() );
 }
-double Hardware::GetArmSharpVoltage(){
+double VmxHardware::GetArmSharpVoltage(){
     return sharp_arm.GetVoltage();
 }
 
-double Hardware::GetRightUS(){
+double VmxHardware::GetRightUS(){
     us_r.Ping();
     return us_r.GetRangeMM() / 10.0;
 }
-double Hardware::GetLeftUS(){
+double VmxHardware::GetLeftUS(){
     us_l.Ping();
     return us_l.GetRangeMM() / 10.0;
-}
-
-void Hardware::StopActuators(){
-    
-    SetElevator( 0 );
-    SetLeft ( 0 );
-    SetRight( 0 );
-    SetGripperOff( );
-    SetBaseOff( );
-    SetArmOff( );
-}
-
-void Hardware::ReactivateActuators(){
-    SetGripper( grip_ang );
-    SetBase( base_ang );
-    SetArm( arm_ang );
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+/************************************
+ * Simulated missions
+ * Drives the FieldLayout tour with Movement::PositionDriver and cycles the
+ * elevator with Oms::oms_driver on SimHardware, on virtual time. Reports
+ * the odometry error against the model's true pose, the elevator error and
+ * how many times faster than real time it ran, then the loop timing table.
+ * A block in the middle of the field is seen by the range sensors and must
+ * be gated out by the pose filter.
+ *
+ *   ./sim_missions [missions] [fusion 0/1]
+ *
+ * Build (desktop): ./gradlew frcSimulationExecutable -Psimulation, or with the WPILib
+ * desktop headers and libraries, every source of core (Scheduler, LoopMetrics,
+ * Log, Telemetry, Functions), base_controller, oms, sensors/sensors.cpp,
+ * navigation/Trajectory.cpp and sim, plus this file.
+ *************************************/
+
+#include "SimHardware.h"
+#include "Movement.h"
+#include "Sensors.h"
+#include "Oms.h"
+#include "FieldLayout.h"
+#include "LoopMetrics.h"
+#include "Log.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+int main( int argc, char ** argv ){
+    const int missions = argc > 1 ? std::atoi( argv[1] ) : 10;
+    const bool fusion  = argc > 2 ? std::atoi( argv[2] ) != 0 : true;
+
+    SimHardware hard;
+    Sensor sensor( &hard );
+    Movement movement( &hard, &sensor );
+    Oms oms( &hard );
+
+    hard.AddObstacle( 150, 150, 250, 250 );
+
+    // No odometry thread: on free running virtual time it would fall behind the
+    // driver, RobotPosition() steps the odometry inline instead
+    sensor.StartAcquisition();
+
+    // Around the outer ring of the field and back to the start
+    const field::Waypoint tour[] = { field::A, field::C, field::D, field::E, field::F, field::A };
+
+    const field::Node & start = field::layout.GetNode( tour[0] );
+    hard.SetPose( start.x, start.y, 90 );
+    movement.SetPosition( start.x, start.y, 90 );
+    movement.SetFusion( fusion );
+
+    double worst_pose = 0;
+    double worst_height = 0;
+    int legs = 0;
+
+    for( int m = 0; m < missions; m++ ){
+        for( size_t i = 1; i < sizeof( tour ) / sizeof( tour[0] ); i++ ){
+            field::Route<field::WAYPOINT_COUNT> route = field::layout.GetRoute( tour[i - 1], tour[i] );
+            for( int n = 1; n < route.count; n++ ){
+                const field::Node & p = field::layout.GetNode( route.node[n] );
+                movement.PositionDriver( p.x, p.y, p.th );
+                legs++;
+
+                SimHardware::Pose truth = hard.GetTruePose();
+                double error = std::hypot( truth.x - movement.get_x(), truth.y - movement.get_y() );
+                worst_pose = std::max( worst_pose, error );
+            }
+        }
+
+        oms.reset( -1 );
+        oms.oms_driver( 30, 0 );
+        worst_height = std::max( worst_height, std::fabs( hard.GetHeight() - 30 ) );
+        oms.reset( 1 );
+    }
+
+    sensor.StopAcquisition();
+
+    SimHardware::Pose truth = hard.GetTruePose();
+    std::printf( "%d missions, %d legs, %.0f s of robot time\n", missions, legs, timing::NowNs() * 1e-9 - 1 );
+    std::printf( "  final pose      : x %.1f y %.1f th %.1f (odometry x %.1f y %.1f th %.1f)\n",
+                 truth.x, truth.y, truth.th, movement.get_x(), movement.get_y(), movement.get_th() );
+    std::printf( "  worst odometry  : %.2f cm\n", worst_pose );
+    std::printf( "  pose filter     : %s, %u ranges fused, sigma %.2f cm %.2f deg\n", fusion ? "fusing" : "odometry only",
+                 movement.GetPose().fused, movement.GetPose().sigma_xy, movement.GetPose().sigma_th );
+    std::printf( "  worst elevator  : %.2f cm\n", worst_height );
+    std::printf( "  speedup         : %.0f x real time\n", hard.GetClock().GetSpeedup() );
+
+    // Work time is real time, the lateness is virtual and only shows the simulated delays
+    std::fflush( stdout );
+    metrics::Dump();
+    logging::Flush();
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+/************************************
+ * HsvThreshold tests
+ * The fused labels of HsvThresholdKernel must match what Camera used to
+ * compute with OpenCV (cvtColor COLOR_BGR2HSV, an inRange per range and a
+ * bitwise_or per object) pixel for pixel.
+ *
+ * Frames are the png / jpg in src/test/frames, or in $HSV_TEST_FRAMES to
+ * check a set of recordings from the robot camera.
+ *************************************/
+
+#include "HsvThreshold.h"
+
+#include <opencv2/opencv.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct TestObject {
+        const char * name;
+        HsvRange range[2];
+        bool second;
+    };
+
+    // Camera.h's objects, the purple grape wraps around the end of the hue circle
+    const TestObject test_objects[] = {
+        { "grape_yellow", { { {  16,  25,  25 }, {  27, 255, 255 } } },                                      false },
+        { "grape_green",  { { {  30,  25,  25 }, {  69, 255, 255 } } },                                      false },
+        { "grape_purple", { { {   0,  50,   0 }, {  10, 255, 100 } }, { { 165, 25, 0 }, { 180, 255, 100 } } }, true  },
+        { "banana",       { { {  20, 100, 100 }, {  40, 255, 255 } } },                                      false },
+        { "lemon",        { { {  40, 100,   0 }, {  75, 255, 100 } } },                                      false },
+    };
+    constexpr int object_count = sizeof( test_objects ) / sizeof( test_objects[0] );
+
+    cv::Scalar Lower( const HsvRange & r ){ return cv::Scalar( r.lower[0], r.lower[1], r.lower[2] ); }
+    cv::Scalar Upper( const HsvRange & r ){ return cv::Scalar( r.upper[0], r.upper[1], r.upper[2] ); }
+
+    std::vector<cv::Mat> LoadFrames(){
+        const char * env = std::getenv( "HSV_TEST_FRAMES" );
+        const std::string dir = env ? env : TEST_FRAMES_DIR;
+
+        std::vector<cv::Mat> frames;
+        for( const char * pattern : { "/*.png", "/*.jpg" } ){
+            std::vector<cv::String> files;
+            cv::glob( dir + pattern, files, false );
+            for( const cv::String & f : files ){
+                cv::Mat image = cv::imread( f, cv::IMREAD_COLOR );
+                if( !image.empty() ){ frames.push_back( image ); }
+            }
+        }
+        return frames;
+    }
+
+    cv::Mat Label( const HsvThresholdKernel & kernel, const cv::Mat & bgr ){
+        cv::Mat labels( bgr.rows, bgr.cols, CV_8UC1 );
+        kernel.Label( bgr.ptr<uint8_t>(), static_cast<int>( bgr.step ), labels.ptr<uint8_t>(),
+                      static_cast<int>( labels.step ), bgr.cols, bgr.rows );
+        return labels;
+    }
+
+    // Pixels where bit k of the labels differs from the OpenCV mask of object k
+    int Mismatches( const cv::Mat & labels, const cv::Mat & hsv, int k ){
+        const TestObject & obj = test_objects[k];
+
+        cv::Mat expected, second;
+        cv::inRange( hsv, Lower( obj.range[0] ), Upper( obj.range[0] ), expected );
+        if( obj.second ){
+            cv::inRange( hsv, Lower( obj.range[1] ), Upper( obj.range[1] ), second );
+            cv::bitwise_or( expected, second, expected );
+        }
+
+        cv::Mat fused;
+        cv::bitwise_and( labels, cv::Scalar( 1 << k ), fused );
+        cv::compare( fused, 0, fused, cv::CMP_NE );
+        return cv::countNonZero( fused != expected );
+    }
+
+    HsvThresholdKernel MakeKernel(){
+        HsvThresholdKernel kernel;
+        for( int k = 0; k < object_count; k++ ){
+            kernel.AddRange( k, test_objects[k].range[0] );
+            if( test_objects[k].second ){ kernel.AddRange( k, test_objects[k].range[1] ); }
+        }
+        return kernel;
+    }
+
+}
+
+TEST( HsvThreshold, MatchesOpenCvOnStoredFrames ){
+    const std::vector<cv::Mat> frames = LoadFrames();
+    ASSERT_FALSE( frames.empty() ) << "no frames in " << TEST_FRAMES_DIR;
+
+    const HsvThresholdKernel kernel = MakeKernel();
+
+    cv::Mat hsv;
+    for( size_t f = 0; f < frames.size(); f++ ){
+        cv::cvtColor( frames[f], hsv, cv::COLOR_BGR2HSV );
+        const cv::Mat labels = Label( kernel, frames[f] );
+        for( int k = 0; k < object_count; k++ ){
+            EXPECT_EQ( Mismatches( labels, hsv, k ), 0 ) << "frame " << f << ", " << test_objects[k].name;
+        }
+    }
+}
+
+// Every 8 bit BGR color once, the conversion must be bit exact with cvtColor
+TEST( HsvThreshold, MatchesCvtColorOnEveryColor ){
+    cv::Mat cube( 4096, 4096, CV_8UC3 );
+    for( int i = 0; i < 256 * 256 * 256; i++ ){
+        uint8_t * p = cube.ptr<uint8_t>( i / 4096 ) + ( i % 4096 ) * 3;
+        p[0] = static_cast<uint8_t>( i );
+        p[1] = static_cast<uint8_t>( i >> 8 );
+        p[2] = static_cast<uint8_t>( i >> 16 );
+    }
+
+    cv::Mat hsv;
+    cv::cvtColor( cube, hsv, cv::COLOR_BGR2HSV );
+
+    int wrong = 0;
+    for( int y = 0; y < cube.rows && wrong < 10; y++ ){
+        const uint8_t * bgr = cube.ptr<uint8_t>( y );
+        const uint8_t * ref = hsv.ptr<uint8_t>( y );
+        for( int x = 0; x < cube.cols && wrong < 10; x++ ){
+            uint8_t h, s, v;
+            HsvThresholdKernel::BgrToHsv( bgr[3 * x], bgr[3 * x + 1], bgr[3 * x + 2], h, s, v );
+            if( h != ref[3 * x] || s != ref[3 * x + 1] || v != ref[3 * x + 2] ){
+                ADD_FAILURE() << "BGR " << +bgr[3 * x] << " " << +bgr[3 * x + 1] << " " << +bgr[3 * x + 2]
+                              << ": HSV " << +h << " " << +s << " " << +v
+                              << ", cvtColor " << +ref[3 * x] << " " << +ref[3 * x + 1] << " " << +ref[3 * x + 2];
+                wrong++;
+            }
+        }
+    }
+
+    const cv::Mat labels = Label( MakeKernel(), cube );
+    for( int k = 0; k < object_count; k++ ){
+        EXPECT_EQ( Mismatches( labels, hsv, k ), 0 ) << test_objects[k].name;
+    }
+}
+
+// Red to purple across H = 180 -> 0: both halves of the range set the same bit, nothing else does
+TEST( HsvThreshold, HueWrapRange ){
+    const int purple = 2;
+    HsvThresholdKernel kernel;
+    kernel.AddRange( purple, test_objects[purple].range[0] );
+    kernel.AddRange( purple, test_objects[purple].range[1] );
+
+    // One pixel per hue at S 255, V 90, then the same hues too bright for the range
+    cv::Mat hsv( 2, 180, CV_8UC3 );
+    for( int h = 0; h < 180; h++ ){
+        hsv.at<cv::Vec3b>( 0, h ) = cv::Vec3b( h, 255, 90 );
+        hsv.at<cv::Vec3b>( 1, h ) = cv::Vec3b( h, 255, 200 );
+    }
+    cv::Mat bgr;
+    cv::cvtColor( hsv, bgr, cv::COLOR_HSV2BGR );
+    cv::cvtColor( bgr, hsv, cv::COLOR_BGR2HSV );      // Hues as the camera path sees them
+
+    const cv::Mat labels = Label( kernel, bgr );
+
+    int low = 0, high = 0;
+    for( int x = 0; x < labels.cols; x++ ){
+        const int h = hsv.at<cv::Vec3b>( 0, x )[0];
+        const bool inside = h <= 10 || h >= 165;
+        EXPECT_EQ( labels.at<uint8_t>( 0, x ) == 1 << purple, inside ) << "H " << h;
+        EXPECT_EQ( labels.at<uint8_t>( 1, x ), 0 ) << "H " << h << " at V 200";
+        if( inside ){ ( h <= 10 ? low : high )++; }
+    }
+    EXPECT_GT( low, 0 );
+    EXPECT_GT( high, 0 );
+    EXPECT_EQ( Mismatches( labels, hsv, purple ), 0 );
+}